@@ -0,0 +1,470 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Batch decoder: decodes several frames over the same code in lockstep, one frame per
+SIMD lane. The kernels are written once with GCC vector extensions, templated on the
+lane count, and inlined into one wrapper each for AVX-512 (8 lanes), AVX2 (4 lanes)
+and plain SSE2 (2 lanes). The sum-product rule uses the polynomial tanh and log of
+lane_math.h, like check_node_update_simd.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "batch_decoder.h"
+#include "simd_kernels.h"
+#include "lane_math.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BATCH_DECODER_X86
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx2,avx512f")))
+#endif
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+using namespace std;
+
+
+/**
+ * @brief vector types holding the same message of W frames (W lanes), W is the
+ * native width of the instruction set the kernels are inlined into
+ */
+template<int W>
+struct Lanes {
+    typedef double d __attribute__((vector_size(8 * W)));
+    typedef int64_t i __attribute__((vector_size(8 * W)));
+    // the same, but only 8 byte aligned so that any lane offset of a std::vector can be accessed
+    typedef d d_mem __attribute__((aligned(8)));
+    typedef i i_mem __attribute__((aligned(8)));
+};
+
+#define LOAD_D(p) (*reinterpret_cast<const typename Lanes<W>::d_mem *>(p))
+#define LOAD_I(p) (*reinterpret_cast<const typename Lanes<W>::i_mem *>(p))
+#define STORE_D(p, v) (*reinterpret_cast<typename Lanes<W>::d_mem *>(p) = (v))
+#define STORE_I(p, v) (*reinterpret_cast<typename Lanes<W>::i_mem *>(p) = (v))
+
+
+/**
+ * @brief allocates a batch decoder workspace
+ * @param code the LDPC code
+ * @param batch_size number of frames decoded together, rounded up to a multiple of batch_block_size
+ * @return the workspace
+ */
+BatchDecoderWorkspace make_batch_decoder_workspace(const LdpcCode &code, size_t batch_size) {
+    if (batch_size == 0) {
+        throw runtime_error("batch size must be positive.");
+    }
+    batch_size = (batch_size + batch_block_size - 1) / batch_block_size * batch_block_size;
+
+    BatchDecoderWorkspace ws;
+    ws.batch_size = batch_size;
+    ws.msg_v.resize(code.graph.n_edges() * batch_size);
+    ws.msg_c.resize(code.graph.n_edges() * batch_size);
+    ws.llrs.resize(static_cast<size_t>(code.n_cols) * batch_size);
+    ws.syndrome.resize(static_cast<size_t>(code.n_rows) * batch_size);
+    ws.decision.resize(static_cast<size_t>(code.n_cols) * batch_size);
+    ws.unsatisfied.resize(batch_size);
+    ws.diverged.resize(batch_size);
+    ws.done.resize(batch_size);
+    uint32_t max_check_degree = 0;
+    for (size_t m = 0; m < code.graph.n_rows; ++m) {
+        max_check_degree = max(max_check_degree, code.graph.check_offsets[m + 1] - code.graph.check_offsets[m]);
+    }
+    ws.check_scratch.resize(static_cast<size_t>(max_check_degree) * batch_block_size);
+    ws.active_blocks.reserve(batch_size / batch_block_size);
+    return ws;
+}
+
+
+/**
+ * @brief clamps a block of messages to +/- vsat, same semantics as saturate()
+ */
+#define SATURATE_BLOCK(v, vsat) do { \
+        (v) = (v) > (vsat) ? (vsat) : (v); \
+        (v) = (v) < -(vsat) ? -(vsat) : (v); \
+    } while (false)
+
+
+/**
+ * @brief min-sum check node update for all active blocks, including saturation
+ */
+template<int W>
+static ALWAYS_INLINE void batch_check_node_min_sum(const TannerGraph &graph,
+                                                   BatchDecoderWorkspace &ws,
+                                                   const double scale,
+                                                   const double offset,
+                                                   const double vsat) {
+    typedef typename Lanes<W>::d block_d;
+    typedef typename Lanes<W>::i block_i;
+    const size_t B = ws.batch_size;
+    const double *msg_v = ws.msg_v.data();
+    double *msg_c = ws.msg_c.data();
+    const block_i sign_bit = block_i{} + INT64_MIN;
+    const block_d inf = block_d{} + HUGE_VAL;
+    const block_d zero = block_d{};
+    const block_d sat = block_d{} + vsat;
+    alignas(64) double min1[W], min2[W], out1[W], out2[W];
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
+        for (const uint32_t b : ws.active_blocks) {
+            for (size_t lane0 = b * batch_block_size; lane0 < (b + 1) * batch_block_size; lane0 += W) {
+                // per lane (= per frame) two smallest magnitudes and sign parity
+                block_d vmin1 = inf;
+                block_d vmin2 = inf;
+                block_i parity = LOAD_I(&ws.syndrome[m * B + lane0]);
+                for (uint32_t e = begin; e < end; ++e) {
+                    const block_d x = LOAD_D(msg_v + e * B + lane0);
+                    const block_d mag = reinterpret_cast<block_d>(reinterpret_cast<block_i>(x) & ~sign_bit);
+                    parity ^= x < zero;
+                    const block_d upper = vmin1 > mag ? vmin1 : mag;
+                    vmin2 = upper < vmin2 ? upper : vmin2;
+                    vmin1 = mag < vmin1 ? mag : vmin1;
+                }
+
+                *reinterpret_cast<block_d *>(min1) = vmin1;
+                *reinterpret_cast<block_d *>(min2) = vmin2;
+                for (int i = 0; i < W; ++i) {
+                    out1[i] = min_sum_magnitude(min1[i], scale, offset);
+                    out2[i] = min_sum_magnitude(min2[i], scale, offset);
+                }
+                const block_d vout1 = *reinterpret_cast<const block_d *>(out1);
+                const block_d vout2 = *reinterpret_cast<const block_d *>(out2);
+
+                for (uint32_t e = begin; e < end; ++e) {
+                    const block_d x = LOAD_D(msg_v + e * B + lane0);
+                    const block_d mag = reinterpret_cast<block_d>(reinterpret_cast<block_i>(x) & ~sign_bit);
+                    const block_d sel = mag == vmin1 ? vout2 : vout1;
+                    block_d res = ((x < zero) ^ parity) ? -sel : sel;
+                    SATURATE_BLOCK(res, sat);
+                    STORE_D(msg_c + graph.check_to_var_edge[e] * B + lane0, res);
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief sum-product check node update for all active blocks, including saturation,
+ * with the polynomial tanh and log of check_node_update_simd
+ */
+template<int W>
+static ALWAYS_INLINE void batch_check_node_sum_product(const TannerGraph &graph,
+                                                       BatchDecoderWorkspace &ws,
+                                                       const double vsat) {
+    typedef typename Lanes<W>::d block_d;
+    typedef typename Lanes<W>::i block_i;
+    const size_t B = ws.batch_size;
+    const double *msg_v = ws.msg_v.data();
+    double *msg_c = ws.msg_c.data();
+    double *scratch = ws.check_scratch.data();
+    const block_d zero = block_d{};
+    const block_d one = block_d{} + 1.;
+    const block_d sat = block_d{} + vsat;
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t deg = graph.check_offsets[m + 1] - begin;
+        // same convention as check_node_update for zero messages
+        const block_d zero_msg_part = block_d{} + (deg > 1 ? 0. : 1.);
+
+        for (const uint32_t b : ws.active_blocks) {
+            for (size_t lane0 = b * batch_block_size; lane0 < (b + 1) * batch_block_size; lane0 += W) {
+                // tanh of every incoming message, kept in scratch for the second pass
+                block_d prod = LOAD_I(&ws.syndrome[m * B + lane0]) != 0 ? -one : one;
+                for (uint32_t k = 0; k < deg; ++k) {
+                    const block_d x = LOAD_D(msg_v + (begin + k) * B + lane0);
+                    block_d t;
+                    lanes_tanh_half<block_d, block_i>(x, t);
+                    STORE_D(scratch + k * W, t);
+                    prod *= t;
+                }
+
+                for (uint32_t k = 0; k < deg; ++k) {
+                    const block_d x = LOAD_D(msg_v + (begin + k) * B + lane0);
+                    const block_d msg_part = x == zero ? zero_msg_part : prod / LOAD_D(scratch + k * W);
+                    block_d res;
+                    lanes_log<block_d, block_i>((one + msg_part) / (one - msg_part), res);
+                    SATURATE_BLOCK(res, sat);
+                    STORE_D(msg_c + graph.check_to_var_edge[begin + k] * B + lane0, res);
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief variable node update and hard decision for all active blocks, including
+ * saturation and the NaN check of the variable messages
+ */
+template<int W>
+static ALWAYS_INLINE void batch_var_node(const TannerGraph &graph,
+                                         BatchDecoderWorkspace &ws,
+                                         const double vsat) {
+    typedef typename Lanes<W>::d block_d;
+    typedef typename Lanes<W>::i block_i;
+    const size_t B = ws.batch_size;
+    double *msg_v = ws.msg_v.data();
+    const double *msg_c = ws.msg_c.data();
+    const block_d zero = block_d{};
+    const block_d sat = block_d{} + vsat;
+
+    for (size_t v{}; v < graph.n_cols; ++v) {
+        const uint32_t begin = graph.var_offsets[v];
+        const uint32_t end = graph.var_offsets[v + 1];
+
+        for (const uint32_t b : ws.active_blocks) {
+            for (size_t lane0 = b * batch_block_size; lane0 < (b + 1) * batch_block_size; lane0 += W) {
+                // same summation order as var_node_update and hard_decision
+                block_d sum = LOAD_D(&ws.llrs[v * B + lane0]);
+                for (uint32_t e = begin; e < end; ++e) {
+                    sum += LOAD_D(msg_c + e * B + lane0);
+                }
+                STORE_I(&ws.decision[v * B + lane0], sum < zero);
+
+                block_i nan = block_i{};
+                for (uint32_t e = begin; e < end; ++e) {
+                    block_d res = sum - LOAD_D(msg_c + e * B + lane0);
+                    SATURATE_BLOCK(res, sat);
+                    nan |= res != res;
+                    STORE_D(msg_v + graph.var_to_check_edge[e] * B + lane0, res);
+                }
+                STORE_I(&ws.diverged[lane0], LOAD_I(&ws.diverged[lane0]) | nan);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief marks, per lane, whether the hard decision violates any check
+ */
+template<int W>
+static ALWAYS_INLINE void batch_syndrome_check(const TannerGraph &graph, BatchDecoderWorkspace &ws) {
+    typedef typename Lanes<W>::i block_i;
+    const size_t B = ws.batch_size;
+    fill(ws.unsatisfied.begin(), ws.unsatisfied.end(), 0);
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
+        for (const uint32_t b : ws.active_blocks) {
+            for (size_t lane0 = b * batch_block_size; lane0 < (b + 1) * batch_block_size; lane0 += W) {
+                block_i parity = LOAD_I(&ws.syndrome[m * B + lane0]);
+                for (uint32_t e = begin; e < end; ++e) {
+                    parity ^= LOAD_I(&ws.decision[graph.check_vars[e] * B + lane0]);
+                }
+                STORE_I(&ws.unsatisfied[lane0], LOAD_I(&ws.unsatisfied[lane0]) | parity);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief copies the current hard decision of one lane into a decoded word
+ */
+static void copy_lane_decision(const BatchDecoderWorkspace &ws, const size_t f, vector<bool> &word) {
+    for (size_t v = 0; v < word.size(); ++v) {
+        word[v] = ws.decision[v * ws.batch_size + f] != 0;
+    }
+}
+
+
+/**
+ * @brief recomputes the list of vector blocks that still hold a decoding frame
+ * @return true if any block is left
+ */
+static bool update_active_blocks(BatchDecoderWorkspace &ws) {
+    ws.active_blocks.clear();
+    for (uint32_t b = 0; b < ws.batch_size / batch_block_size; ++b) {
+        const auto first = ws.done.begin() + b * batch_block_size;
+        if (!all_of(first, first + batch_block_size, [](uint8_t d) { return d != 0; })) {
+            ws.active_blocks.push_back(b);
+        }
+    }
+    return !ws.active_blocks.empty();
+}
+
+
+/**
+ * @brief the decoding iterations, inlined into one wrapper per instruction set
+ * @tparam W number of lanes of the native vector width
+ */
+template<int W>
+static ALWAYS_INLINE void batch_iterations(const LdpcCode &code,
+                                           BatchDecoderWorkspace &ws,
+                                           const DecoderConfig &config,
+                                           vector<vector<bool>> &out,
+                                           vector<bool> &success) {
+    double ms_scale, ms_offset;
+    min_sum_parameters(config, ms_scale, ms_offset);
+
+    for (size_t it_unused{}; it_unused < config.max_num_iter && update_active_blocks(ws); ++it_unused) {
+        if (config.rule == CheckNodeRule::sum_product) {
+            batch_check_node_sum_product<W>(code.graph, ws, config.vsat);
+        } else {
+            batch_check_node_min_sum<W>(code.graph, ws, ms_scale, ms_offset, config.vsat);
+        }
+        batch_var_node<W>(code.graph, ws, config.vsat);
+        batch_syndrome_check<W>(code.graph, ws);
+
+        // retire converged and diverged frames, they keep this iteration's decision
+        for (size_t f = 0; f < out.size(); ++f) {
+            if (ws.done[f]) {
+                continue;
+            }
+            if (!ws.unsatisfied[f] || ws.diverged[f]) {
+                success[f] = !ws.unsatisfied[f];
+                copy_lane_decision(ws, f, out[f]);
+                ws.done[f] = 1;
+            }
+        }
+    }
+}
+
+
+#ifdef BATCH_DECODER_X86
+TARGET_AVX512 static void batch_iterations_avx512(const LdpcCode &code, BatchDecoderWorkspace &ws,
+                                                  const DecoderConfig &config,
+                                                  vector<vector<bool>> &out, vector<bool> &success) {
+    batch_iterations<8>(code, ws, config, out, success);
+}
+
+
+TARGET_AVX2 static void batch_iterations_avx2(const LdpcCode &code, BatchDecoderWorkspace &ws,
+                                              const DecoderConfig &config,
+                                              vector<vector<bool>> &out, vector<bool> &success) {
+    batch_iterations<4>(code, ws, config, out, success);
+}
+#endif
+
+
+static void batch_iterations_scalar(const LdpcCode &code, BatchDecoderWorkspace &ws,
+                                    const DecoderConfig &config,
+                                    vector<vector<bool>> &out, vector<bool> &success) {
+    batch_iterations<2>(code, ws, config, out, success);
+}
+
+
+/**
+ * @brief decodes up to ws.batch_size frames in lockstep
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios, one vector per frame
+ * @param syndromes syndrome of every frame
+ * @param ws batch workspace for this code
+ * @param config decoder parameters
+ * @param out output, decoded word of every frame
+ * @param success output, whether each frame matched its syndrome
+ */
+void decode_batch(const LdpcCode &code,
+                  const vector<vector<double>> &llrs,
+                  const vector<vector<bool>> &syndromes,
+                  BatchDecoderWorkspace &ws,
+                  const DecoderConfig &config,
+                  vector<vector<bool>> &out,
+                  vector<bool> &success) {
+    const TannerGraph &graph = code.graph;
+    const size_t B = ws.batch_size;
+    const size_t n_frames = llrs.size();
+
+    // check inputs.
+    if (n_frames > B || syndromes.size() != n_frames) {
+        throw runtime_error("number of frames doesn't match the batch.");
+    }
+    if (ws.msg_v.size() != graph.n_edges() * B || ws.llrs.size() != static_cast<size_t>(code.n_cols) * B) {
+        throw runtime_error("batch workspace doesn't match H.");
+    }
+    if (config.schedule != Schedule::flooding) {
+        throw runtime_error("the batch decoder only supports the flooding schedule.");
+    }
+    if (config.message_type != MessageType::float64) {
+        throw runtime_error("the batch decoder only supports double messages.");
+    }
+    if (config.warm_start) {
+        throw runtime_error("the batch decoder doesn't support warm starts.");
+    }
+    for (size_t f = 0; f < n_frames; ++f) {
+        if (llrs[f].size() != code.n_cols) {
+            throw runtime_error("input doesn't match H.");
+        }
+        if (syndromes[f].size() != code.n_rows) {
+            throw runtime_error("checksum doesn't match number of rows in H");
+        }
+    }
+
+    // interleave the frames, unused lanes are retired from the start
+    fill(ws.llrs.begin(), ws.llrs.end(), 0.);
+    fill(ws.syndrome.begin(), ws.syndrome.end(), 0);
+    fill(ws.diverged.begin(), ws.diverged.end(), 0);
+    for (size_t f = 0; f < B; ++f) {
+        ws.done[f] = f >= n_frames;
+    }
+    for (size_t f = 0; f < n_frames; ++f) {
+        for (size_t v = 0; v < code.n_cols; ++v) {
+            ws.llrs[v * B + f] = llrs[f][v];
+        }
+        for (size_t m = 0; m < code.n_rows; ++m) {
+            ws.syndrome[m * B + f] = syndromes[f][m] ? -1 : 0;
+        }
+    }
+    for (size_t e = 0; e < graph.n_edges(); ++e) {
+        copy_n(&ws.llrs[graph.check_vars[e] * B], B, &ws.msg_v[e * B]);
+    }
+
+    out.resize(n_frames);
+    for (auto &word : out) {
+        word.assign(code.n_cols, false);
+    }
+    success.assign(n_frames, false);
+
+    switch (resolve_simd_level(config.simd)) {
+#ifdef BATCH_DECODER_X86
+        case SimdLevel::avx512:
+            batch_iterations_avx512(code, ws, config, out, success);
+            break;
+        case SimdLevel::avx2:
+            batch_iterations_avx2(code, ws, config, out, success);
+            break;
+#endif
+        default:
+            batch_iterations_scalar(code, ws, config, out, success);
+            break;
+    }
+
+    // frames that hit the iteration cap keep their last decision
+    for (size_t f = 0; f < n_frames; ++f) {
+        if (!ws.done[f]) {
+            copy_lane_decision(ws, f, out[f]);
+        }
+    }
+}
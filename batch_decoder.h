@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Batch decoder: decodes several frames over the same code in lockstep. The messages
+of all frames are interleaved edge by edge (frame index fastest), so one SIMD lane
+works on one frame and every graph index is loaded once for the whole batch.
+*/
+
+
+#ifndef INFORMATION_THEORY_BATCH_DECODER_H
+#define INFORMATION_THEORY_BATCH_DECODER_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+// number of frames handled by one vector block, a batch is a multiple of this
+const size_t batch_block_size = 8;
+
+
+/**
+ * @brief message and scratch buffers of the batch decoder, all frame-interleaved
+ *
+ * Entry [i * batch_size + f] belongs to frame f. Like DecoderWorkspace it is reused
+ * across batches and must not be shared between threads.
+ */
+struct BatchDecoderWorkspace {
+    size_t batch_size{};               // number of frames (lanes), multiple of batch_block_size
+    vector<double> msg_v;              // variable to check messages, check order
+    vector<double> msg_c;              // check to variable messages, variable order
+    vector<double> llrs;               // initial log-likelihood ratios, per variable node
+    vector<int64_t> syndrome;          // syndrome bits as lane masks (0 or -1), per check node
+    vector<int64_t> decision;          // hard decision as lane masks, per variable node
+    vector<int64_t> unsatisfied;       // per lane: any unsatisfied check in this iteration
+    vector<int64_t> diverged;          // per lane: NaN in the variable messages
+    vector<uint8_t> done;              // per lane: frame retired (converged, diverged or padding)
+    vector<double> check_scratch;      // tanh of the messages of one check node, per edge and lane
+    vector<uint32_t> active_blocks;    // vector blocks with at least one frame still decoding
+};
+
+
+/**
+ * @brief allocates a batch decoder workspace
+ * @param code the LDPC code
+ * @param batch_size number of frames decoded together, rounded up to a multiple of batch_block_size
+ * @return the workspace
+ */
+BatchDecoderWorkspace make_batch_decoder_workspace(const LdpcCode &code, size_t batch_size);
+
+
+/**
+ * @brief decodes up to ws.batch_size frames in lockstep
+ *
+ * Frames that match their syndrome (or diverge) are retired individually and keep
+ * the decision of that iteration, the batch stops once every frame is retired or
+ * the iteration cap is reached. All rules run vectorized across frames. With the
+ * min-sum rules every frame gets exactly the result of the single frame decoder,
+ * with the sum-product rule the polynomial tanh and log of check_node_update_simd
+ * give the messages to within rounding (checked by check_batch_decoder). Only the
+ * flooding schedule with double messages is supported.
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios, one vector per frame
+ * @param syndromes syndrome of every frame
+ * @param ws batch workspace for this code
+ * @param config decoder parameters
+ * @param out output, decoded word of every frame
+ * @param success output, whether each frame matched its syndrome
+ */
+void decode_batch(const LdpcCode &code,
+                  const vector<vector<double>> &llrs,
+                  const vector<vector<bool>> &syndromes,
+                  BatchDecoderWorkspace &ws,
+                  const DecoderConfig &config,
+                  vector<vector<bool>> &out,
+                  vector<bool> &success);
+
+#endif //INFORMATION_THEORY_BATCH_DECODER_H
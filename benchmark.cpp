@@ -0,0 +1,454 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Microbenchmarks of the encoder, the LLR calculation, the decoder kernels and the
+full decoder on every code of a directory, without console I/O in the timed part:
+
+    ldpc_benchmark codes
+    ldpc_benchmark --p 0.01,0.02 --rule normalized_min_sum --csv codes/4095_737_101_colmn_pointers.npy
+
+Each measurement repeats the call until a repetition takes at least --min-time
+seconds and reports the median of --repetitions repetitions. The frames are drawn
+from fixed seeds, so every run times the same work. Without --p the crossover
+probabilities are fixed fractions of the Slepian-Wolf limit of each code (the p
+with h(p) = n_rows / n_cols).
+
+For a QC base matrix file (see qc_ldpc.h) the expanded code is timed like any other,
+plus decode_qc on the circulants with the same frames.
+
+Columns: time per call, ns per edge of H (per edge and iteration for the decoder),
+frame bits per second, decoder iterations per second and, for the decoder, the mean
+iterations per frame and the FER of the frame set.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "encoding_decoding.h"
+#include "simulation_utils.h"
+#include "simd_kernels.h"
+#include "packed_bits.h"
+#include "code_io.h"
+#include "qc_ldpc.h"
+#include "statistics.h"
+
+using namespace std;
+
+
+/**
+ * @brief parameters of a benchmark run
+ */
+struct BenchmarkOptions {
+    vector<double> p_values;           // crossover probabilities, empty uses fractions of the Slepian-Wolf limit
+    double min_time = 0.02;            // seconds per repetition, at least
+    int repetitions = 5;               // repetitions, the median is reported
+    size_t frames = 32;                // frames per decoder measurement
+    bool csv = false;
+    DecoderConfig decoder;
+};
+
+
+// fractions of the Slepian-Wolf limit used without --p
+const double limit_fractions[] = {0.4, 0.55, 0.7};
+
+
+/**
+ * @brief one line of the report, values that don't apply are zero
+ */
+struct BenchmarkResult {
+    string code;
+    string kernel;
+    double p{};
+    double seconds{};                  // median time per call
+    double ns_per_edge{};
+    double mbit_per_second{};
+    double iterations_per_second{};
+    double mean_iterations{};
+    double fer = -1;                   // negative if not a decoder measurement
+};
+
+
+/**
+ * @brief median time of one call of f
+ * @param f the call to time
+ * @param options repetitions and minimum time per repetition
+ * @return seconds per call
+ */
+template<typename Function>
+static double time_call(Function &&f, const BenchmarkOptions &options) {
+    auto run = [&](const size_t calls) {
+        const auto start = chrono::steady_clock::now();
+        for (size_t c = 0; c < calls; ++c) {
+            f();
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    // warm up, then double the calls until one repetition is long enough
+    size_t calls = 1;
+    for (double t = run(calls); t < options.min_time; t = run(calls)) {
+        calls *= 2;
+    }
+    vector<double> per_call(options.repetitions);
+    for (auto &t : per_call) {
+        t = run(calls) / calls;
+    }
+    sort(per_call.begin(), per_call.end());
+    return per_call[per_call.size() / 2];
+}
+
+
+/**
+ * @brief a source word, its syndrome and the LLRs of the side information
+ */
+struct BenchmarkFrame {
+    vector<bool> x;
+    vector<bool> syndrome;
+    vector<double> llrs;
+};
+
+
+/**
+ * @brief draws frames with a fixed seed
+ * @param code the LDPC code
+ * @param p crossover probability of the side information
+ * @param n number of frames
+ * @return the frames
+ */
+static vector<BenchmarkFrame> make_frames(const LdpcCode &code, const double p, const size_t n) {
+    mt19937_64 gen(stream_seed(1, static_cast<uint64_t>(p * 1e9), code.n_cols));
+    bernoulli_distribution flip(p);
+    vector<BenchmarkFrame> frames(n);
+    vector<bool> y(code.n_cols);
+    for (auto &frame : frames) {
+        frame.x.resize(code.n_cols);
+        random_input(frame.x, gen);
+        for (size_t j = 0; j < code.n_cols; ++j) {
+            y[j] = frame.x[j] ^ flip(gen);
+        }
+        frame.syndrome.resize(code.n_rows);
+        encode(code, frame.x, frame.syndrome);
+        frame.llrs = bsc_llr(y, p);
+    }
+    return frames;
+}
+
+
+/**
+ * @brief times the kernels and the decoder on one code
+ * @param name name of the code in the report
+ * @param code the LDPC code
+ * @param qc the QC form of the code, or nullptr
+ * @param options benchmark parameters
+ * @param results output, one entry per measurement is appended
+ */
+static void benchmark_code(const string &name, const LdpcCode &code, const QcLdpcCode *qc,
+                           const BenchmarkOptions &options, vector<BenchmarkResult> &results) {
+    const TannerGraph &graph = code.graph;
+    const double edges = graph.n_edges();
+    const double bits = code.n_cols;
+    const SimdLevel simd = resolve_simd_level(options.decoder.simd);
+    auto add = [&](const string &kernel, const double p, const double seconds) {
+        BenchmarkResult r;
+        r.code = name;
+        r.kernel = kernel;
+        r.p = p;
+        r.seconds = seconds;
+        r.ns_per_edge = seconds * 1e9 / edges;
+        r.mbit_per_second = bits / seconds * 1e-6;
+        results.push_back(r);
+    };
+
+    vector<double> p_values = options.p_values;
+    if (p_values.empty()) {
+        const double limit = slepian_wolf_limit(static_cast<double>(code.n_rows) / code.n_cols);
+        for (const double f : limit_fractions) {
+            p_values.push_back(f * limit);
+        }
+    }
+
+    // parts that don't depend on the channel
+    const vector<uint32_t> column_pointers(code.column_pointers.begin(), code.column_pointers.end());
+    const vector<uint32_t> row_index(code.row_index.begin(), code.row_index.end());
+    add("calculate_vn_cv", 0, time_call([&] {
+        calculate_vn_cv(code.n_cols, code.n_rows, column_pointers, row_index);
+    }, options));
+
+    const vector<BenchmarkFrame> reference = make_frames(code, p_values.front(), 1);
+    vector<bool> syndrome(code.n_rows);
+    add("encode", 0, time_call([&] { encode(code, reference[0].x, syndrome); }, options));
+
+    PackedFrame packed_x, packed_syndrome;
+    pack_bits(reference[0].x, packed_x);
+    add("encode_packed", 0, time_call([&] { encode(code, packed_x, packed_syndrome); }, options));
+
+    vector<double> llrs;
+    add("bsc_llr", 0, time_call([&] { bsc_llr(reference[0].x, p_values.front(), llrs); }, options));
+
+    DecoderWorkspace ws = make_decoder_workspace(code);
+    MessageBuffers<double> &buffers = ws.f64;
+    double ms_scale, ms_offset;
+    min_sum_parameters(options.decoder, ms_scale, ms_offset);
+    const string level = simd_level_name(simd);
+
+    for (const double p : p_values) {
+        const vector<BenchmarkFrame> frames = make_frames(code, p, options.frames);
+
+        // kernels on the messages of the first iteration of the first frame
+        const BenchmarkFrame &frame = frames.front();
+        for (size_t e = 0; e < graph.n_edges(); ++e) {
+            buffers.msg_v[e] = frame.llrs[graph.check_vars[e]];
+        }
+        const vector<double> msg_v = buffers.msg_v;
+        add("check_node_update", p, time_call([&] {
+            check_node_update(buffers.msg_c, msg_v, frame.syndrome, graph);
+        }, options));
+        add("check_node_update_min_sum", p, time_call([&] {
+            check_node_update_min_sum(buffers.msg_c, msg_v, frame.syndrome, graph, ms_scale, ms_offset);
+        }, options));
+        add("check_node_update_simd/" + level, p, time_call([&] {
+            check_node_update_simd(buffers.msg_c, msg_v, frame.syndrome, graph, buffers.check_scratch, simd);
+        }, options));
+        add("check_node_update_min_sum_simd/" + level, p, time_call([&] {
+            check_node_update_min_sum_simd(buffers.msg_c, msg_v, frame.syndrome, graph, ms_scale, ms_offset, simd);
+        }, options));
+
+        check_node_update(buffers.msg_c, msg_v, frame.syndrome, graph);
+        add("var_node_update", p, time_call([&] {
+            var_node_update(buffers.msg_v, buffers.msg_c, frame.llrs, graph);
+        }, options));
+        add("var_node_update_simd/" + level, p, time_call([&] {
+            var_node_update_simd(buffers.msg_v, buffers.msg_c, frame.llrs, graph, simd);
+        }, options));
+        // the hard decision with the syndrome tracking of the decoder, after a reset
+        add("hard_decision", p, time_call([&] {
+            reset_syndrome_tracking(ws, frame.syndrome);
+            hard_decision(ws, frame.llrs, buffers.msg_c, graph);
+        }, options));
+
+        // the full decoder on the frame set, iterations counted in one untimed pass
+        size_t iterations = 0, errors = 0;
+        FrameStatistics statistics;
+        ws.statistics = &statistics;
+        for (const auto &f : frames) {
+            errors += !decode_at_current_rate(code, f.llrs, f.syndrome, ws, options.decoder) || ws.out != f.x;
+            iterations += statistics.iterations;
+        }
+        ws.statistics = nullptr;
+        const double seconds = time_call([&] {
+            for (const auto &f : frames) {
+                decode_at_current_rate(code, f.llrs, f.syndrome, ws, options.decoder);
+            }
+        }, options) / frames.size();
+        add("decode_at_current_rate", p, seconds);
+        BenchmarkResult &r = results.back();
+        r.mean_iterations = static_cast<double>(iterations) / frames.size();
+        r.ns_per_edge = seconds * 1e9 / (edges * max(r.mean_iterations, 1.));
+        r.iterations_per_second = r.mean_iterations / seconds;
+        r.fer = static_cast<double>(errors) / frames.size();
+
+        // the same frames on the circulants, decode_qc takes the same number of iterations
+        if (qc && options.decoder.schedule == Schedule::flooding
+            && options.decoder.message_type != MessageType::fixed_point) {
+            QcDecoderWorkspace qc_ws = make_qc_decoder_workspace(*qc);
+            size_t qc_errors = 0;
+            for (const auto &f : frames) {
+                qc_errors += !decode_qc(*qc, f.llrs, f.syndrome, qc_ws, options.decoder) || qc_ws.out != f.x;
+            }
+            const double qc_seconds = time_call([&] {
+                for (const auto &f : frames) {
+                    decode_qc(*qc, f.llrs, f.syndrome, qc_ws, options.decoder);
+                }
+            }, options) / frames.size();
+            const double mean_iterations = results.back().mean_iterations;
+            add("decode_qc", p, qc_seconds);
+            BenchmarkResult &q = results.back();
+            q.mean_iterations = mean_iterations;
+            q.ns_per_edge = qc_seconds * 1e9 / (edges * max(mean_iterations, 1.));
+            q.iterations_per_second = mean_iterations / qc_seconds;
+            q.fer = static_cast<double>(qc_errors) / frames.size();
+        }
+    }
+}
+
+
+/**
+ * @brief the codes of a path: the file itself, or the code files and .npy pairs of a directory
+ * @param path file or directory
+ * @return the files, sorted
+ */
+static vector<string> code_files(const string &path) {
+    struct stat info{};
+    if (::stat(path.c_str(), &info) != 0) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        return {path};
+    }
+    auto ends_with = [](const string &s, const string &suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    vector<string> files;
+    DIR *dir = ::opendir(path.c_str());
+    if (dir == nullptr) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    while (const dirent *entry = ::readdir(dir)) {
+        const string file = entry->d_name;
+        if (ends_with(file, "_colmn_pointers.npy") || ends_with(file, ".ldpc") || ends_with(file, ".alist")
+            || ends_with(file, ".qc")) {
+            files.push_back(path + "/" + file);
+        }
+    }
+    ::closedir(dir);
+    sort(files.begin(), files.end());
+    return files;
+}
+
+
+/**
+ * @brief prints the results as an aligned table or as CSV
+ */
+static void print_results(const vector<BenchmarkResult> &results, const bool csv) {
+    auto number = [](const double v, const int precision) {
+        ostringstream out;
+        out << fixed << setprecision(precision) << v;
+        return out.str();
+    };
+    auto optional = [&](const double v, const int precision) {
+        return v > 0 ? number(v, precision) : string("-");
+    };
+
+    if (csv) {
+        cout << "code,kernel,p,us_per_call,ns_per_edge,mbit_per_s,iterations_per_s,mean_iterations,fer" << endl;
+        for (const auto &r : results) {
+            cout << r.code << ',' << r.kernel << ',' << r.p << ',' << r.seconds * 1e6 << ',' << r.ns_per_edge
+                 << ',' << r.mbit_per_second << ',' << r.iterations_per_second << ',' << r.mean_iterations
+                 << ',' << (r.fer < 0 ? 0 : r.fer) << endl;
+        }
+        return;
+    }
+    cout << left << setw(28) << "code" << setw(40) << "kernel" << right << setw(9) << "p"
+         << setw(13) << "us/call" << setw(10) << "ns/edge" << setw(11) << "Mbit/s" << setw(11) << "it/s"
+         << setw(8) << "it" << setw(8) << "FER" << endl;
+    for (const auto &r : results) {
+        cout << left << setw(28) << r.code << setw(40) << r.kernel << right
+             << setw(9) << optional(r.p, 5) << setw(13) << number(r.seconds * 1e6, 2)
+             << setw(10) << number(r.ns_per_edge, 3) << setw(11) << number(r.mbit_per_second, 2)
+             << setw(11) << optional(r.iterations_per_second, 0) << setw(8) << optional(r.mean_iterations, 2)
+             << setw(8) << (r.fer < 0 ? string("-") : number(r.fer, 3)) << endl;
+    }
+}
+
+
+int main(int argc, char **argv) {
+    const string usage = string("usage: ") + argv[0] +
+                         " [--p <p,...>] [--min-time <seconds>] [--repetitions <n>] [--frames <n>]"
+                         " [--rule <rule>] [--simd <level>] [--iterations <n>] [--csv] <code or directory>...";
+    BenchmarkOptions options;
+    vector<string> paths;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const string arg = argv[a];
+            auto value = [&]() -> string {
+                if (a + 1 >= argc) {
+                    throw runtime_error(arg + " needs a value.");
+                }
+                return argv[++a];
+            };
+            if (arg == "--p") {
+                istringstream list(value());
+                for (string item; getline(list, item, ',');) {
+                    options.p_values.push_back(stod(item));
+                }
+            } else if (arg == "--min-time") {
+                options.min_time = stod(value());
+            } else if (arg == "--repetitions") {
+                options.repetitions = max(1, stoi(value()));
+            } else if (arg == "--frames") {
+                options.frames = max<size_t>(1, stoul(value()));
+            } else if (arg == "--rule") {
+                options.decoder.rule = check_node_rule_from_name(value());
+            } else if (arg == "--simd") {
+                options.decoder.simd = simd_level_from_name(value());
+            } else if (arg == "--iterations") {
+                options.decoder.max_num_iter = stoul(value());
+            } else if (arg == "--csv") {
+                options.csv = true;
+            } else if (arg.compare(0, 2, "--") != 0) {
+                paths.push_back(arg);
+            } else {
+                throw runtime_error("unexpected argument " + arg);
+            }
+        }
+        if (paths.empty()) {
+            throw runtime_error("no code given.");
+        }
+        for (const double p : options.p_values) {
+            if (!(p > 0 && p < 0.5)) {
+                throw runtime_error("crossover probabilities must be in (0, 0.5).");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl << usage << endl;
+        return 2;
+    }
+
+    try {
+        vector<BenchmarkResult> results;
+        for (const auto &path : paths) {
+            for (const auto &file : code_files(path)) {
+                const LdpcCode code = load_ldpc_code(file);
+                QcLdpcCode qc;
+                const bool is_qc = is_qc_base_matrix_file(file);
+                if (is_qc) {
+                    qc = read_qc_base_matrix(file);
+                }
+                string name = file.substr(file.find_last_of('/') + 1);
+                name = name.substr(0, name.find("_colmn_pointers.npy"));
+                benchmark_code(name, code, is_qc ? &qc : nullptr, options, results);
+                if (!options.csv) {
+                    cerr << name << ": " << code.n_cols << " columns, " << code.n_rows << " rows, "
+                         << code.graph.n_edges() << " edges, SIMD level "
+                         << simd_level_name(resolve_simd_level(options.decoder.simd)) << endl;
+                }
+            }
+        }
+        print_results(results, options.csv);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Binary symmetric channel with geometric skip sampling and fixed-weight error
+patterns.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <random>
+#include "bsc_channel.h"
+
+using namespace std;
+
+
+/**
+ * @brief creates a channel
+ * @param p crossover probability in [0, 1]
+ * @param seed seed of the generator
+ * @return the channel
+ */
+BscChannel make_bsc_channel(const double p, const uint64_t seed) {
+    BscChannel channel;
+    channel.gen.seed(seed);
+    set_crossover_probability(channel, p);
+    return channel;
+}
+
+
+/**
+ * @brief changes the crossover probability, the generator state is kept
+ * @param channel the channel
+ * @param p crossover probability in [0, 1]
+ */
+void set_crossover_probability(BscChannel &channel, const double p) {
+    if (!(p >= 0 && p <= 1)) {
+        throw runtime_error("BSC crossover probability " + to_string(p) + " is not in [0, 1].");
+    }
+    channel.p = p;
+    channel.inv_log_q = (p > 0 && p < 1) ? 1 / log1p(-p) : 0;
+}
+
+
+/**
+ * @brief calls flip(i) for the positions i < n_bits of a realization of the channel
+ *
+ * The number of unflipped bits before the next flip is geometric with
+ * P(gap >= k) = (1-p)^k, drawn as floor(log(u) / log(1-p)) with u uniform in (0, 1].
+ * One generator output per flip plus one for the gap running past the end.
+ * @param channel the channel
+ * @param n_bits number of bits in the frame
+ * @param flip callback taking the position of a flipped bit
+ * @return number of flipped bits
+ */
+template<typename Flip>
+static size_t for_each_flip(BscChannel &channel, const size_t n_bits, Flip flip) {
+    if (channel.p <= 0) {
+        return 0;
+    }
+    if (channel.p >= 1) {
+        for (size_t i = 0; i < n_bits; ++i) {
+            flip(i);
+        }
+        return n_bits;
+    }
+
+    size_t n_flips = 0;
+    size_t pos = 0;
+    while (pos < n_bits) {
+        // 53 random bits, shifted to (0, 1] so the log stays finite
+        const double u = static_cast<double>((channel.gen() >> 11) + 1) * (1.0 / 9007199254740992.0);
+        ++channel.n_draws;
+        const double gap = floor(log(u) * channel.inv_log_q);
+        if (gap >= static_cast<double>(n_bits - pos)) {
+            break;
+        }
+        pos += static_cast<size_t>(gap);
+        flip(pos);
+        ++n_flips;
+        ++pos;
+    }
+    return n_flips;
+}
+
+
+/**
+ * @brief flips every bit of the frame with probability channel.p, in place
+ * @param channel the channel
+ * @param frame the packed frame
+ * @return number of flipped bits
+ */
+size_t apply_bsc(BscChannel &channel, PackedFrame &frame) {
+    uint64_t *words = frame.words.data();
+    return for_each_flip(channel, frame.n_bits, [words](const size_t i) {
+        words[i / packed_word_bits] ^= uint64_t(1) << (i % packed_word_bits);
+    });
+}
+
+
+/**
+ * @brief flips every bit of the vector with probability channel.p, in place
+ * @param channel the channel
+ * @param bits the bits
+ * @return number of flipped bits
+ */
+size_t apply_bsc(BscChannel &channel, vector<bool> &bits) {
+    return for_each_flip(channel, bits.size(), [&bits](const size_t i) {
+        bits[i] = !bits[i];
+    });
+}
+
+
+/**
+ * @brief draws an error pattern of exactly the given weight, uniformly over all
+ * patterns of that weight (Floyd's algorithm, weight generator outputs)
+ * @param n_bits number of bits in the frame
+ * @param weight number of set bits, at most n_bits
+ * @param gen random number generator
+ * @param errors output, the packed pattern, resized to n_bits
+ */
+void fixed_weight_errors(const size_t n_bits, const size_t weight, mt19937_64 &gen, PackedFrame &errors) {
+    if (weight > n_bits) {
+        throw runtime_error("Error weight " + to_string(weight) + " exceeds the frame length "
+                            + to_string(n_bits) + ".");
+    }
+    errors.n_bits = n_bits;
+    errors.words.assign(packed_words(n_bits), 0);
+
+    // the pattern itself is the set of chosen positions, so every step is O(1)
+    for (size_t j = n_bits - weight; j < n_bits; ++j) {
+        const size_t t = uniform_int_distribution<size_t>(0, j)(gen);
+        errors.set(errors.get(t) ? j : t, true);
+    }
+}
+
+
+/**
+ * @brief flips the bits set in a packed error pattern
+ * @param errors the error pattern
+ * @param bits the bits to flip, same length as the pattern
+ */
+void apply_errors(const PackedFrame &errors, PackedFrame &bits) {
+    if (errors.n_bits != bits.n_bits) {
+        throw runtime_error("Error pattern and frame differ in length.");
+    }
+    for (size_t w = 0; w < bits.words.size(); ++w) {
+        bits.words[w] ^= errors.words[w];
+    }
+}
+
+
+/**
+ * @brief flips the bits set in a packed error pattern
+ * @param errors the error pattern
+ * @param bits the bits to flip, same length as the pattern
+ */
+void apply_errors(const PackedFrame &errors, vector<bool> &bits) {
+    if (errors.n_bits != bits.size()) {
+        throw runtime_error("Error pattern and frame differ in length.");
+    }
+    for (size_t w = 0; w < errors.words.size(); ++w) {
+        // visit the set bits only
+        for (uint64_t word = errors.words[w]; word != 0; word &= word - 1) {
+            const size_t i = w * packed_word_bits + static_cast<size_t>(__builtin_ctzll(word));
+            bits[i] = !bits[i];
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Binary symmetric channel working on the gaps between bit flips: instead of one
+Bernoulli draw per bit, the distance to the next flip is drawn from the geometric
+distribution, so a frame of n bits costs about n*p + 1 generator outputs.
+Also error patterns of a fixed weight, for weight-stratified simulations.
+*/
+
+
+#ifndef INFORMATION_THEORY_BSC_CHANNEL_H
+#define INFORMATION_THEORY_BSC_CHANNEL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include "packed_bits.h"
+
+using namespace std;
+
+
+/**
+ * @brief a binary symmetric channel with its own long-lived generator
+ *
+ * Create it once per thread (or per random stream) and reuse it for all frames, the
+ * crossover probability can be changed in between without reseeding.
+ */
+struct BscChannel {
+    double p = 0;                      // crossover probability
+    double inv_log_q = 0;              // 1 / log(1 - p), turns a uniform draw into a gap
+    mt19937_64 gen;                    // generator, also usable for the channel input
+    uint64_t n_draws = 0;              // generator outputs consumed by the channel so far
+};
+
+
+/**
+ * @brief creates a channel
+ * @param p crossover probability in [0, 1]
+ * @param seed seed of the generator
+ * @return the channel
+ */
+BscChannel make_bsc_channel(double p, uint64_t seed = 1);
+
+
+/**
+ * @brief changes the crossover probability, the generator state is kept
+ * @param channel the channel
+ * @param p crossover probability in [0, 1]
+ */
+void set_crossover_probability(BscChannel &channel, double p);
+
+
+/**
+ * @brief flips every bit of the frame with probability channel.p, in place
+ * @param channel the channel
+ * @param frame the packed frame
+ * @return number of flipped bits
+ */
+size_t apply_bsc(BscChannel &channel, PackedFrame &frame);
+
+
+/**
+ * @brief flips every bit of the vector with probability channel.p, in place
+ * @param channel the channel
+ * @param bits the bits
+ * @return number of flipped bits
+ */
+size_t apply_bsc(BscChannel &channel, vector<bool> &bits);
+
+
+
+/**
+ * @brief draws an error pattern of exactly the given weight, uniformly over all
+ * patterns of that weight (Floyd's algorithm, weight generator outputs)
+ * @param n_bits number of bits in the frame
+ * @param weight number of set bits, at most n_bits
+ * @param gen random number generator
+ * @param errors output, the packed pattern, resized to n_bits
+ */
+void fixed_weight_errors(size_t n_bits, size_t weight, mt19937_64 &gen, PackedFrame &errors);
+
+
+/**
+ * @brief flips the bits set in a packed error pattern
+ * @param errors the error pattern
+ * @param bits the bits to flip, same length as the pattern
+ */
+void apply_errors(const PackedFrame &errors, PackedFrame &bits);
+
+
+/**
+ * @brief flips the bits set in a packed error pattern
+ * @param errors the error pattern
+ * @param bits the bits to flip, same length as the pattern
+ */
+void apply_errors(const PackedFrame &errors, vector<bool> &bits);
+
+
+#endif //INFORMATION_THEORY_BSC_CHANNEL_H
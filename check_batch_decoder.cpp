@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+
+Check of the batch decoder against the single frame decoder: for every check node
+rule and every SIMD level of the CPU, decode_batch must return the same result and
+the same word for every frame as decode_at_current_rate at the same level. The
+min-sum rules must match at the full iteration cap. The sum-product messages of the
+two decoders agree only to within rounding, so they are compared after the first
+1 to 5 iterations, where a decision could only differ on a posterior within rounding
+of zero; at the full cap at most 1 in 20 frames may end differently, as rounding
+differences can grow over the iterations of a frame that does not converge. The
+frames are drawn at 0.4, 0.6 and 0.8 times the Slepian-Wolf limit and decoded in
+batches of 16 lanes holding 12 frames, so that padding lanes are covered too.
+
+    check_batch_decoder codes/1908_212_4_colmn_pointers.npy codes/4095_737_101_colmn_pointers.npy
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include "code_io.h"
+#include "batch_decoder.h"
+#include "simd_kernels.h"
+#include "bsc_channel.h"
+#include "simulation_utils.h"
+#include "statistics.h"
+
+using namespace std;
+
+
+/**
+ * @brief frames decoded together in one batch
+ */
+struct CheckBatch {
+    vector<vector<bool>> x;
+    vector<vector<bool>> syndromes;
+    vector<vector<double>> llrs;
+};
+
+
+/**
+ * @brief number of frames in which the batch decoder and the single frame decoder differ
+ * @param code the code
+ * @param batches the frames
+ * @param ws single frame workspace
+ * @param batch_ws batch workspace
+ * @param config decoder parameters
+ * @param successes output, frames decoded by the single frame decoder
+ * @return the number of frames with a different result or word
+ */
+static size_t count_mismatches(const LdpcCode &code,
+                               const vector<CheckBatch> &batches,
+                               DecoderWorkspace &ws,
+                               BatchDecoderWorkspace &batch_ws,
+                               const DecoderConfig &config,
+                               size_t &successes) {
+    size_t mismatches = 0;
+    successes = 0;
+    vector<vector<bool>> words;
+    vector<bool> results;
+    for (const auto &batch : batches) {
+        decode_batch(code, batch.llrs, batch.syndromes, batch_ws, config, words, results);
+        for (size_t f = 0; f < batch.llrs.size(); ++f) {
+            const bool result = decode_at_current_rate(code, batch.llrs[f], batch.syndromes[f], ws, config);
+            mismatches += result != results[f] || ws.out != words[f];
+            successes += result;
+        }
+    }
+    return mismatches;
+}
+
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <code>..." << endl;
+        return 2;
+    }
+
+    const CheckNodeRule rules[] = {CheckNodeRule::sum_product, CheckNodeRule::min_sum,
+                                   CheckNodeRule::normalized_min_sum, CheckNodeRule::offset_min_sum};
+    const char *rule_names[] = {"sum_product", "min_sum", "normalized_min_sum", "offset_min_sum"};
+    const size_t frames_per_batch = 12;
+    const size_t batches_per_p = 1;
+    bool passed = true;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const LdpcCode code = load_ldpc_code(argv[a]);
+            const double limit = slepian_wolf_limit(static_cast<double>(code.n_rows) / code.n_cols);
+
+            vector<CheckBatch> batches;
+            for (const double fraction : {0.4, 0.6, 0.8}) {
+                const double p = fraction * limit;
+                BscChannel channel = make_bsc_channel(p, stream_seed(1, code.n_cols, batches.size()));
+                for (size_t b = 0; b < batches_per_p; ++b) {
+                    CheckBatch batch;
+                    for (size_t f = 0; f < frames_per_batch; ++f) {
+                        vector<bool> x(code.n_cols);
+                        random_input(x, channel.gen);
+                        vector<bool> syndrome(code.n_rows);
+                        encode(code, x, syndrome);
+                        vector<bool> received = x;
+                        apply_bsc(channel, received);
+                        vector<double> llrs;
+                        bsc_llr(received, p, llrs);
+                        batch.x.push_back(x);
+                        batch.syndromes.push_back(syndrome);
+                        batch.llrs.push_back(llrs);
+                    }
+                    batches.push_back(batch);
+                }
+            }
+            const size_t n_frames = batches.size() * frames_per_batch;
+            cout << argv[a] << ": " << code.n_cols << " columns, " << code.n_rows << " rows" << endl;
+
+            DecoderWorkspace ws = make_decoder_workspace(code);
+            BatchDecoderWorkspace batch_ws = make_batch_decoder_workspace(code, 16);
+            const SimdLevel detected = detect_simd_level();
+            for (size_t r = 0; r < 4; ++r) {
+                for (const SimdLevel level : {SimdLevel::scalar, SimdLevel::avx2, SimdLevel::avx512}) {
+                    if (static_cast<int>(level) > static_cast<int>(detected)) {
+                        continue;
+                    }
+                    DecoderConfig config;
+                    config.rule = rules[r];
+                    config.simd = level;
+
+                    size_t successes = 0;
+                    const size_t mismatches = count_mismatches(code, batches, ws, batch_ws, config, successes);
+                    size_t early_mismatches = 0;
+                    bool level_passed = mismatches == 0;
+                    if (config.rule == CheckNodeRule::sum_product) {
+                        for (size_t iterations = 1; iterations <= 5; ++iterations) {
+                            DecoderConfig early = config;
+                            early.max_num_iter = iterations;
+                            size_t early_successes = 0;
+                            early_mismatches += count_mismatches(code, batches, ws, batch_ws, early, early_successes);
+                        }
+                        level_passed = early_mismatches == 0 && mismatches * 20 <= n_frames;
+                    }
+                    cout << "  " << rule_names[r] << " " << simd_level_name(level) << ": " << successes << "/"
+                         << n_frames << " decoded, " << mismatches << " mismatches";
+                    if (config.rule == CheckNodeRule::sum_product) {
+                        cout << ", " << early_mismatches << " in the first 5 iterations";
+                    }
+                    cout << (level_passed ? "" : "  FAILED") << endl;
+                    passed &= level_passed;
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+
+Check of the binary code files: every code given is written to a code file in the
+scratch directory and loaded back. The loaded code must borrow all its arrays from
+the mapping, hold the same arrays as the source and decode the same way. Copies of
+the file with one word of an index array overwritten, or two entries of an edge
+permutation swapped, must fail to load instead of reaching the decoder.
+
+    check_code_file /tmp codes/1908_212_4_colmn_pointers.npy codes/4095_737_101_colmn_pointers.npy
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include "code_io.h"
+#include "code_file.h"
+#include "bsc_channel.h"
+#include "simulation_utils.h"
+
+using namespace std;
+
+
+/**
+ * @brief true if two code arrays hold the same values
+ */
+template<typename T>
+static bool same_array(const CodeArray<T> &a, const CodeArray<T> &b) {
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin());
+}
+
+
+/**
+ * @brief compares a code loaded from a code file with the code it was written from
+ * @param source the code as built from its source
+ * @param loaded the code loaded from the code file
+ * @return a description of the first difference, empty if there is none
+ */
+static string compare_codes(const LdpcCode &source, const LdpcCode &loaded) {
+    const TannerGraph &a = source.graph;
+    const TannerGraph &b = loaded.graph;
+    const vector<const CodeArray<uint32_t> *> arrays = {
+            &b.check_offsets, &b.check_vars, &b.var_offsets, &b.var_checks, &b.check_to_var_edge,
+            &b.var_to_check_edge, &loaded.column_pointers, &loaded.row_index, &loaded.var_degrees,
+            &loaded.check_degrees, &loaded.packed_h.word_index, &loaded.packed_h.row_offsets,
+            &loaded.packed_h.row_cols};
+    for (const auto *array : arrays) {
+        if (!array->borrowed()) {
+            return "an array is not borrowed from the mapping";
+        }
+    }
+    if (!same_array(a.check_offsets, b.check_offsets) || !same_array(a.check_vars, b.check_vars)
+        || !same_array(a.var_offsets, b.var_offsets) || !same_array(a.var_checks, b.var_checks)
+        || !same_array(a.check_to_var_edge, b.check_to_var_edge)
+        || !same_array(a.var_to_check_edge, b.var_to_check_edge)
+        || a.check_to_var_edge16 != b.check_to_var_edge16 || a.var_to_check_edge16 != b.var_to_check_edge16) {
+        return "the Tanner graphs differ";
+    }
+    if (!same_array(source.column_pointers, loaded.column_pointers) || !same_array(source.row_index, loaded.row_index)
+        || !same_array(source.var_degrees, loaded.var_degrees)
+        || !same_array(source.check_degrees, loaded.check_degrees)
+        || source.max_var_degree != loaded.max_var_degree || source.max_check_degree != loaded.max_check_degree) {
+        return "the CSC arrays or degrees differ";
+    }
+    const PackedParityCheck &h = source.packed_h;
+    const PackedParityCheck &g = loaded.packed_h;
+    if (h.row_terms != g.row_terms || !same_array(h.word_index, g.word_index) || !same_array(h.word_mask, g.word_mask)
+        || !same_array(h.row_offsets, g.row_offsets) || !same_array(h.row_cols, g.row_cols)) {
+        return "the packed parity check matrices differ";
+    }
+
+    // both codes must encode and decode every frame the same way
+    const double p = 0.012;
+    BscChannel channel = make_bsc_channel(p, stream_seed(1, source.n_cols, 0));
+    DecoderWorkspace source_ws = make_decoder_workspace(source);
+    DecoderWorkspace loaded_ws = make_decoder_workspace(loaded);
+    const DecoderConfig config;
+    for (int f = 0; f < 20; ++f) {
+        vector<bool> x(source.n_cols), syndrome(source.n_rows), loaded_syndrome(loaded.n_rows);
+        random_input(x, channel.gen);
+        encode(source, x, syndrome);
+        encode(loaded, x, loaded_syndrome);
+        vector<bool> received = x;
+        apply_bsc(channel, received);
+        const vector<double> llrs = bsc_llr(received, p);
+        const bool source_result = decode_at_current_rate(source, llrs, syndrome, source_ws, config);
+        const bool loaded_result = decode_at_current_rate(loaded, llrs, syndrome, loaded_ws, config);
+        if (syndrome != loaded_syndrome || source_result != loaded_result || source_ws.out != loaded_ws.out) {
+            return "the codes encode or decode differently";
+        }
+    }
+    return "";
+}
+
+
+/**
+ * @brief writes a copy of a code file with one section changed
+ * @param bytes the code file
+ * @param section the section to change
+ * @param swap swap the first two entries instead of overwriting the first one
+ * @param path output file
+ */
+static void write_corrupt_copy(vector<char> bytes, const CodeSection section, const bool swap, const string &path) {
+    CodeFileHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    char *entries = bytes.data() + header.sections[static_cast<size_t>(section)].offset;
+    uint32_t first, second;
+    memcpy(&first, entries, sizeof(first));
+    memcpy(&second, entries + sizeof(first), sizeof(second));
+    if (swap) {
+        memcpy(entries, &second, sizeof(second));
+        memcpy(entries + sizeof(first), &first, sizeof(first));
+    } else {
+        const uint32_t corrupt = first ^ 0x00ffff00u;
+        memcpy(entries, &corrupt, sizeof(corrupt));
+    }
+    ofstream out(path, ios::binary);
+    out.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+    if (!out) {
+        throw runtime_error("writing " + path + " failed.");
+    }
+}
+
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " <scratch directory> <code>..." << endl;
+        return 2;
+    }
+
+    const string scratch = argv[1];
+    const struct {
+        CodeSection section;
+        bool swap;
+        const char *name;
+    } corruptions[] = {{CodeSection::check_to_var_edge, false, "check_to_var_edge overwritten"},
+                       {CodeSection::check_to_var_edge, true, "check_to_var_edge swapped"},
+                       {CodeSection::var_checks, true, "var_checks swapped"},
+                       {CodeSection::check_offsets, false, "check_offsets overwritten"},
+                       {CodeSection::packed_word_index, false, "packed_word_index overwritten"}};
+    bool passed = true;
+    try {
+        for (int a = 2; a < argc; ++a) {
+            const LdpcCode source = load_ldpc_code(argv[a]);
+            const string path = scratch + "/check_code_file.ldpc";
+            save_code_file(source, path);
+            const string difference = compare_codes(source, load_ldpc_code(path));
+            cout << argv[a] << ": " << (difference.empty() ? "loaded code matches" : difference + "  FAILED") << endl;
+            passed &= difference.empty();
+
+            ifstream in(path, ios::binary);
+            const vector<char> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            for (const auto &corruption : corruptions) {
+                const string corrupt_path = scratch + "/check_code_file_corrupt.ldpc";
+                write_corrupt_copy(bytes, corruption.section, corruption.swap, corrupt_path);
+                string error;
+                try {
+                    load_ldpc_code(corrupt_path);
+                } catch (const runtime_error &e) {
+                    error = e.what();
+                }
+                cout << "  " << corruption.name << ": " << (error.empty() ? "loaded  FAILED" : error) << endl;
+                passed &= !error.empty();
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Check of the QC decoder against the decoder on the expanded code: for every check
+node rule, double and float messages and every SIMD level of the CPU, decode_qc
+must return the same result and the same word as decode_at_current_rate with the
+scalar kernels on expand_qc_code, and qc_encode must give the same syndrome as
+encode. The frames are drawn at 0.4, 0.6 and 0.8 times the Slepian-Wolf limit.
+
+    check_qc_decoder codes/qc_4608_1152_96.qc
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include "qc_ldpc.h"
+#include "simd_kernels.h"
+#include "bsc_channel.h"
+#include "simulation_utils.h"
+#include "statistics.h"
+
+using namespace std;
+
+
+/**
+ * @brief a frame of the check
+ */
+struct CheckFrame {
+    vector<bool> x;
+    vector<bool> syndrome;
+    vector<double> llrs;
+};
+
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <base matrix>..." << endl;
+        return 2;
+    }
+
+    const CheckNodeRule rules[] = {CheckNodeRule::sum_product, CheckNodeRule::min_sum,
+                                   CheckNodeRule::normalized_min_sum, CheckNodeRule::offset_min_sum};
+    const char *rule_names[] = {"sum_product", "min_sum", "normalized_min_sum", "offset_min_sum"};
+    const size_t frames_per_p = 10;
+    bool passed = true;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const QcLdpcCode qc = read_qc_base_matrix(argv[a]);
+            const LdpcCode code = expand_qc_code(qc);
+            const double limit = slepian_wolf_limit(static_cast<double>(code.n_rows) / code.n_cols);
+
+            vector<CheckFrame> frames;
+            size_t encode_mismatches = 0;
+            for (const double fraction : {0.4, 0.6, 0.8}) {
+                const double p = fraction * limit;
+                BscChannel channel = make_bsc_channel(p, stream_seed(1, code.n_cols, frames.size()));
+                for (size_t f = 0; f < frames_per_p; ++f) {
+                    CheckFrame frame;
+                    frame.x.resize(code.n_cols);
+                    random_input(frame.x, channel.gen);
+                    frame.syndrome.resize(code.n_rows);
+                    encode(code, frame.x, frame.syndrome);
+                    vector<bool> qc_syndrome;
+                    qc_encode(qc, frame.x, qc_syndrome);
+                    encode_mismatches += qc_syndrome != frame.syndrome;
+                    vector<bool> received = frame.x;
+                    apply_bsc(channel, received);
+                    bsc_llr(received, p, frame.llrs);
+                    frames.push_back(frame);
+                }
+            }
+            cout << argv[a] << ": " << code.n_cols << " columns, " << code.n_rows << " rows, lifting "
+                 << qc.lifting << ", " << encode_mismatches << " qc_encode mismatches" << endl;
+            passed &= encode_mismatches == 0;
+
+            DecoderWorkspace ws = make_decoder_workspace(code);
+            QcDecoderWorkspace qc_ws = make_qc_decoder_workspace(qc);
+            for (size_t r = 0; r < 4; ++r) {
+                for (const MessageType type : {MessageType::float64, MessageType::float32}) {
+                    DecoderConfig config;
+                    config.rule = rules[r];
+                    config.message_type = type;
+                    config.simd = SimdLevel::scalar;
+
+                    // reference decisions on the expanded code
+                    vector<vector<bool>> words;
+                    vector<bool> results;
+                    size_t successes = 0;
+                    for (const auto &frame : frames) {
+                        results.push_back(decode_at_current_rate(code, frame.llrs, frame.syndrome, ws, config));
+                        words.push_back(ws.out);
+                        successes += results.back();
+                    }
+
+                    const SimdLevel detected = detect_simd_level();
+                    for (const SimdLevel level : {SimdLevel::scalar, SimdLevel::avx2, SimdLevel::avx512}) {
+                        if (static_cast<int>(level) > static_cast<int>(detected)) {
+                            continue;
+                        }
+                        config.simd = level;
+                        size_t mismatches = 0;
+                        for (size_t f = 0; f < frames.size(); ++f) {
+                            const bool result = decode_qc(qc, frames[f].llrs, frames[f].syndrome, qc_ws, config);
+                            mismatches += result != results[f] || qc_ws.out != words[f];
+                        }
+                        cout << "  " << rule_names[r] << (type == MessageType::float32 ? " float " : " double ")
+                             << simd_level_name(level) << ": " << successes << "/" << frames.size()
+                             << " decoded, " << mismatches << " mismatches" << (mismatches ? "  FAILED" : "")
+                             << endl;
+                        passed &= mismatches == 0;
+                    }
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Check of the rate-adaptive decoder on the given codes: a quarter of the rows are
+merged in pairs and split again in four steps. Frames at a crossover probability
+well below the Slepian-Wolf limit of the mother code must decode at the first step
+or at one of the warm-started steps after it whenever the mother code alone decodes
+them, and the steps past the first one must actually be used. A grid sweep that
+collects statistics must run rate-adaptive and plain jobs of the code side by side
+on one worker, with the statistics of every plain frame and none of the steps.
+
+    check_rate_adaptive codes/1908_212_4_colmn_pointers.npy codes/4095_737_101_colmn_pointers.npy
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include "code_io.h"
+#include "rate_adaptive.h"
+#include "sweep.h"
+#include "bsc_channel.h"
+#include "simulation_utils.h"
+#include "statistics.h"
+
+using namespace std;
+
+
+/**
+ * @brief decodes frames rate-adaptively and checks them against the mother code
+ * @param name name of the code, for the report
+ * @param code the mother code
+ * @param rate_code its rate steps
+ * @param config decoder parameters
+ * @param n_frames number of frames
+ * @return true if the check passed
+ */
+static bool check_rate_adaptive(const string &name,
+                                const LdpcCode &code,
+                                const RateAdaptiveCode &rate_code,
+                                const DecoderConfig &config,
+                                const size_t n_frames) {
+    const double p = 0.3 * slepian_wolf_limit(static_cast<double>(code.n_rows) / code.n_cols);
+    BscChannel channel = make_bsc_channel(p, stream_seed(1, code.n_cols, code.n_rows));
+    DecoderWorkspace ws = make_decoder_workspace(code);
+    vector<bool> input(code.n_cols), received, syndrome(code.n_rows);
+    vector<double> llrs;
+
+    size_t mother_successes = 0, failures = 0, first_step = 0, later_steps = 0, bits = 0;
+    for (size_t f = 0; f < n_frames; ++f) {
+        random_input(input, channel.gen);
+        encode(code, input, syndrome);
+        received = input;
+        apply_bsc(channel, received);
+        bsc_llr(received, p, llrs);
+
+        const bool mother_success = decode_at_current_rate(code, llrs, syndrome, ws, config) && ws.out == input;
+        const RateAdaptiveResult result = decode_rate_adaptive(rate_code, llrs, syndrome, ws, config);
+        const bool success = result.success && ws.out == input;
+        mother_successes += mother_success;
+        failures += mother_success && !success;
+        (result.step == 0 ? first_step : later_steps) += success;
+        bits += result.syndrome_bits;
+    }
+
+    const bool passed = failures == 0 && first_step > 0 && later_steps > 0;
+    cout << name << (config.schedule == Schedule::layered ? " layered" : " flooding")
+         << (config.message_type == MessageType::float32 ? " float" : " double") << ", p " << p << ": "
+         << mother_successes << "/" << n_frames << " decoded by the mother code, " << first_step
+         << " at the first step, " << later_steps << " at warm-started steps, " << failures
+         << " lost, mean syndrome bits " << static_cast<double>(bits) / n_frames << " of " << code.n_rows
+         << (passed ? "" : "  FAILED") << endl;
+    return passed;
+}
+
+
+/**
+ * @brief runs a rate-adaptive and a plain job of a code on one worker thread with
+ * statistics collected, the chunks of both alternate on the same worker
+ * @param name name of the code, for the report
+ * @param code the mother code
+ * @param rate_code its rate steps
+ * @return true if the check passed
+ */
+static bool check_grid_statistics(const string &name, const LdpcCode &code, const RateAdaptiveCode &rate_code) {
+    SweepConfig config;
+    config.frames_per_point = 64;
+    config.chunk_size = 16;
+    config.n_threads = 1;
+    config.collect_statistics = true;
+    GridJob adaptive;
+    adaptive.p = 0.3 * slepian_wolf_limit(static_cast<double>(code.n_rows) / code.n_cols);
+    adaptive.rate_adaptive = &rate_code;
+    GridJob plain = adaptive;
+    plain.rate_adaptive = nullptr;
+    const vector<SweepPointResult> results = run_grid_sweep({&code}, {adaptive, plain, adaptive}, config);
+
+    bool passed = true;
+    for (size_t j = 0; j < results.size(); ++j) {
+        const size_t expected = j == 1 ? results[j].frames : 0;
+        passed &= results[j].frames == config.frames_per_point && results[j].statistics.frames == expected;
+    }
+    passed &= results[0].syndrome_bits < code.n_rows && results[1].syndrome_bits == code.n_rows;
+    cout << name << " grid with statistics: " << results[1].statistics.frames << " plain frames with statistics, "
+         << results[0].statistics.frames + results[2].statistics.frames << " rate-adaptive ones"
+         << (passed ? "" : "  FAILED") << endl;
+    return passed;
+}
+
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <code>..." << endl;
+        return 2;
+    }
+
+    bool passed = true;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const LdpcCode code = load_ldpc_code(argv[a]);
+            const auto merges = default_row_merges(code, code.n_rows / 4);
+            const RateAdaptiveCode rate_code = make_rate_adaptive_code(code, merges, max<size_t>(1, merges.size() / 4));
+
+            DecoderConfig flooding;
+            DecoderConfig layered;
+            layered.rule = CheckNodeRule::normalized_min_sum;
+            layered.schedule = Schedule::layered;
+            layered.message_type = MessageType::float32;
+            passed &= check_rate_adaptive(argv[a], code, rate_code, flooding, 100);
+            passed &= check_rate_adaptive(argv[a], code, rate_code, layered, 100);
+            passed &= check_grid_statistics(argv[a], code, rate_code);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
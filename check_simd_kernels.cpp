@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+
+Check of the vectorized kernels against the scalar ones: for every SIMD level of the
+CPU, double and float messages and each code given, the min-sum check node kernel
+(plain, normalized and offset) and the variable node kernel must match the scalar
+kernels exactly. The sum-product check node kernel uses exp/log approximations and
+must match to within 1e-10 for double and 5e-3 for float messages, relative to the
+larger of 1 and the scalar message; the float tolerance is wide because atanh is
+ill-conditioned in float precision once the tanh product nears 1.
+The inputs are the messages of the first iterations of scalar sum-product decoding,
+with some variable messages set to zero to cover the sign convention.
+
+    check_simd_kernels codes/1908_212_4_colmn_pointers.npy codes/4095_737_101_colmn_pointers.npy
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include "code_io.h"
+#include "simd_kernels.h"
+#include "bsc_channel.h"
+#include "simulation_utils.h"
+
+using namespace std;
+
+
+/**
+ * @brief largest deviation of the kernels at one SIMD level from the scalar ones
+ */
+struct KernelDeviation {
+    double sum_product = 0;        // largest relative difference of the sum-product messages
+    size_t min_sum_mismatches = 0; // min-sum messages not equal to the scalar ones
+    size_t var_mismatches = 0;     // variable messages not equal to the scalar ones
+};
+
+
+/**
+ * @brief number of entries in which two message arrays differ
+ */
+template<typename T>
+static size_t count_mismatches(const vector<T> &a, const vector<T> &b) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        mismatches += a[i] != b[i];
+    }
+    return mismatches;
+}
+
+
+/**
+ * @brief runs scalar sum-product decoding on one frame and compares every kernel call
+ * of the SIMD level against the scalar kernel on the same input
+ * @tparam T message type (float or double)
+ * @param code the code
+ * @param received_llrs initial LLRs of the frame
+ * @param syndrome syndrome of the frame
+ * @param level instruction set of the kernels under test
+ * @param iterations number of decoding iterations to compare
+ * @param deviation updated with the deviations found
+ */
+template<typename T>
+static void compare_kernels(const LdpcCode &code,
+                            const vector<T> &received_llrs,
+                            const vector<bool> &syndrome,
+                            const SimdLevel level,
+                            const int iterations,
+                            KernelDeviation &deviation) {
+    const TannerGraph &graph = code.graph;
+    // normalized and offset min-sum as in DecoderConfig, plus plain min-sum
+    const double min_sum_parameters[3][2] = {{1.0, 0.0}, {0.75, 0.0}, {1.0, 0.5}};
+
+    vector<T> msg_v(graph.n_edges()), msg_c(graph.n_edges(), 0), scratch;
+    vector<T> reference(graph.n_edges()), result(graph.n_edges());
+    var_node_update(msg_v, msg_c, received_llrs, graph);
+    for (size_t e = 0; e < msg_v.size(); e += 97) {
+        msg_v[e] = 0;
+    }
+
+    for (int it = 0; it < iterations; ++it) {
+        for (const auto &parameters : min_sum_parameters) {
+            check_node_update_min_sum(reference, msg_v, syndrome, graph, parameters[0], parameters[1]);
+            check_node_update_min_sum_simd(result, msg_v, syndrome, graph, parameters[0], parameters[1], level);
+            deviation.min_sum_mismatches += count_mismatches(result, reference);
+        }
+
+        check_node_update(msg_c, msg_v, syndrome, graph);
+        check_node_update_simd(result, msg_v, syndrome, graph, scratch, level);
+        for (size_t e = 0; e < msg_c.size(); ++e) {
+            const double difference = fabs(static_cast<double>(result[e]) - msg_c[e]);
+            deviation.sum_product = max(deviation.sum_product, difference / max(1.0, fabs(static_cast<double>(msg_c[e]))));
+        }
+
+        var_node_update(msg_v, msg_c, received_llrs, graph);
+        var_node_update_simd(result, msg_c, received_llrs, graph, level);
+        deviation.var_mismatches += count_mismatches(result, msg_v);
+    }
+}
+
+
+/**
+ * @brief compares the kernels of every SIMD level of the CPU on the frames of one code
+ * @tparam T message type (float or double)
+ * @param code the code
+ * @param received received words of the frames
+ * @param syndromes syndromes of the frames
+ * @param p crossover probability of the frames
+ * @param tolerance largest accepted sum-product deviation
+ * @return true if every level passed
+ */
+template<typename T>
+static bool check_levels(const LdpcCode &code,
+                         const vector<vector<bool>> &received,
+                         const vector<vector<bool>> &syndromes,
+                         const double p,
+                         const double tolerance) {
+    const int iterations = 5;
+    const SimdLevel detected = detect_simd_level();
+    bool passed = true;
+    for (const SimdLevel level : {SimdLevel::scalar, SimdLevel::avx2, SimdLevel::avx512}) {
+        if (static_cast<int>(level) > static_cast<int>(detected)) {
+            continue;
+        }
+        KernelDeviation deviation;
+        vector<T> llrs;
+        for (size_t f = 0; f < received.size(); ++f) {
+            bsc_llr(received[f], p, llrs);
+            compare_kernels(code, llrs, syndromes[f], level, iterations, deviation);
+        }
+        const bool level_passed = deviation.sum_product <= tolerance && deviation.min_sum_mismatches == 0
+                                  && deviation.var_mismatches == 0;
+        cout << "  " << (sizeof(T) == sizeof(float) ? "float " : "double ") << simd_level_name(level)
+             << ": sum-product deviation " << deviation.sum_product << " (tolerance " << tolerance << "), "
+             << deviation.min_sum_mismatches << " min-sum and " << deviation.var_mismatches
+             << " variable node mismatches" << (level_passed ? "" : "  FAILED") << endl;
+        passed &= level_passed;
+    }
+    return passed;
+}
+
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <code>..." << endl;
+        return 2;
+    }
+
+    const double p = 0.012;
+    const size_t n_frames = 4;
+    bool passed = true;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const LdpcCode code = load_ldpc_code(argv[a]);
+            BscChannel channel = make_bsc_channel(p, stream_seed(1, code.n_cols, a));
+            vector<vector<bool>> received(n_frames), syndromes(n_frames);
+            for (size_t f = 0; f < n_frames; ++f) {
+                vector<bool> x(code.n_cols);
+                random_input(x, channel.gen);
+                syndromes[f].resize(code.n_rows);
+                encode(code, x, syndromes[f]);
+                received[f] = x;
+                apply_bsc(channel, received[f]);
+            }
+            cout << argv[a] << ": " << code.n_cols << " columns, " << code.n_rows << " rows" << endl;
+            passed &= check_levels<double>(code, received, syndromes, p, 1e-10);
+            passed &= check_levels<float>(code, received, syndromes, p, 5e-3);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
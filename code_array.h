@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Read-only arrays of an LDPC code. An array either owns its values or borrows them
+from memory kept alive by a shared owner, e.g. a mapped code file, so codes loaded
+from the same file by different processes read the same page-cached copy.
+*/
+
+
+#ifndef INFORMATION_THEORY_CODE_ARRAY_H
+#define INFORMATION_THEORY_CODE_ARRAY_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+
+/**
+ * @brief an immutable array of a code, owned or borrowed
+ *
+ * Copies of an owned array copy the values, copies of a borrowed array share the
+ * borrowed memory and its owner.
+ * @tparam T element type
+ */
+template<typename T>
+class CodeArray {
+public:
+    CodeArray() = default;
+
+    // takes over the values of a vector
+    CodeArray(vector<T> values) : values_(std::move(values)), data_(values_.data()), size_(values_.size()) {}
+
+    CodeArray(const CodeArray &other) { *this = other; }
+
+    CodeArray(CodeArray &&other) noexcept { *this = std::move(other); }
+
+    CodeArray &operator=(const CodeArray &other) {
+        if (this != &other) {
+            values_ = other.values_;
+            owner_ = other.owner_;
+            data_ = owner_ ? other.data_ : values_.data();
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    CodeArray &operator=(CodeArray &&other) noexcept {
+        if (this != &other) {
+            values_ = std::move(other.values_);
+            owner_ = std::move(other.owner_);
+            data_ = owner_ ? other.data_ : values_.data();
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief an array borrowing memory that stays valid as long as owner lives
+     * @param owner keeps the memory alive
+     * @param data first element
+     * @param size number of elements
+     * @return the array
+     */
+    static CodeArray borrow(shared_ptr<const void> owner, const T *data, const size_t size) {
+        CodeArray array;
+        array.owner_ = std::move(owner);
+        array.data_ = data;
+        array.size_ = size;
+        return array;
+    }
+
+    bool borrowed() const { return owner_ != nullptr; }
+
+    const T *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T &operator[](const size_t i) const { return data_[i]; }
+    const T &front() const { return data_[0]; }
+    const T &back() const { return data_[size_ - 1]; }
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+
+private:
+    vector<T> values_;               // the values of an owned array
+    shared_ptr<const void> owner_;   // keeps the memory of a borrowed array alive
+    const T *data_{};
+    size_t size_{};
+};
+
+
+#endif //INFORMATION_THEORY_CODE_ARRAY_H
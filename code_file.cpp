@@ -0,0 +1,432 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Native binary container for LDPC codes, written with plain stdio and read back
+through a read-only mmap.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "code_file.h"
+
+using namespace std;
+
+
+// alignment of every array in the file
+static const size_t section_alignment = 64;
+
+// marker telling the byte order of the host that wrote the file
+static const uint32_t code_file_byte_order = 0x01020304;
+
+
+/**
+ * @brief 64-bit checksum, FNV-1a over 8-byte words with a final avalanche
+ * @param data bytes to hash
+ * @param bytes number of bytes
+ * @return the checksum
+ */
+static uint64_t checksum(const unsigned char *data, const size_t bytes) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+    }
+    for (; i < bytes; ++i) {
+        h = (h ^ data[i]) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+
+/**
+ * @brief checksum of a header, covering everything before the header_checksum field
+ */
+static uint64_t header_checksum(const CodeFileHeader &header) {
+    return checksum(reinterpret_cast<const unsigned char *>(&header), offsetof(CodeFileHeader, header_checksum));
+}
+
+
+/**
+ * @brief expected element size and count of every section
+ */
+static void section_shape(const CodeFileHeader &header, const CodeSection section, size_t &element_bytes,
+                          size_t &count) {
+    const size_t n_cols = header.n_cols, n_rows = header.n_rows, n_edges = header.n_edges;
+    element_bytes = sizeof(uint32_t);
+    switch (section) {
+        case CodeSection::column_pointers:
+        case CodeSection::var_offsets:
+            count = n_cols + 1;
+            break;
+        case CodeSection::check_offsets:
+        case CodeSection::packed_row_offsets:
+            count = n_rows + 1;
+            break;
+        case CodeSection::var_degrees:
+            count = n_cols;
+            break;
+        case CodeSection::check_degrees:
+            count = n_rows;
+            break;
+        case CodeSection::packed_word_index:
+            count = n_rows * header.packed_row_terms;
+            break;
+        case CodeSection::packed_word_mask:
+            element_bytes = sizeof(uint64_t);
+            count = n_rows * header.packed_row_terms;
+            break;
+        default:
+            count = n_edges;
+            break;
+    }
+}
+
+
+/**
+ * @brief start of the raw bytes of every section of a code, in file order
+ */
+static vector<const void *> section_sources(const LdpcCode &code) {
+    const TannerGraph &g = code.graph;
+    const PackedParityCheck &h = code.packed_h;
+    return {code.column_pointers.data(), code.row_index.data(), g.check_offsets.data(), g.check_vars.data(),
+            g.var_offsets.data(), g.var_checks.data(), g.check_to_var_edge.data(), g.var_to_check_edge.data(),
+            code.var_degrees.data(), code.check_degrees.data(), h.word_index.data(), h.word_mask.data(),
+            h.row_offsets.data(), h.row_cols.data()};
+}
+
+
+/**
+ * @brief writes a code to a binary code file
+ * @param code the LDPC code
+ * @param path output file
+ */
+void save_code_file(const LdpcCode &code, const string &path) {
+    CodeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, code_file_magic, sizeof(header.magic));
+    header.version = code_file_version;
+    header.byte_order = code_file_byte_order;
+    header.n_cols = static_cast<uint32_t>(code.n_cols);
+    header.n_rows = static_cast<uint32_t>(code.n_rows);
+    header.n_edges = code.graph.n_edges();
+    header.max_var_degree = code.max_var_degree;
+    header.max_check_degree = code.max_check_degree;
+    header.packed_row_terms = code.packed_h.row_terms;
+
+    // lay the sections out one after the other, each aligned
+    const vector<const void *> sources = section_sources(code);
+    size_t offset = (sizeof(CodeFileHeader) + section_alignment - 1) / section_alignment * section_alignment;
+    const size_t payload_start = offset;
+    for (size_t s = 0; s < sources.size(); ++s) {
+        size_t element_bytes, count;
+        section_shape(header, static_cast<CodeSection>(s), element_bytes, count);
+        header.sections[s].offset = offset;
+        header.sections[s].bytes = element_bytes * count;
+        offset += (header.sections[s].bytes + section_alignment - 1) / section_alignment * section_alignment;
+    }
+    header.file_bytes = offset;
+
+    vector<unsigned char> payload(offset - payload_start, 0);
+    for (size_t s = 0; s < sources.size(); ++s) {
+        if (header.sections[s].bytes) {
+            memcpy(payload.data() + header.sections[s].offset - payload_start, sources[s], header.sections[s].bytes);
+        }
+    }
+    header.payload_checksum = checksum(payload.data(), payload.size());
+    header.header_checksum = header_checksum(header);
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) {
+        throw runtime_error("can't open " + path + " for writing.");
+    }
+    vector<unsigned char> head(payload_start, 0);
+    memcpy(head.data(), &header, sizeof(header));
+    const bool ok = fwrite(head.data(), 1, head.size(), f) == head.size()
+                    && fwrite(payload.data(), 1, payload.size(), f) == payload.size();
+    if (fclose(f) != 0 || !ok) {
+        throw runtime_error("writing " + path + " failed.");
+    }
+}
+
+
+MappedCodeFile::MappedCodeFile(MappedCodeFile &&other) noexcept : data(other.data), bytes(other.bytes) {
+    other.data = nullptr;
+    other.bytes = 0;
+}
+
+
+MappedCodeFile &MappedCodeFile::operator=(MappedCodeFile &&other) noexcept {
+    if (this != &other) {
+        if (data) {
+            munmap(const_cast<unsigned char *>(data), bytes);
+        }
+        data = other.data;
+        bytes = other.bytes;
+        other.data = nullptr;
+        other.bytes = 0;
+    }
+    return *this;
+}
+
+
+MappedCodeFile::~MappedCodeFile() {
+    if (data) {
+        munmap(const_cast<unsigned char *>(data), bytes);
+    }
+}
+
+
+/**
+ * @brief maps a code file into memory and validates it
+ * @param path code file
+ * @param verify_payload also checksum the arrays, reads the whole file once
+ * @return the mapping
+ */
+MappedCodeFile map_code_file(const string &path, const bool verify_payload) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CodeFileHeader)) {
+        close(fd);
+        throw runtime_error(path + " is too short to be a code file.");
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw runtime_error("can't map " + path + ".");
+    }
+    MappedCodeFile file;
+    file.data = static_cast<const unsigned char *>(addr);
+    file.bytes = st.st_size;
+
+    const CodeFileHeader &header = file.header();
+    if (memcmp(header.magic, code_file_magic, sizeof(header.magic)) != 0) {
+        throw runtime_error(path + " isn't a code file.");
+    }
+    if (header.version != code_file_version || header.byte_order != code_file_byte_order) {
+        throw runtime_error(path + " has an unsupported version or byte order.");
+    }
+    if (header.header_checksum != header_checksum(header)) {
+        throw runtime_error(path + " has a corrupt header.");
+    }
+    if (header.file_bytes != file.bytes) {
+        throw runtime_error(path + " is truncated.");
+    }
+    size_t payload_start = file.bytes;
+    for (size_t s = 0; s < static_cast<size_t>(CodeSection::count); ++s) {
+        size_t element_bytes, count;
+        section_shape(header, static_cast<CodeSection>(s), element_bytes, count);
+        const CodeFileSection &section = header.sections[s];
+        if (section.bytes != element_bytes * count || section.offset % section_alignment != 0
+            || section.offset < sizeof(CodeFileHeader) || section.offset + section.bytes > file.bytes) {
+            throw runtime_error(path + " has an inconsistent section table.");
+        }
+        payload_start = min<size_t>(payload_start, section.offset);
+    }
+    if (verify_payload && header.payload_checksum != checksum(file.data + payload_start, file.bytes - payload_start)) {
+        throw runtime_error(path + " has a corrupt payload.");
+    }
+    return file;
+}
+
+
+/**
+ * @brief one section of a mapped code file as a code array borrowing the mapping
+ */
+template<typename T>
+static CodeArray<T> borrow_section(const shared_ptr<const MappedCodeFile> &file, const CodeSection section) {
+    const CodeFileArray<T> array = code_file_array<T>(*file, section);
+    return CodeArray<T>::borrow(file, array.data, array.size);
+}
+
+
+/**
+ * @brief checks that an array of offsets starts at 0, never decreases and ends at n_edges
+ */
+static bool valid_offsets(const CodeArray<uint32_t> &offsets, const size_t n_edges) {
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != n_edges) {
+        return false;
+    }
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        if (offsets[i] < offsets[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief checks that every entry of an array is below limit
+ */
+static bool valid_indices(const CodeArray<uint32_t> &indices, const size_t limit) {
+    for (const uint32_t i : indices) {
+        if (i >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief checks that the degrees are the differences of the offsets and their maximum is max_degree
+ */
+static bool valid_degrees(const CodeArray<uint32_t> &degrees, const CodeArray<uint32_t> &offsets,
+                          const uint32_t max_degree) {
+    uint32_t largest = 0;
+    for (size_t i = 0; i < degrees.size(); ++i) {
+        if (degrees[i] != offsets[i + 1] - offsets[i]) {
+            return false;
+        }
+        largest = max(largest, degrees[i]);
+    }
+    return largest == max_degree;
+}
+
+
+/**
+ * @brief checks the structure of the arrays of a loaded code in O(edges), so that a
+ * corrupt file fails to load instead of sending the decoder out of bounds
+ *
+ * The sizes are fixed by the section table already. The offsets must be monotone
+ * and end at n_edges, every index must be in range, both edge permutations must be
+ * inverse to each other and map every edge to the same check and variable node in
+ * both orders, and the CSC, packed and degree arrays must agree with the graph.
+ * @param code the code
+ * @param path code file, for the error message
+ */
+static void check_code_arrays(const LdpcCode &code, const string &path) {
+    const TannerGraph &g = code.graph;
+    const PackedParityCheck &h = code.packed_h;
+    const size_t n_edges = g.n_edges();
+    auto fail = [&](const string &what) {
+        return runtime_error(path + " has corrupt " + what + ".");
+    };
+
+    if (!valid_offsets(g.check_offsets, n_edges) || !valid_offsets(g.var_offsets, n_edges)) {
+        throw fail("node offsets");
+    }
+    if (!valid_indices(g.check_vars, g.n_cols) || !valid_indices(g.var_checks, g.n_rows)
+        || !valid_indices(g.check_to_var_edge, n_edges) || !valid_indices(g.var_to_check_edge, n_edges)) {
+        throw fail("edges");
+    }
+    for (int c = 0; c < g.n_rows; ++c) {
+        for (uint32_t e = g.check_offsets[c]; e < g.check_offsets[c + 1]; ++e) {
+            const uint32_t j = g.check_to_var_edge[e];
+            if (g.var_to_check_edge[j] != e || g.var_checks[j] != static_cast<uint32_t>(c)) {
+                throw fail("edge permutations");
+            }
+        }
+    }
+    for (int v = 0; v < g.n_cols; ++v) {
+        for (uint32_t j = g.var_offsets[v]; j < g.var_offsets[v + 1]; ++j) {
+            if (g.check_vars[g.var_to_check_edge[j]] != static_cast<uint32_t>(v)) {
+                throw fail("edge permutations");
+            }
+        }
+    }
+    if (!equal(code.column_pointers.begin(), code.column_pointers.end(), g.var_offsets.begin())
+        || !equal(code.row_index.begin(), code.row_index.end(), g.var_checks.begin())) {
+        throw fail("CSC arrays");
+    }
+    if (!valid_degrees(code.var_degrees, g.var_offsets, code.max_var_degree)
+        || !valid_degrees(code.check_degrees, g.check_offsets, code.max_check_degree)) {
+        throw fail("degrees");
+    }
+    if (!equal(h.row_offsets.begin(), h.row_offsets.end(), g.check_offsets.begin())
+        || !equal(h.row_cols.begin(), h.row_cols.end(), g.check_vars.begin())
+        || !valid_indices(h.word_index, packed_words(g.n_cols))) {
+        throw fail("packed parity check matrix");
+    }
+}
+
+
+/**
+ * @brief loads a code from a code file without copying its arrays
+ *
+ * The arrays of the code borrow the mapping of the file, which stays mapped as long
+ * as the code or a copy of it lives, so processes loading the same file share one
+ * page-cached copy. Only the 16-bit edge permutations of small graphs are built.
+ * The structure of the arrays is always checked (one pass over the edges), the
+ * payload checksum only on request.
+ * @param path code file
+ * @param verify_payload also checksum the arrays
+ * @return the LDPC code
+ */
+LdpcCode load_code_file(const string &path, const bool verify_payload) {
+    const shared_ptr<const MappedCodeFile> file = make_shared<const MappedCodeFile>(map_code_file(path, verify_payload));
+    const CodeFileHeader &header = file->header();
+
+    LdpcCode code;
+    code.n_cols = static_cast<int>(header.n_cols);
+    code.n_rows = static_cast<int>(header.n_rows);
+    code.column_pointers = borrow_section<uint32_t>(file, CodeSection::column_pointers);
+    code.row_index = borrow_section<uint32_t>(file, CodeSection::row_index);
+
+    TannerGraph &g = code.graph;
+    g.n_cols = code.n_cols;
+    g.n_rows = code.n_rows;
+    g.check_offsets = borrow_section<uint32_t>(file, CodeSection::check_offsets);
+    g.check_vars = borrow_section<uint32_t>(file, CodeSection::check_vars);
+    g.var_offsets = borrow_section<uint32_t>(file, CodeSection::var_offsets);
+    g.var_checks = borrow_section<uint32_t>(file, CodeSection::var_checks);
+    g.check_to_var_edge = borrow_section<uint32_t>(file, CodeSection::check_to_var_edge);
+    g.var_to_check_edge = borrow_section<uint32_t>(file, CodeSection::var_to_check_edge);
+
+    code.var_degrees = borrow_section<uint32_t>(file, CodeSection::var_degrees);
+    code.check_degrees = borrow_section<uint32_t>(file, CodeSection::check_degrees);
+    code.max_var_degree = header.max_var_degree;
+    code.max_check_degree = header.max_check_degree;
+
+    PackedParityCheck &h = code.packed_h;
+    h.n_cols = code.n_cols;
+    h.n_rows = code.n_rows;
+    h.row_terms = header.packed_row_terms;
+    h.word_index = borrow_section<uint32_t>(file, CodeSection::packed_word_index);
+    h.word_mask = borrow_section<uint64_t>(file, CodeSection::packed_word_mask);
+    h.row_offsets = borrow_section<uint32_t>(file, CodeSection::packed_row_offsets);
+    h.row_cols = borrow_section<uint32_t>(file, CodeSection::packed_row_cols);
+
+    check_code_arrays(code, path);
+    build_narrow_edges(g);
+    return code;
+}
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Native binary container for LDPC codes. One file holds the dimensions, H in CSC
+and CSR form, the edge permutations of the Tanner graph, the degree profiles and
+the packed parity check matrix, so loading a code needs no parsing and no rebuild
+of the derived structures. load_code_file maps the file read-only and the arrays of
+the code borrow the mapping, so processes loading the same file share one
+page-cached copy. All arrays start at 64-byte aligned offsets. The header is
+protected by its own checksum, the arrays by a structural check on every load and
+a second checksum that is only verified on request.
+*/
+
+
+#ifndef INFORMATION_THEORY_CODE_FILE_H
+#define INFORMATION_THEORY_CODE_FILE_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+// magic bytes at the start of a code file
+const char code_file_magic[8] = {'L', 'D', 'P', 'C', 'C', 'O', 'D', 'E'};
+
+// version of the layout, bumped on every incompatible change
+const uint32_t code_file_version = 2;
+
+
+/**
+ * @brief the arrays stored in a code file, in file order
+ */
+enum class CodeSection : uint32_t {
+    column_pointers,     // uint32_t, n_cols + 1
+    row_index,           // uint32_t, n_edges
+    check_offsets,       // uint32_t, n_rows + 1
+    check_vars,          // uint32_t, n_edges
+    var_offsets,         // uint32_t, n_cols + 1
+    var_checks,          // uint32_t, n_edges
+    check_to_var_edge,   // uint32_t, n_edges
+    var_to_check_edge,   // uint32_t, n_edges
+    var_degrees,         // uint32_t, n_cols
+    check_degrees,       // uint32_t, n_rows
+    packed_word_index,   // uint32_t, n_rows * packed_row_terms
+    packed_word_mask,    // uint64_t, n_rows * packed_row_terms
+    packed_row_offsets,  // uint32_t, n_rows + 1
+    packed_row_cols,     // uint32_t, n_edges
+    count
+};
+
+
+/**
+ * @brief position of one array in a code file
+ */
+struct CodeFileSection {
+    uint64_t offset;  // bytes from the start of the file
+    uint64_t bytes;
+};
+
+
+/**
+ * @brief fixed size header at the start of a code file, stored little-endian
+ */
+struct CodeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;         // 0x01020304 as written by the host
+    uint32_t n_cols;
+    uint32_t n_rows;
+    uint64_t n_edges;
+    uint32_t max_var_degree;
+    uint32_t max_check_degree;
+    uint32_t packed_row_terms;
+    uint32_t reserved;
+    CodeFileSection sections[static_cast<size_t>(CodeSection::count)];
+    uint64_t file_bytes;
+    uint64_t payload_checksum;   // over all bytes after the header
+    uint64_t header_checksum;    // over the header up to this field
+};
+
+
+/**
+ * @brief a read-only memory mapping of a code file, unmapped on destruction
+ */
+struct MappedCodeFile {
+    const unsigned char *data{};
+    size_t bytes{};
+
+    MappedCodeFile() = default;
+    MappedCodeFile(const MappedCodeFile &) = delete;
+    MappedCodeFile &operator=(const MappedCodeFile &) = delete;
+    MappedCodeFile(MappedCodeFile &&other) noexcept;
+    MappedCodeFile &operator=(MappedCodeFile &&other) noexcept;
+    ~MappedCodeFile();
+
+    const CodeFileHeader &header() const { return *reinterpret_cast<const CodeFileHeader *>(data); }
+};
+
+
+/**
+ * @brief an array of a mapped code file, valid as long as the mapping
+ */
+template<typename T>
+struct CodeFileArray {
+    const T *data{};
+    size_t size{};
+
+    const T &operator[](const size_t i) const { return data[i]; }
+    const T *begin() const { return data; }
+    const T *end() const { return data + size; }
+};
+
+
+/**
+ * @brief writes a code to a binary code file
+ * @param code the LDPC code
+ * @param path output file
+ */
+void save_code_file(const LdpcCode &code, const string &path);
+
+
+/**
+ * @brief maps a code file into memory and validates it
+ * @param path code file
+ * @param verify_payload also checksum the arrays, reads the whole file once
+ * @return the mapping
+ */
+MappedCodeFile map_code_file(const string &path, bool verify_payload = true);
+
+
+/**
+ * @brief one array of a mapped code file, without copying
+ * @tparam T element type of the section, see CodeSection
+ * @param file the mapping
+ * @param section the array
+ * @return pointer and number of elements
+ */
+template<typename T>
+CodeFileArray<T> code_file_array(const MappedCodeFile &file, const CodeSection section) {
+    const CodeFileSection &s = file.header().sections[static_cast<size_t>(section)];
+    return CodeFileArray<T>{reinterpret_cast<const T *>(file.data + s.offset), s.bytes / sizeof(T)};
+}
+
+
+/**
+ * @brief loads a code from a code file without copying its arrays
+ *
+ * The arrays of the code borrow the mapping of the file, which stays mapped as long
+ * as the code or a copy of it lives, so processes loading the same file share one
+ * page-cached copy. Only the 16-bit edge permutations of small graphs are built.
+ * The structure of the arrays is always checked (one pass over the edges), the
+ * payload checksum only on request.
+ * @param path code file
+ * @param verify_payload also checksum the arrays
+ * @return the LDPC code
+ */
+LdpcCode load_code_file(const string &path, bool verify_payload = false);
+
+
+#endif //INFORMATION_THEORY_CODE_FILE_H
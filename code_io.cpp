@@ -0,0 +1,357 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Reading and writing parity check matrices in the alist and .npy formats.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "code_io.h"
+#include "code_file.h"
+#include "qc_ldpc.h"
+#include "npy.hpp"
+
+using namespace std;
+
+
+// file name suffixes of the .npy pair
+static const string npy_column_pointers_suffix = "_colmn_pointers.npy";
+static const string npy_row_index_suffix = "_row_index.npy";
+
+
+/**
+ * @brief reads unsigned integers separated by whitespace from a stream, in blocks
+ */
+class NumberReader {
+public:
+    explicit NumberReader(istream &in) : in(in), buffer(1 << 16) {}
+
+    /**
+     * @brief reads the next number
+     * @param value output
+     * @return false at the end of the stream
+     */
+    bool next(uint64_t &value) {
+        int c = skip_space();
+        if (c < 0) {
+            return false;
+        }
+        if (c < '0' || c > '9') {
+            throw runtime_error("unexpected character in alist file.");
+        }
+        value = 0;
+        while (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+            ++pos;
+            c = peek();
+        }
+        if (c >= 0 && !isspace(c)) {
+            throw runtime_error("unexpected character in alist file.");
+        }
+        return true;
+    }
+
+    /**
+     * @brief reads the next number, which must exist
+     */
+    uint64_t expect() {
+        uint64_t value;
+        if (!next(value)) {
+            throw runtime_error("alist file ends early.");
+        }
+        return value;
+    }
+
+    /**
+     * @brief reads the next nonzero number, skipping the zero padding of the lists
+     * @return false at the end of the stream
+     */
+    bool next_entry(uint64_t &value) {
+        while (next(value)) {
+            if (value != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    istream &in;
+    vector<char> buffer;
+    size_t pos = 0;
+    size_t end = 0;
+
+    int peek() {
+        if (pos == end) {
+            in.read(buffer.data(), static_cast<streamsize>(buffer.size()));
+            end = static_cast<size_t>(in.gcount());
+            pos = 0;
+            if (end == 0) {
+                return -1;
+            }
+        }
+        return static_cast<unsigned char>(buffer[pos]);
+    }
+
+    int skip_space() {
+        int c = peek();
+        while (c >= 0 && isspace(c)) {
+            ++pos;
+            c = peek();
+        }
+        return c;
+    }
+};
+
+
+/**
+ * @brief reads a parity check matrix in alist format
+ *
+ * The numbers may be split over lines in any way and zero padding of the lists is
+ * skipped. The column lists give H, the row lists are optional and checked against
+ * the columns when present.
+ * @param in the alist text
+ * @return the LDPC code
+ */
+LdpcCode read_alist(istream &in) {
+    NumberReader reader(in);
+    const uint64_t n_cols = reader.expect();
+    const uint64_t n_rows = reader.expect();
+    reader.expect();  // largest column degree
+    reader.expect();  // largest row degree
+    if (n_rows > INT32_MAX || n_cols > INT32_MAX) {
+        throw runtime_error("alist matrix is too large.");
+    }
+
+    vector<uint32_t> column_pointers(n_cols + 1, 0);
+    for (uint64_t col = 0; col < n_cols; ++col) {
+        column_pointers[col + 1] = column_pointers[col] + static_cast<uint32_t>(reader.expect());
+    }
+    vector<uint32_t> row_degrees(n_rows);
+    uint64_t row_edges = 0;
+    for (uint64_t row = 0; row < n_rows; ++row) {
+        row_degrees[row] = static_cast<uint32_t>(reader.expect());
+        row_edges += row_degrees[row];
+    }
+    if (row_edges != column_pointers.back()) {
+        throw runtime_error("row and column degrees of the alist file don't match.");
+    }
+
+    // column lists, 1-based row numbers
+    vector<uint32_t> row_index(column_pointers.back());
+    vector<uint32_t> row_counts(n_rows, 0);
+    for (uint64_t col = 0; col < n_cols; ++col) {
+        for (uint32_t e = column_pointers[col]; e < column_pointers[col + 1]; ++e) {
+            uint64_t row;
+            if (!reader.next_entry(row)) {
+                throw runtime_error("alist file ends early.");
+            }
+            if (row > n_rows) {
+                throw runtime_error("row number out of range in alist file.");
+            }
+            row_index[e] = static_cast<uint32_t>(row - 1);
+            row_counts[row - 1]++;
+        }
+        sort(row_index.begin() + column_pointers[col], row_index.begin() + column_pointers[col + 1]);
+        if (adjacent_find(row_index.begin() + column_pointers[col], row_index.begin() + column_pointers[col + 1])
+            != row_index.begin() + column_pointers[col + 1]) {
+            throw runtime_error("repeated entry in a column of the alist file.");
+        }
+    }
+    if (row_counts != row_degrees) {
+        throw runtime_error("row degrees of the alist file don't match its columns.");
+    }
+
+    LdpcCode code = build_ldpc_code(static_cast<int>(n_cols), static_cast<int>(n_rows), column_pointers,
+                                    row_index);
+
+    // row lists, if present they have to list the same entries
+    const TannerGraph &graph = code.graph;
+    vector<uint32_t> row;
+    for (uint32_t r = 0; r < n_rows; ++r) {
+        row.clear();
+        for (uint32_t k = 0; k < row_degrees[r]; ++k) {
+            uint64_t col;
+            if (!reader.next_entry(col)) {
+                if (r == 0 && k == 0) {
+                    return code;
+                }
+                throw runtime_error("alist file ends early.");
+            }
+            if (col == 0 || col > n_cols) {
+                throw runtime_error("column number out of range in alist file.");
+            }
+            row.push_back(static_cast<uint32_t>(col - 1));
+        }
+        sort(row.begin(), row.end());
+        if (!equal(row.begin(), row.end(), graph.check_vars.begin() + graph.check_offsets[r])) {
+            throw runtime_error("row lists of the alist file don't match its columns.");
+        }
+    }
+    return code;
+}
+
+
+/**
+ * @brief reads a parity check matrix from an alist file
+ * @param path alist file
+ * @return the LDPC code
+ */
+LdpcCode read_alist(const string &path) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    return read_alist(in);
+}
+
+
+/**
+ * @brief size in bytes of the entries of a .npy file
+ */
+static unsigned int npy_item_size(const string &path) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    return npy::parse_header(npy::read_header(in)).dtype.itemsize;
+}
+
+
+/**
+ * @brief builds the code from column pointers and row indices of either width
+ */
+template<typename RowIndex>
+static LdpcCode load_npy_code(vector<uint32_t> column_pointers, const string &row_index_path, int n_rows) {
+    vector<unsigned long> shape;
+    bool fortran_order;
+    vector<RowIndex> row_index;
+    npy::LoadArrayFromNumpy(row_index_path, shape, fortran_order, row_index);
+    if (column_pointers.empty() || column_pointers.back() != row_index.size()) {
+        throw runtime_error("column pointers and row indices don't match.");
+    }
+    if (n_rows == 0 && !row_index.empty()) {
+        n_rows = static_cast<int>(*max_element(row_index.begin(), row_index.end())) + 1;
+    }
+    const int n_cols = static_cast<int>(column_pointers.size() - 1);
+    return build_ldpc_code(n_cols, n_rows, std::move(column_pointers), row_index);
+}
+
+
+/**
+ * @brief loads a code from the .npy pair of CSC arrays
+ * @param column_pointers_path uint32 column pointers
+ * @param row_index_path uint16 or uint32 row indices
+ * @param n_rows number of rows of H, 0 takes the largest row index + 1
+ * @return the LDPC code
+ */
+LdpcCode load_npy_code(const string &column_pointers_path, const string &row_index_path, int n_rows) {
+    vector<unsigned long> shape;
+    bool fortran_order;
+    vector<uint32_t> column_pointers;
+    npy::LoadArrayFromNumpy(column_pointers_path, shape, fortran_order, column_pointers);
+    if (npy_item_size(row_index_path) == sizeof(uint16_t)) {
+        return load_npy_code<uint16_t>(std::move(column_pointers), row_index_path, n_rows);
+    }
+    return load_npy_code<uint32_t>(std::move(column_pointers), row_index_path, n_rows);
+}
+
+
+/**
+ * @brief writes the CSC arrays of a code as <prefix>_colmn_pointers.npy and <prefix>_row_index.npy
+ * @param code the LDPC code
+ * @param prefix path prefix of both files
+ */
+void save_npy_code(const LdpcCode &code, const string &prefix) {
+    const unsigned long column_pointers_shape[] = {code.column_pointers.size()};
+    const unsigned long row_index_shape[] = {code.row_index.size()};
+    npy::SaveArrayAsNumpy(prefix + npy_column_pointers_suffix, false, 1, column_pointers_shape,
+                          code.column_pointers.data());
+    if (code.n_rows <= UINT16_MAX + 1) {
+        // 16-bit row indices as written by the notebook
+        const vector<uint16_t> row_index(code.row_index.begin(), code.row_index.end());
+        npy::SaveArrayAsNumpy(prefix + npy_row_index_suffix, false, 1, row_index_shape, row_index);
+    } else {
+        npy::SaveArrayAsNumpy(prefix + npy_row_index_suffix, false, 1, row_index_shape, code.row_index.data());
+    }
+}
+
+
+/**
+ * @brief tells a QC base matrix file from an alist file by the numbers on its first line
+ * @param path the file
+ * @return true for a base matrix file
+ */
+bool is_qc_base_matrix_file(const string &path) {
+    ifstream in(path);
+    string line;
+    while (getline(in, line) && line.find_first_not_of(" \t\r") == string::npos) {
+    }
+    istringstream numbers(line);
+    size_t count = 0;
+    for (long value; numbers >> value;) {
+        ++count;
+    }
+    return count == 3 && numbers.eof();
+}
+
+
+/**
+ * @brief loads a code from a binary code file, an alist file, a QC base matrix file
+ * (expanded) or the column pointers of a .npy pair (the row indices are taken from the
+ * matching _row_index.npy)
+ * @param path the file
+ * @return the LDPC code
+ */
+LdpcCode load_ldpc_code(const string &path) {
+    char magic[8] = {};
+    {
+        ifstream in(path, ios::binary);
+        if (!in) {
+            throw runtime_error("can't open " + path + ".");
+        }
+        in.read(magic, sizeof(magic));
+    }
+    if (memcmp(magic, code_file_magic, sizeof(magic)) == 0) {
+        return load_code_file(path, false);
+    }
+    if (memcmp(magic, "\x93NUMPY", 6) == 0) {
+        const size_t n = npy_column_pointers_suffix.size();
+        if (path.size() < n || path.compare(path.size() - n, n, npy_column_pointers_suffix) != 0) {
+            throw runtime_error("expected the " + npy_column_pointers_suffix + " file of a .npy pair, got " + path);
+        }
+        return load_npy_code(path, path.substr(0, path.size() - n) + npy_row_index_suffix);
+    }
+    if (is_qc_base_matrix_file(path)) {
+        return expand_qc_code(read_qc_base_matrix(path));
+    }
+    return read_alist(path);
+}
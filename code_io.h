@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Reading and writing parity check matrices: a streaming reader for MacKay's alist
+format that builds the CSC arrays directly, the .npy pair of CSC arrays used by
+the original notebook workflow, and a loader that picks the format of a file from
+its content.
+*/
+
+
+#ifndef INFORMATION_THEORY_CODE_IO_H
+#define INFORMATION_THEORY_CODE_IO_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <string>
+#include <istream>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+/**
+ * @brief reads a parity check matrix in alist format
+ *
+ * The numbers may be split over lines in any way and zero padding of the lists is
+ * skipped. The column lists give H, the row lists are optional and checked against
+ * the columns when present.
+ * @param in the alist text
+ * @return the LDPC code
+ */
+LdpcCode read_alist(istream &in);
+
+
+/**
+ * @brief reads a parity check matrix from an alist file
+ * @param path alist file
+ * @return the LDPC code
+ */
+LdpcCode read_alist(const string &path);
+
+
+/**
+ * @brief loads a code from the .npy pair of CSC arrays
+ * @param column_pointers_path uint32 column pointers
+ * @param row_index_path uint16 or uint32 row indices
+ * @param n_rows number of rows of H, 0 takes the largest row index + 1
+ * @return the LDPC code
+ */
+LdpcCode load_npy_code(const string &column_pointers_path, const string &row_index_path, int n_rows = 0);
+
+
+/**
+ * @brief writes the CSC arrays of a code as <prefix>_colmn_pointers.npy and <prefix>_row_index.npy
+ * @param code the LDPC code
+ * @param prefix path prefix of both files
+ */
+void save_npy_code(const LdpcCode &code, const string &prefix);
+
+
+/**
+ * @brief tells a QC base matrix file (see read_qc_base_matrix) from an alist file: its
+ * first line holds three numbers, base_rows base_cols lifting, that of an alist two
+ * @param path the file
+ * @return true for a base matrix file
+ */
+bool is_qc_base_matrix_file(const string &path);
+
+
+/**
+ * @brief loads a code from a binary code file, an alist file, a QC base matrix file
+ * (expanded) or the column pointers of a .npy pair (the row indices are taken from the
+ * matching _row_index.npy)
+ * @param path the file
+ * @return the LDPC code
+ */
+LdpcCode load_ldpc_code(const string &path);
+
+
+#endif //INFORMATION_THEORY_CODE_IO_H
@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Converts a parity check matrix between formats, e.g. a MacKay alist file into the
+binary code file or the .npy pair of CSC arrays:
+
+    convert_code codes_alist/4095_737_3_101.txt codes/4095_737_101.ldpc
+    convert_code --npy codes_alist/4095_737_3_101.txt codes/4095_737_101
+
+The input may be an alist file, a binary code file or the _colmn_pointers.npy file
+of a .npy pair. With --npy the output is a path prefix for the two .npy files.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include "code_io.h"
+#include "code_file.h"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    const bool npy = argc == 4 && string(argv[1]) == "--npy";
+    if (argc != 3 && !npy) {
+        cerr << "usage: " << argv[0] << " [--npy] <input> <output>" << endl;
+        return 2;
+    }
+    const string input = argv[argc - 2];
+    const string output = argv[argc - 1];
+    try {
+        const LdpcCode code = load_ldpc_code(input);
+        if (npy) {
+            save_npy_code(code, output);
+        } else {
+            save_code_file(code, output);
+        }
+        cout << input << ": " << code.n_cols << " columns, " << code.n_rows << " rows, "
+             << code.graph.n_edges() << " edges" << endl;
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
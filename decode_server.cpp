@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Long-running decoder: loads a code once and decodes framed requests from stdin
+(responses on stdout) or from the connections of a Unix socket, see
+decode_service.h for the wire format. Reports go to stderr.
+
+    decode_server codes/4095_737_101.ldpc < requests.bin > responses.bin
+    decode_server --socket /tmp/ldpc.sock --threads 4 --rule normalized_min_sum codes/4095_737_101.ldpc
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <csignal>
+#include <unistd.h>
+#include "code_io.h"
+#include "decode_service.h"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    const string usage = string("usage: ") + argv[0] +
+                         " [--socket <path>] [--threads <n>] [--in-flight <n>] [--rule <rule>]"
+                         " [--layered] [--float] [--iterations <n>] [--report <seconds>] <code>";
+    DecodeServiceConfig config;
+    string socket_path;
+    string code_path;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const string arg = argv[a];
+            auto value = [&]() -> string {
+                if (a + 1 >= argc) {
+                    throw runtime_error(arg + " needs a value.");
+                }
+                return argv[++a];
+            };
+            if (arg == "--socket") {
+                socket_path = value();
+            } else if (arg == "--threads") {
+                config.n_threads = stoul(value());
+            } else if (arg == "--in-flight") {
+                config.frames_in_flight = stoul(value());
+            } else if (arg == "--rule") {
+                config.decoder.rule = check_node_rule_from_name(value());
+            } else if (arg == "--layered") {
+                config.decoder.schedule = Schedule::layered;
+            } else if (arg == "--float") {
+                config.decoder.message_type = MessageType::float32;
+            } else if (arg == "--iterations") {
+                config.decoder.max_num_iter = stoul(value());
+            } else if (arg == "--report") {
+                config.report_seconds = stod(value());
+            } else if (code_path.empty() && arg.compare(0, 2, "--") != 0) {
+                code_path = arg;
+            } else {
+                throw runtime_error("unexpected argument " + arg);
+            }
+        }
+        if (code_path.empty()) {
+            throw runtime_error("no code given.");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl << usage << endl;
+        return 2;
+    }
+
+    // a client that disconnects must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    try {
+        const LdpcCode code = load_ldpc_code(code_path);
+        cerr << code_path << ": " << code.n_cols << " columns, " << code.n_rows << " rows, "
+             << code.graph.n_edges() << " edges" << endl;
+        DecodeService service(code, config);
+        if (socket_path.empty()) {
+            service.serve(STDIN_FILENO, STDOUT_FILENO);
+            cerr << service.report() << endl;
+        } else {
+            service.serve_unix_socket(socket_path);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
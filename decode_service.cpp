@@ -0,0 +1,450 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Streaming decode service: the pipeline stages, the framing of requests and
+responses on file descriptors and the Unix socket listener.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "decode_service.h"
+
+using namespace std;
+
+static_assert(sizeof(DecodeRequestHeader) == 24, "DecodeRequestHeader must not have padding");
+static_assert(sizeof(DecodeResponseHeader) == 32, "DecodeResponseHeader must not have padding");
+
+
+/**
+ * @brief one frame on its way through the pipeline, the buffers keep their capacity
+ * when the job is recycled
+ */
+struct DecodeJob {
+    uint64_t sequence{};               // position in the stream, responses are written in this order
+    DecodeRequestHeader request{};
+    DecodeStatus status = DecodeStatus::failure;
+    vector<uint8_t> bytes;             // packed bits as read from or written to the stream
+    vector<bool> syndrome;
+    vector<bool> side_bits;
+    vector<double> llrs;
+    vector<bool> word;                 // decoded word
+    chrono::steady_clock::time_point arrival;
+    uint64_t decode_ns{};
+};
+
+
+/**
+ * @brief records one duration
+ * @param ns duration in nanoseconds
+ */
+void LatencyHistogram::record(const uint64_t ns) {
+    const size_t bucket = ns <= 1 ? 0 : static_cast<size_t>(std::log2(static_cast<double>(ns)) * 16);
+    ++counts[min(bucket, n_buckets - 1)];
+    ++total;
+    largest = std::max(largest, ns);
+}
+
+
+/**
+ * @brief a quantile of the recorded durations, geometric center of its bucket
+ * @param q the quantile, e.g. 0.5 or 0.99
+ * @return the duration in nanoseconds, 0 if nothing was recorded
+ */
+double LatencyHistogram::quantile(const double q) const {
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * total)));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < n_buckets; ++b) {
+        seen += counts[b];
+        if (seen >= rank) {
+            return std::min(std::exp2((b + 0.5) / 16), static_cast<double>(largest));
+        }
+    }
+    return largest;
+}
+
+
+/**
+ * @brief reads exactly n bytes
+ * @param fd file descriptor
+ * @param data output
+ * @param n number of bytes
+ * @return false if the stream ended before the first byte
+ */
+static bool read_full(const int fd, void *data, const size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        const ssize_t got = ::read(fd, static_cast<char *>(data) + done, n - done);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            throw runtime_error(string("can't read request: ") + strerror(errno));
+        }
+        if (got == 0) {
+            if (done == 0) {
+                return false;
+            }
+            throw runtime_error("request stream ends in the middle of a frame.");
+        }
+        done += got;
+    }
+    return true;
+}
+
+
+/**
+ * @brief reads the rest of a frame, which must not end early
+ * @param fd file descriptor
+ * @param data output
+ * @param n number of bytes
+ */
+static void read_frame_part(const int fd, void *data, const size_t n) {
+    if (!read_full(fd, data, n)) {
+        throw runtime_error("request stream ends in the middle of a frame.");
+    }
+}
+
+
+/**
+ * @brief writes exactly n bytes
+ * @param fd file descriptor
+ * @param data the bytes
+ * @param n number of bytes
+ * @return false if the peer is gone or the write failed
+ */
+static bool write_full(const int fd, const void *data, const size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        const ssize_t put = ::write(fd, static_cast<const char *>(data) + done, n - done);
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put <= 0) {
+            return false;
+        }
+        done += put;
+    }
+    return true;
+}
+
+
+/**
+ * @brief unpacks the bytes of a wire frame, bit i is bit i % 8 of byte i / 8
+ */
+static void unpack_wire_bits(const vector<uint8_t> &bytes, vector<bool> &bits) {
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] = (bytes[i / 8] >> (i % 8)) & 1;
+    }
+}
+
+
+/**
+ * @brief packs bits into the bytes of a wire frame, bit i is bit i % 8 of byte i / 8
+ */
+static void pack_wire_bits(const vector<bool> &bits, vector<uint8_t> &bytes) {
+    bytes.assign((bits.size() + 7) / 8, 0);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bytes[i / 8] |= static_cast<uint8_t>(bits[i]) << (i % 8);
+    }
+}
+
+
+/**
+ * @brief nanoseconds between two points in time
+ */
+static uint64_t elapsed_ns(const chrono::steady_clock::time_point from, const chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(to - from).count());
+}
+
+
+/**
+ * @brief prepares the service, the code must outlive it
+ * @param code the LDPC code
+ * @param config service parameters
+ */
+DecodeService::DecodeService(const LdpcCode &code, const DecodeServiceConfig &config)
+        : code(code), config(config) {
+    n_threads = config.n_threads ? config.n_threads : thread::hardware_concurrency();
+    n_threads = std::max(n_threads, 1u);
+    n_jobs = config.frames_in_flight ? config.frames_in_flight : 4 * static_cast<size_t>(n_threads);
+    n_jobs = std::max(n_jobs, static_cast<size_t>(n_threads));
+    if (config.decoder.warm_start) {
+        throw runtime_error("the decode service doesn't support warm starts.");
+    }
+}
+
+
+/**
+ * @brief decodes the requests of one stream until it ends, responses are written
+ * in request order
+ * @param in_fd file descriptor the requests are read from
+ * @param out_fd file descriptor the responses are written to
+ */
+void DecodeService::serve(const int in_fd, const int out_fd) {
+    // the job pool bounds the frames in flight, every queue can hold all of them
+    vector<DecodeJob> jobs(n_jobs);
+    BoundedQueue<DecodeJob *> free_jobs(n_jobs);
+    BoundedQueue<DecodeJob *> to_llr(n_jobs);
+    BoundedQueue<DecodeJob *> to_decode(n_jobs);
+    BoundedQueue<DecodeJob *> to_respond(n_jobs);
+    for (auto &job : jobs) {
+        job.syndrome.resize(code.n_rows);
+        job.side_bits.resize(code.n_cols);
+        job.llrs.resize(code.n_cols);
+        free_jobs.push(&job);
+    }
+    exception_ptr ingest_error;
+
+    // ingest: reads and unpacks the requests, a malformed stream ends the stream
+    thread ingest([&] {
+        try {
+            DecodeJob *job;
+            for (uint64_t sequence = 0; free_jobs.pop(job); ++sequence) {
+                if (!read_full(in_fd, &job->request, sizeof(DecodeRequestHeader))) {
+                    break;
+                }
+                if (job->request.magic != decode_request_magic) {
+                    throw runtime_error("invalid request header.");
+                }
+                job->sequence = sequence;
+                job->status = DecodeStatus::failure;
+
+                job->bytes.resize((code.n_rows + 7) / 8);
+                read_frame_part(in_fd, job->bytes.data(), job->bytes.size());
+                unpack_wire_bits(job->bytes, job->syndrome);
+
+                const auto side = static_cast<SideInformation>(job->request.side_information);
+                if (side == SideInformation::bits) {
+                    job->bytes.resize((code.n_cols + 7) / 8);
+                    read_frame_part(in_fd, job->bytes.data(), job->bytes.size());
+                    unpack_wire_bits(job->bytes, job->side_bits);
+                } else if (side == SideInformation::llrs) {
+                    read_frame_part(in_fd, job->llrs.data(), job->llrs.size() * sizeof(double));
+                } else {
+                    throw runtime_error("unknown side information in request.");
+                }
+                job->arrival = chrono::steady_clock::now();
+                to_llr.push(job);
+            }
+        } catch (...) {
+            ingest_error = current_exception();
+        }
+        to_llr.close();
+    });
+
+    // LLRs of side information bits
+    thread llr_stage([&] {
+        DecodeJob *job;
+        while (to_llr.pop(job)) {
+            if (job->request.side_information == static_cast<uint32_t>(SideInformation::bits)) {
+                const double p = job->request.crossover;
+                if (p > 0 && p < 1) {
+                    bsc_llr(job->side_bits, p, job->llrs);
+                } else {
+                    job->status = DecodeStatus::invalid;
+                }
+            }
+            to_decode.push(job);
+        }
+        to_decode.close();
+    });
+
+    // decoders, one workspace each, the last one to finish closes the response queue
+    atomic<unsigned> running(n_threads);
+    vector<thread> decoders;
+    for (unsigned id = 0; id < n_threads; ++id) {
+        decoders.emplace_back([&] {
+            DecoderWorkspace ws = make_decoder_workspace(code);
+            DecodeJob *job;
+            while (to_decode.pop(job)) {
+                if (job->status != DecodeStatus::invalid) {
+                    const auto start = chrono::steady_clock::now();
+                    try {
+                        const bool success = decode_at_current_rate(code, job->llrs, job->syndrome, ws,
+                                                                    config.decoder);
+                        job->status = success ? DecodeStatus::success : DecodeStatus::failure;
+                        job->word = ws.out;
+                    } catch (const exception &) {
+                        job->status = DecodeStatus::invalid;
+                    }
+                    job->decode_ns = elapsed_ns(start, chrono::steady_clock::now());
+                }
+                if (job->status == DecodeStatus::invalid) {
+                    job->word.assign(code.n_cols, false);
+                    job->decode_ns = 0;
+                }
+                to_respond.push(job);
+            }
+            if (--running == 0) {
+                to_respond.close();
+            }
+        });
+    }
+
+    // response: this thread, restores the request order in a ring of n_jobs slots
+    const auto stream_start = chrono::steady_clock::now();
+    auto last_report = stream_start;
+    vector<DecodeJob *> ring(n_jobs, nullptr);
+    uint64_t next = 0;
+    bool peer_gone = false;
+    DecodeJob *done;
+    while (to_respond.pop(done)) {
+        ring[done->sequence % n_jobs] = done;
+        while (DecodeJob *job = ring[next % n_jobs]) {
+            ring[next % n_jobs] = nullptr;
+            ++next;
+
+            DecodeResponseHeader response{};
+            response.magic = decode_response_magic;
+            response.status = static_cast<uint32_t>(job->status);
+            response.id = job->request.id;
+            response.decode_ns = job->decode_ns;
+            pack_wire_bits(job->word, job->bytes);
+            response.latency_ns = elapsed_ns(job->arrival, chrono::steady_clock::now());
+            // without a reader the remaining frames are still decoded and dropped
+            if (!peer_gone) {
+                peer_gone = !write_full(out_fd, &response, sizeof(response)) ||
+                            !write_full(out_fd, job->bytes.data(), job->bytes.size());
+            }
+
+            ++totals.frames;
+            totals.successes += job->status == DecodeStatus::success;
+            totals.invalid += job->status == DecodeStatus::invalid;
+            totals.latency.record(response.latency_ns);
+            if (job->status != DecodeStatus::invalid) {
+                totals.decode.record(job->decode_ns);
+            }
+            free_jobs.push(job);
+        }
+
+        const auto now = chrono::steady_clock::now();
+        if (config.report_seconds > 0 && chrono::duration<double>(now - last_report).count() >= config.report_seconds) {
+            busy_seconds += chrono::duration<double>(now - last_report).count();
+            last_report = now;
+            cerr << report() << endl;
+        }
+    }
+    busy_seconds += chrono::duration<double>(chrono::steady_clock::now() - last_report).count();
+
+    free_jobs.close();
+    ingest.join();
+    llr_stage.join();
+    for (auto &t : decoders) {
+        t.join();
+    }
+    if (ingest_error) {
+        rethrow_exception(ingest_error);
+    }
+}
+
+
+/**
+ * @brief listens on a Unix socket and serves one connection after the other
+ * @param socket_path path of the socket, an existing socket file is replaced
+ */
+void DecodeService::serve_unix_socket(const string &socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("socket path is too long: " + socket_path);
+    }
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    struct stat existing{};
+    if (::stat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            throw runtime_error(socket_path + " exists and is not a socket.");
+        }
+        ::unlink(socket_path.c_str());
+    }
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw runtime_error(string("can't create socket: ") + strerror(errno));
+    }
+    if (::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, 16) != 0) {
+        const string error = strerror(errno);
+        ::close(listener);
+        throw runtime_error("can't listen on " + socket_path + ": " + error);
+    }
+
+    for (;;) {
+        const int connection = ::accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const string error = strerror(errno);
+            ::close(listener);
+            throw runtime_error("can't accept connection: " + error);
+        }
+        // a broken stream only ends its own connection
+        try {
+            serve(connection, connection);
+        } catch (const exception &e) {
+            cerr << e.what() << endl;
+        }
+        ::close(connection);
+        cerr << report() << endl;
+    }
+}
+
+
+/**
+ * @brief one line with frame counts, throughput and latency percentiles
+ * @return the report
+ */
+string DecodeService::report() const {
+    ostringstream out;
+    out << fixed << setprecision(1);
+    out << totals.frames << " frames, " << totals.successes << " decoded, " << totals.invalid << " invalid, "
+        << (busy_seconds > 0 ? totals.frames / busy_seconds : 0.) << " frames/s"
+        << ", latency p50 " << totals.latency.quantile(0.5) / 1e3 << " us"
+        << " p99 " << totals.latency.quantile(0.99) / 1e3 << " us"
+        << " max " << totals.latency.maximum() / 1e3 << " us"
+        << ", decode p50 " << totals.decode.quantile(0.5) / 1e3 << " us"
+        << " p99 " << totals.decode.quantile(0.99) / 1e3 << " us";
+    return out.str();
+}
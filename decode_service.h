@@ -0,0 +1,269 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Streaming decode service. A long-running decoder loads the code once and decodes
+framed requests from a byte stream (stdin or a Unix socket connection) in a steady
+flow. Each frame passes through a pipeline of threads:
+
+    ingest -> LLR -> decode (n_threads workers) -> response
+
+joined by bounded queues. The frames in flight are a fixed pool of jobs that is
+recycled, so the pipeline allocates nothing in steady state and the ingest stage
+stops reading when every job is taken, which pushes back on the sender. Responses
+are written in request order.
+
+Wire format, all integers in host byte order, bit i of a bit vector is bit i % 8 of
+byte i / 8:
+
+    request:  DecodeRequestHeader, syndrome (n_rows bits), then the side information,
+              either n_cols bits with header.crossover or n_cols doubles (LLRs)
+    response: DecodeResponseHeader, decoded word (n_cols bits)
+*/
+
+
+#ifndef INFORMATION_THEORY_DECODE_SERVICE_H
+#define INFORMATION_THEORY_DECODE_SERVICE_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+// first word of every request and response
+const uint32_t decode_request_magic = 0x5152444c;   // "LDRQ"
+const uint32_t decode_response_magic = 0x5352444c;  // "LDRS"
+
+
+/**
+ * @brief the form of the side information of a request
+ */
+enum class SideInformation : uint32_t {
+    bits = 0,                          // n_cols bits, turned into LLRs with bsc_llr and the crossover
+    llrs = 1                           // n_cols doubles, used as they are
+};
+
+
+/**
+ * @brief outcome of a request
+ */
+enum class DecodeStatus : uint32_t {
+    failure = 0,                       // the decoder hit the iteration cap or diverged
+    success = 1,                       // the decoded word matches the syndrome
+    invalid = 2                        // the request was rejected (e.g. crossover outside (0, 1)), word is zero
+};
+
+
+/**
+ * @brief header of a request, followed by the syndrome and the side information
+ */
+struct DecodeRequestHeader {
+    uint32_t magic;                    // decode_request_magic
+    uint32_t side_information;         // SideInformation
+    uint64_t id;                       // chosen by the client, echoed in the response
+    double crossover;                  // BSC crossover probability of side information bits
+};
+
+
+/**
+ * @brief header of a response, followed by the decoded word
+ */
+struct DecodeResponseHeader {
+    uint32_t magic;                    // decode_response_magic
+    uint32_t status;                   // DecodeStatus
+    uint64_t id;                       // id of the request
+    uint64_t decode_ns;                // time spent in the decoder
+    uint64_t latency_ns;               // time from reading the request to writing the response
+};
+
+
+/**
+ * @brief a queue of fixed capacity shared by threads, push blocks while the queue is
+ * full and pop while it is empty, until the queue is closed
+ * @tparam T element type
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    /**
+     * @brief appends an element, waiting for space
+     * @param value the element
+     * @return false if the queue was closed, the element is dropped
+     */
+    bool push(T value) {
+        unique_lock<mutex> lock(m);
+        not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(value));
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief takes the oldest element, waiting for one
+     * @param value output
+     * @return false once the queue is closed and empty
+     */
+    bool pop(T &value) {
+        unique_lock<mutex> lock(m);
+        not_empty.wait(lock, [&] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        value = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief wakes up all waiting threads, later pushes fail, pops drain what is left
+     */
+    void close() {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+private:
+    const size_t capacity;
+    deque<T> items;
+    bool closed = false;
+    mutex m;
+    condition_variable not_full;
+    condition_variable not_empty;
+};
+
+
+/**
+ * @brief histogram of durations with logarithmic buckets (16 per octave, about 4%
+ * resolution) from 1 ns to about 18 minutes, for percentiles of an endless stream
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram() : counts(n_buckets) {}
+
+    /**
+     * @brief records one duration
+     * @param ns duration in nanoseconds
+     */
+    void record(uint64_t ns);
+
+    /**
+     * @brief a quantile of the recorded durations, geometric center of its bucket
+     * @param q the quantile, e.g. 0.5 or 0.99
+     * @return the duration in nanoseconds, 0 if nothing was recorded
+     */
+    double quantile(double q) const;
+
+    uint64_t count() const { return total; }
+
+    uint64_t maximum() const { return largest; }
+
+private:
+    static const size_t n_buckets = 16 * 40;
+    vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t largest = 0;
+};
+
+
+/**
+ * @brief counters and latency distributions of a decode service
+ */
+struct DecodeServiceStats {
+    uint64_t frames = 0;               // responses written
+    uint64_t successes = 0;            // frames that matched their syndrome
+    uint64_t invalid = 0;              // rejected requests
+    LatencyHistogram latency;          // request read to response written
+    LatencyHistogram decode;           // time in the decoder
+};
+
+
+/**
+ * @brief parameters of a decode service
+ */
+struct DecodeServiceConfig {
+    unsigned n_threads = 0;            // decoder threads, 0 uses all hardware threads
+    size_t frames_in_flight = 0;       // jobs in the pipeline, 0 uses 4 per decoder thread
+    double report_seconds = 10;        // print a report to stderr this often, 0 disables
+    DecoderConfig decoder;
+};
+
+
+/**
+ * @brief decodes framed requests on one code, see the file comment for the format
+ */
+class DecodeService {
+public:
+    /**
+     * @brief prepares the service, the code must outlive it
+     * @param code the LDPC code
+     * @param config service parameters
+     */
+    DecodeService(const LdpcCode &code, const DecodeServiceConfig &config);
+
+    /**
+     * @brief decodes the requests of one stream until it ends, responses are written
+     * in request order
+     * @param in_fd file descriptor the requests are read from
+     * @param out_fd file descriptor the responses are written to
+     */
+    void serve(int in_fd, int out_fd);
+
+    /**
+     * @brief listens on a Unix socket and serves one connection after the other
+     * @param socket_path path of the socket, an existing socket file is replaced
+     */
+    void serve_unix_socket(const string &socket_path);
+
+    const DecodeServiceStats &stats() const { return totals; }
+
+    /**
+     * @brief one line with frame counts, throughput and latency percentiles
+     * @return the report
+     */
+    string report() const;
+
+private:
+    const LdpcCode &code;
+    DecodeServiceConfig config;
+    unsigned n_threads;
+    size_t n_jobs;
+    DecodeServiceStats totals;
+    double busy_seconds = 0;           // time spent serving streams, for the throughput
+};
+
+
+#endif //INFORMATION_THEORY_DECODE_SERVICE_H
@@ -0,0 +1,282 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Aggregated decoder statistics and their JSON and .npy export.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include "decoder_statistics.h"
+#include "npy.hpp"
+
+using namespace std;
+
+
+/**
+ * @brief adds one frame
+ * @param frame the statistics of the frame
+ */
+void DecoderStatisticsSummary::add(const FrameStatistics &frame) {
+    ++frames;
+    if (iteration_histogram.size() <= frame.iterations) {
+        iteration_histogram.resize(frame.iterations + 1);
+    }
+    ++iteration_histogram[frame.iterations];
+    ++terminations[static_cast<size_t>(frame.termination)];
+
+    if (unsatisfied_sum.size() < frame.unsatisfied.size()) {
+        unsatisfied_sum.resize(frame.unsatisfied.size());
+        unsatisfied_frames.resize(frame.unsatisfied.size());
+    }
+    for (size_t k = 0; k < frame.unsatisfied.size(); ++k) {
+        unsatisfied_sum[k] += frame.unsatisfied[k];
+        ++unsatisfied_frames[k];
+    }
+
+    check_node_seconds += frame.check_node_seconds;
+    var_node_seconds += frame.var_node_seconds;
+    hard_decision_seconds += frame.hard_decision_seconds;
+    syndrome_check_seconds += frame.syndrome_check_seconds;
+}
+
+
+/**
+ * @brief adds the frames of another summary
+ * @param other the summary
+ */
+void DecoderStatisticsSummary::merge(const DecoderStatisticsSummary &other) {
+    frames += other.frames;
+    if (iteration_histogram.size() < other.iteration_histogram.size()) {
+        iteration_histogram.resize(other.iteration_histogram.size());
+    }
+    for (size_t k = 0; k < other.iteration_histogram.size(); ++k) {
+        iteration_histogram[k] += other.iteration_histogram[k];
+    }
+    for (size_t t = 0; t < terminations.size(); ++t) {
+        terminations[t] += other.terminations[t];
+    }
+    if (unsatisfied_sum.size() < other.unsatisfied_sum.size()) {
+        unsatisfied_sum.resize(other.unsatisfied_sum.size());
+        unsatisfied_frames.resize(other.unsatisfied_sum.size());
+    }
+    for (size_t k = 0; k < other.unsatisfied_sum.size(); ++k) {
+        unsatisfied_sum[k] += other.unsatisfied_sum[k];
+        unsatisfied_frames[k] += other.unsatisfied_frames[k];
+    }
+    check_node_seconds += other.check_node_seconds;
+    var_node_seconds += other.var_node_seconds;
+    hard_decision_seconds += other.hard_decision_seconds;
+    syndrome_check_seconds += other.syndrome_check_seconds;
+}
+
+
+/**
+ * @brief mean number of iterations per frame
+ * @return the mean, 0 without frames
+ */
+double DecoderStatisticsSummary::mean_iterations() const {
+    double sum = 0;
+    for (size_t k = 0; k < iteration_histogram.size(); ++k) {
+        sum += static_cast<double>(k) * iteration_histogram[k];
+    }
+    return frames ? sum / frames : 0.;
+}
+
+
+/**
+ * @brief quantile of the iterations per frame, e.g. 0.99 for an iteration cap
+ * that stops 1% of the frames early
+ * @param q the quantile
+ * @return the smallest k with at least q of the frames stopped after k iterations
+ */
+size_t DecoderStatisticsSummary::iteration_quantile(const double q) const {
+    uint64_t seen = 0;
+    for (size_t k = 0; k < iteration_histogram.size(); ++k) {
+        seen += iteration_histogram[k];
+        if (seen >= q * frames) {
+            return k;
+        }
+    }
+    return iteration_histogram.empty() ? 0 : iteration_histogram.size() - 1;
+}
+
+
+/**
+ * @brief name of a termination reason, for printing
+ * @param termination the reason
+ * @return the name
+ */
+const char *termination_name(const Termination termination) {
+    switch (termination) {
+        case Termination::converged: return "converged";
+        case Termination::max_iterations: return "max_iterations";
+        case Termination::diverged: return "diverged";
+    }
+    return "unknown";
+}
+
+
+/**
+ * @brief writes a JSON array of numbers
+ */
+template<typename T>
+static void write_json_array(ostream &out, const vector<T> &values) {
+    out << '[';
+    for (size_t k = 0; k < values.size(); ++k) {
+        out << (k ? ", " : "") << values[k];
+    }
+    out << ']';
+}
+
+
+/**
+ * @brief writes the statistics of sweep points as JSON
+ * @param path the file
+ * @param p_values crossover probability of each point
+ * @param points statistics of each point
+ */
+void write_statistics_json(const string &path,
+                           const vector<double> &p_values,
+                           const vector<DecoderStatisticsSummary> &points) {
+    if (p_values.size() != points.size()) {
+        throw runtime_error("crossover probabilities don't match the statistics.");
+    }
+    ofstream out(path);
+    if (!out) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    out.precision(17);
+
+    out << "{\n  \"points\": [";
+    for (size_t i = 0; i < points.size(); ++i) {
+        const DecoderStatisticsSummary &s = points[i];
+        vector<double> unsatisfied_mean(s.unsatisfied_sum.size());
+        for (size_t k = 0; k < unsatisfied_mean.size(); ++k) {
+            unsatisfied_mean[k] = s.unsatisfied_sum[k] / s.unsatisfied_frames[k];
+        }
+
+        out << (i ? "," : "") << "\n    {\n";
+        out << "      \"p\": " << p_values[i] << ",\n";
+        out << "      \"frames\": " << s.frames << ",\n";
+        out << "      \"terminations\": {";
+        for (size_t t = 0; t < s.terminations.size(); ++t) {
+            out << (t ? ", " : "") << '"' << termination_name(static_cast<Termination>(t)) << "\": "
+                << s.terminations[t];
+        }
+        out << "},\n";
+        out << "      \"mean_iterations\": " << s.mean_iterations() << ",\n";
+        out << "      \"iterations_p50\": " << s.iteration_quantile(0.5) << ",\n";
+        out << "      \"iterations_p90\": " << s.iteration_quantile(0.9) << ",\n";
+        out << "      \"iterations_p99\": " << s.iteration_quantile(0.99) << ",\n";
+        out << "      \"iteration_histogram\": ";
+        write_json_array(out, s.iteration_histogram);
+        out << ",\n      \"unsatisfied_mean\": ";
+        write_json_array(out, unsatisfied_mean);
+        out << ",\n      \"unsatisfied_frames\": ";
+        write_json_array(out, s.unsatisfied_frames);
+        out << ",\n      \"seconds\": {\"check_node\": " << s.check_node_seconds
+            << ", \"var_node\": " << s.var_node_seconds
+            << ", \"hard_decision\": " << s.hard_decision_seconds
+            << ", \"syndrome_check\": " << s.syndrome_check_seconds << "}\n    }";
+    }
+    out << "\n  ]\n}\n";
+    if (!out) {
+        throw runtime_error("can't write " + path + ".");
+    }
+}
+
+
+/**
+ * @brief stacks per-point rows of different lengths into a row-major matrix, padded with zeros
+ */
+template<typename T, typename Row>
+static vector<T> stack_rows(const vector<DecoderStatisticsSummary> &points, Row row, size_t &width) {
+    width = 0;
+    for (const auto &s : points) {
+        width = max(width, row(s).size());
+    }
+    vector<T> matrix(points.size() * width);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const auto values = row(points[i]);
+        copy(values.begin(), values.end(), matrix.begin() + i * width);
+    }
+    return matrix;
+}
+
+
+/**
+ * @brief writes the statistics of sweep points as .npy arrays, one row per point
+ * @param prefix path prefix of the files
+ * @param p_values crossover probability of each point
+ * @param points statistics of each point
+ */
+void save_statistics_npy(const string &prefix,
+                         const vector<double> &p_values,
+                         const vector<DecoderStatisticsSummary> &points) {
+    if (p_values.size() != points.size()) {
+        throw runtime_error("crossover probabilities don't match the statistics.");
+    }
+    const unsigned long n_points = points.size();
+    size_t width;
+
+    const unsigned long p_shape[] = {n_points};
+    npy::SaveArrayAsNumpy(prefix + "_p.npy", false, 1, p_shape, p_values);
+
+    const vector<uint64_t> iterations = stack_rows<uint64_t>(points, [](const DecoderStatisticsSummary &s) {
+        return s.iteration_histogram;
+    }, width);
+    const unsigned long iterations_shape[] = {n_points, width};
+    npy::SaveArrayAsNumpy(prefix + "_iterations.npy", false, 2, iterations_shape, iterations);
+
+    const vector<uint64_t> terminations = stack_rows<uint64_t>(points, [](const DecoderStatisticsSummary &s) {
+        return s.terminations;
+    }, width);
+    const unsigned long terminations_shape[] = {n_points, width};
+    npy::SaveArrayAsNumpy(prefix + "_terminations.npy", false, 2, terminations_shape, terminations);
+
+    const vector<double> unsatisfied = stack_rows<double>(points, [](const DecoderStatisticsSummary &s) {
+        vector<double> mean(s.unsatisfied_sum.size());
+        for (size_t k = 0; k < mean.size(); ++k) {
+            mean[k] = s.unsatisfied_sum[k] / s.unsatisfied_frames[k];
+        }
+        return mean;
+    }, width);
+    const unsigned long unsatisfied_shape[] = {n_points, width};
+    npy::SaveArrayAsNumpy(prefix + "_unsatisfied.npy", false, 2, unsatisfied_shape, unsatisfied);
+
+    const vector<uint64_t> unsatisfied_frames = stack_rows<uint64_t>(points, [](const DecoderStatisticsSummary &s) {
+        return s.unsatisfied_frames;
+    }, width);
+    npy::SaveArrayAsNumpy(prefix + "_unsatisfied_frames.npy", false, 2, unsatisfied_shape, unsatisfied_frames);
+
+    const vector<double> seconds = stack_rows<double>(points, [](const DecoderStatisticsSummary &s) {
+        return vector<double>{s.check_node_seconds, s.var_node_seconds, s.hard_decision_seconds,
+                              s.syndrome_check_seconds};
+    }, width);
+    const unsigned long seconds_shape[] = {n_points, width};
+    npy::SaveArrayAsNumpy(prefix + "_phase_seconds.npy", false, 2, seconds_shape, seconds);
+}
@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Aggregated decoder statistics: the FrameStatistics of many frames (see
+encoding_decoding.h) summed into a histogram of the iterations to the stop, counts
+of the termination reasons, the mean syndrome-weight trajectory and the time per
+decoder phase, with export to JSON and .npy for sizing iteration caps and thread
+pools from the actual iteration distribution.
+*/
+
+
+#ifndef INFORMATION_THEORY_DECODER_STATISTICS_H
+#define INFORMATION_THEORY_DECODER_STATISTICS_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+/**
+ * @brief statistics of a set of frames, e.g. one sweep point
+ */
+struct DecoderStatisticsSummary {
+    size_t frames = 0;
+    vector<uint64_t> iteration_histogram;  // [k] frames that stopped after k iterations
+    vector<uint64_t> terminations = vector<uint64_t>(3);  // frames per Termination
+    vector<double> unsatisfied_sum;    // [k] sum of the unsatisfied checks after iteration k + 1
+    vector<uint64_t> unsatisfied_frames;  // [k] frames that ran iteration k + 1
+    double check_node_seconds = 0;
+    double var_node_seconds = 0;
+    double hard_decision_seconds = 0;
+    double syndrome_check_seconds = 0;
+
+    /**
+     * @brief adds one frame
+     * @param frame the statistics of the frame
+     */
+    void add(const FrameStatistics &frame);
+
+    /**
+     * @brief adds the frames of another summary
+     * @param other the summary
+     */
+    void merge(const DecoderStatisticsSummary &other);
+
+    /**
+     * @brief mean number of iterations per frame
+     * @return the mean, 0 without frames
+     */
+    double mean_iterations() const;
+
+    /**
+     * @brief quantile of the iterations per frame, e.g. 0.99 for an iteration cap
+     * that stops 1% of the frames early
+     * @param q the quantile
+     * @return the smallest k with at least q of the frames stopped after k iterations
+     */
+    size_t iteration_quantile(double q) const;
+};
+
+
+/**
+ * @brief name of a termination reason, for printing
+ * @param termination the reason
+ * @return the name
+ */
+const char *termination_name(Termination termination);
+
+
+/**
+ * @brief writes the statistics of sweep points as JSON
+ *
+ * One object per point with p, frames, terminations, mean and 50/90/99% iterations,
+ * the iteration histogram, the mean unsatisfied checks of the frames still running
+ * after every iteration with their number, and the seconds per phase.
+ * @param path the file
+ * @param p_values crossover probability of each point
+ * @param points statistics of each point
+ */
+void write_statistics_json(const string &path,
+                           const vector<double> &p_values,
+                           const vector<DecoderStatisticsSummary> &points);
+
+
+/**
+ * @brief writes the statistics of sweep points as .npy arrays, one row per point:
+ * <prefix>_p.npy, _iterations.npy (histograms), _terminations.npy (converged,
+ * max_iterations, diverged), _unsatisfied.npy (mean trajectories, 0 past the last
+ * iteration), _unsatisfied_frames.npy and _phase_seconds.npy (check node, variable
+ * node, hard decision, syndrome check)
+ * @param prefix path prefix of the files
+ * @param p_values crossover probability of each point
+ * @param points statistics of each point
+ */
+void save_statistics_npy(const string &prefix,
+                         const vector<double> &p_values,
+                         const vector<DecoderStatisticsSummary> &points);
+
+
+#endif //INFORMATION_THEORY_DECODER_STATISTICS_H
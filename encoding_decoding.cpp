@@ -30,14 +30,19 @@ header file for the actual decoder implementation
 // Includes
 //----------------------------------------------------------------------
 #include <vector>
+#include <string>
 #include <cmath>
 #include <cstdint>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 #include <numeric>
 #include <random>
 #include <tuple>
+#include <stdexcept>
 #include "encoding_decoding.h"
+#include "simd_kernels.h"
+#include "fixed_point_decoder.h"
 
 using namespace std;
 
@@ -58,104 +63,441 @@ using namespace std;
 
 
 
+/**
+ * @brief parses a check node rule given by name
+ * @param name the name as in CheckNodeRule, e.g. "normalized_min_sum"
+ * @return the rule
+ */
+CheckNodeRule check_node_rule_from_name(const string &name) {
+    if (name == "sum_product") { return CheckNodeRule::sum_product; }
+    if (name == "min_sum") { return CheckNodeRule::min_sum; }
+    if (name == "normalized_min_sum") { return CheckNodeRule::normalized_min_sum; }
+    if (name == "offset_min_sum") { return CheckNodeRule::offset_min_sum; }
+    throw runtime_error("unknown check node rule: " + name);
+}
+
+
+/**
+ * @brief parses a SIMD level given by name
+ * @param name the name as printed by simd_level_name, e.g. "avx2"
+ * @return the level
+ */
+SimdLevel simd_level_from_name(const string &name) {
+    for (const SimdLevel level : {SimdLevel::automatic, SimdLevel::scalar, SimdLevel::avx2, SimdLevel::avx512}) {
+        if (name == simd_level_name(level)) {
+            return level;
+        }
+    }
+    throw runtime_error("unknown SIMD level: " + name);
+}
+
+
+
 /**
  * @brief Tries to decode the given codeword using the given parity check matrix
+ * @param code the LDPC code
  * @param llrs inital log-likelihood ratios
  * @param syndrome The checksum/syndrome of the codeword
- * @param n_cols number of columns of H
- * @param n_rows number of rows of H
- * @param pos_varn List of lists of positions of variable nodes
- * @param pos_checkn List of lists of positions of check nodes
- * @param column_pointers column pointers of H in CSC
- * @param row_index row indices of H in CSC
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
  * @param max_num_iter max number of decoding iterations
  * @param vsat cut-off value for messages
- * @return
+ * @return true if the decoded word matches the syndrome
  */
-tuple<bool, vector<bool>> decode_at_current_rate(const vector<double> &llrs,
-                                                 const vector<bool> &syndrome,
-                                                 const int n_cols,
-                                                 const int n_rows,
-                                                 const vector<vector<int>> &pos_varn,
-                                                 const vector<vector<int>> &pos_checkn,
-                                                 const vector<uint32_t> column_pointers,
-                                                 const vector<uint16_t> row_index,
-                                                 const std::size_t max_num_iter = 50,
-                                                 const double vsat = 100) {
-    // check inputs.
-    if (llrs.size() != n_cols) {
-        throw runtime_error("input doesn't match H.");
+bool decode_at_current_rate(const LdpcCode &code,
+                            const vector<double> &llrs,
+                            const vector<bool> &syndrome,
+                            DecoderWorkspace &ws,
+                            const std::size_t max_num_iter,
+                            const double vsat) {
+    DecoderConfig config;
+    config.max_num_iter = max_num_iter;
+    config.vsat = vsat;
+    return decode_at_current_rate(code, llrs, syndrome, ws, config);
+}
+
+
+/**
+ * @brief the initial LLRs in the message type, double needs no copy
+ * @param llrs inital log-likelihood ratios
+ * @param buffers message buffers of the type
+ * @return the LLRs as T
+ */
+static const vector<double> &message_llrs(const vector<double> &llrs, MessageBuffers<double> &) {
+    return llrs;
+}
+
+static const vector<float> &message_llrs(const vector<double> &llrs, MessageBuffers<float> &buffers) {
+    buffers.llrs.resize(llrs.size());
+    for (size_t j{}; j < llrs.size(); ++j) {
+        buffers.llrs[j] = static_cast<float>(llrs[j]);
     }
+    return buffers.llrs;
+}
 
-    if (syndrome.size() != n_rows) {
-        throw runtime_error(
-                "checksum doesn't match number of rows in H");
+
+/**
+ * @brief the flooding decoder for one message type
+ * @tparam T message type (float or double)
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios as T
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code
+ * @param buffers message buffers of ws for T
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+template<typename T>
+static bool decode_flooding(const LdpcCode &code,
+                            const vector<T> &llrs,
+                            const vector<bool> &syndrome,
+                            DecoderWorkspace &ws,
+                            MessageBuffers<T> &buffers,
+                            const DecoderConfig &config) {
+    const TannerGraph &graph = code.graph;
+    auto &msg_v = buffers.msg_v;
+    auto &msg_c = buffers.msg_c;
+    const SimdLevel simd = resolve_simd_level(config.simd);
+
+    double ms_scale, ms_offset;
+    min_sum_parameters(config, ms_scale, ms_offset);
+
+    // initialize msg_v, a warm start keeps the messages of the previous decode
+    if (!config.warm_start) {
+        for (size_t e{}; e < msg_v.size(); ++e) {
+            msg_v[e] = llrs[graph.check_vars[e]];
+        }
     }
+    reset_syndrome_tracking(ws, syndrome);
+    PhaseTimer timer(ws.statistics);
+
+    for (size_t it{}; it < config.max_num_iter; ++it) {
+        if (config.rule == CheckNodeRule::sum_product) {
+            check_node_update_simd(msg_c, msg_v, syndrome, graph, buffers.check_scratch, simd);
+        } else {
+            check_node_update_min_sum_simd(msg_c, msg_v, syndrome, graph, ms_scale, ms_offset, simd);
+        }
+        saturate(msg_c, config.vsat);
+        timer.lap(&FrameStatistics::check_node_seconds);
 
-    vector<bool> out = vector<bool>(llrs.size(), false);
+        var_node_update_simd(msg_v, msg_c, llrs, graph, simd);
+        saturate(msg_v, config.vsat);
+        timer.lap(&FrameStatistics::var_node_seconds);
 
-    vector<vector<double>> msg_v(n_rows);  // messages from variable nodes to check nodes
-    vector<vector<double>> msg_c(n_cols);  // messages from check nodes to variable nodes
+        hard_decision(ws, llrs, msg_c, graph);
+        timer.lap(&FrameStatistics::hard_decision_seconds);
+        record_iteration(ws);
 
-    // initialize msg_v
-    for (size_t i{}; i < msg_v.size(); ++i) {
-        auto &curr_mv = msg_v[i];
-        curr_mv.resize(pos_varn[i].size());
-        for (size_t j{}; j < msg_v[i].size(); ++j) {
-            curr_mv[j] = llrs[pos_varn[i][j]];
+        // terminate decoding if codeword matches syndrome
+        if (ws.n_unsatisfied == 0) {
+            timer.lap(&FrameStatistics::syndrome_check_seconds);
+            return stop_decoding(ws, Termination::converged);
+        }
+
+        // check for diverging decoder
+        for (const auto &v : msg_v) {
+            if (std::isnan(v)) {
+                timer.lap(&FrameStatistics::syndrome_check_seconds);
+                return stop_decoding(ws, Termination::diverged);
+            }
         }
+        timer.lap(&FrameStatistics::syndrome_check_seconds);
     }
 
-    // initialize msg_c
-    for (size_t i{}; i < msg_c.size(); ++i) {
-        msg_c[i].resize(pos_checkn[i].size());
+    return stop_decoding(ws, Termination::max_iterations);  // Decoding was not successful.
+}
+
+
+/**
+ * @brief sum-product update of one check node row, same arithmetic as check_node_update
+ * @tparam T message type (float or double)
+ * @param q incoming variable to check messages of the row
+ * @param r output, outgoing check to variable messages of the row
+ * @param deg degree of the check node
+ * @param syndrome_bit syndrome bit of the check node
+ */
+template<typename T>
+static void check_row_sum_product(const T *q, T *r, const size_t deg, const bool syndrome_bit) {
+    T mc_prod = 1 - 2 * static_cast<T>(syndrome_bit);
+    for (size_t k{}; k < deg; ++k) {
+        mc_prod *= std::tanh(T(0.5) * q[k]);
+    }
+    for (size_t k{}; k < deg; ++k) {
+        const T msg_part = q[k] == 0 ? T(deg > 1 ? 0 : 1) : mc_prod / std::tanh(T(0.5) * q[k]);
+        r[k] = std::log((1 + msg_part) / (1 - msg_part));
     }
+}
 
-    for (size_t it_unused{}; it_unused < max_num_iter; ++it_unused) {
-        check_node_update(msg_c, msg_v, syndrome, pos_varn, pos_checkn, n_cols, n_rows);
-        saturate(msg_c, vsat);
 
-        var_node_update(msg_v, msg_c, llrs, pos_varn, pos_checkn, n_cols);
-        saturate(msg_v, vsat);
+/**
+ * @brief min-sum update of one check node row, same arithmetic as check_node_update_min_sum
+ * @tparam T message type (float or double)
+ * @param q incoming variable to check messages of the row
+ * @param r output, outgoing check to variable messages of the row
+ * @param deg degree of the check node
+ * @param syndrome_bit syndrome bit of the check node
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ */
+template<typename T>
+static void check_row_min_sum(const T *q, T *r, const size_t deg, const bool syndrome_bit,
+                              const T scale, const T offset) {
+    T min1 = numeric_limits<T>::infinity();
+    T min2 = numeric_limits<T>::infinity();
+    size_t min1_pos = 0;
+    bool parity = syndrome_bit;
+    for (size_t k{}; k < deg; ++k) {
+        const T mag = std::abs(q[k]);
+        parity ^= q[k] < 0;
+        if (mag < min1) {
+            min2 = min1;
+            min1 = mag;
+            min1_pos = k;
+        } else if (mag < min2) {
+            min2 = mag;
+        }
+    }
 
-        // hard decision
-        hard_decision(out, llrs, msg_c);
+    const T out1 = min_sum_magnitude(min1, scale, offset);
+    const T out2 = min_sum_magnitude(min2, scale, offset);
+    for (size_t k{}; k < deg; ++k) {
+        const T mag = k == min1_pos ? out2 : out1;
+        r[k] = parity != (q[k] < 0) ? -mag : mag;
+    }
+}
 
-        // terminate decoding if codeword matches syndrome
-        vector<bool> decision_syndrome(syndrome.size());
-        decision_syndrome = encode(out, column_pointers, row_index, n_rows);
-        if (decision_syndrome == syndrome) {
-            return {true, out};
+
+/**
+ * @brief clamps a single value to +/- vsat, same semantics as saturate()
+ */
+template<typename T>
+static inline T saturate_value(T a, const double vsat) {
+    if (a > vsat) { a = vsat; }
+    else if (a < -vsat) { a = -vsat; }
+    return a;
+}
+
+
+/**
+ * @brief the layered decoder for one message type
+ * @tparam T message type (float or double)
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios as T
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code
+ * @param buffers message buffers of ws for T
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+template<typename T>
+static bool decode_layered(const LdpcCode &code,
+                           const vector<T> &llrs,
+                           const vector<bool> &syndrome,
+                           DecoderWorkspace &ws,
+                           MessageBuffers<T> &buffers,
+                           const DecoderConfig &config) {
+    const TannerGraph &graph = code.graph;
+    auto &msg_c = buffers.msg_v;        // check to variable messages, check order
+    auto &posterior = buffers.posterior;
+    auto &q = buffers.check_scratch;    // variable to check messages of the current row
+    if (!config.warm_start) {
+        posterior.assign(llrs.begin(), llrs.end());
+        fill(msg_c.begin(), msg_c.end(), T(0));
+    }
+
+    double ms_scale, ms_offset;
+    min_sum_parameters(config, ms_scale, ms_offset);
+
+    // the hard decision follows the sign of the posteriors
+    reset_syndrome_tracking(ws, syndrome);
+    for (size_t j{}; j < posterior.size(); ++j) {
+        update_decision(ws, graph, j, posterior[j] < 0);
+    }
+
+    PhaseTimer timer(ws.statistics);
+    for (size_t it{}; it < config.max_num_iter; ++it) {
+        for (size_t m{}; m < graph.n_rows; ++m) {
+            const uint32_t begin = graph.check_offsets[m];
+            const uint32_t deg = graph.check_offsets[m + 1] - begin;
+            const uint32_t *vars = &graph.check_vars[begin];
+            T *r = &msg_c[begin];
+
+            // take the old message of this row out of the posteriors
+            for (uint32_t k{}; k < deg; ++k) {
+                q[k] = saturate_value<T>(posterior[vars[k]] - r[k], config.vsat);
+            }
+
+            if (config.rule == CheckNodeRule::sum_product) {
+                check_row_sum_product(q.data(), r, deg, syndrome[m]);
+            } else {
+                check_row_min_sum(q.data(), r, deg, syndrome[m], T(ms_scale), T(ms_offset));
+            }
+
+            // and put the new one back in
+            for (uint32_t k{}; k < deg; ++k) {
+                r[k] = saturate_value(r[k], config.vsat);
+                posterior[vars[k]] = q[k] + r[k];
+                update_decision(ws, graph, vars[k], posterior[vars[k]] < 0);
+            }
+
+            // terminate decoding as soon as the codeword matches the syndrome
+            if (ws.n_unsatisfied == 0) {
+                timer.lap(&FrameStatistics::check_node_seconds);
+                record_iteration(ws);
+                return stop_decoding(ws, Termination::converged);
+            }
         }
+        timer.lap(&FrameStatistics::check_node_seconds);
+        record_iteration(ws);
 
         // check for diverging decoder
-        for (const auto &m : msg_v) {
-            for (const auto &v : m) {
-                if (std::isnan(v)) {
-                    return {false, out};
-                }
+        for (const auto &v : posterior) {
+            if (std::isnan(v)) {
+                timer.lap(&FrameStatistics::syndrome_check_seconds);
+                return stop_decoding(ws, Termination::diverged);
             }
         }
+        timer.lap(&FrameStatistics::syndrome_check_seconds);
+    }
+
+    return stop_decoding(ws, Termination::max_iterations);  // Decoding was not successful.
+}
+
+
+/**
+ * @brief sizes the buffers of T and runs the configured schedule with them
+ * @tparam T message type (float or double)
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+template<typename T>
+static bool decode_messages(const LdpcCode &code,
+                            const vector<double> &llrs,
+                            const vector<bool> &syndrome,
+                            DecoderWorkspace &ws,
+                            const DecoderConfig &config) {
+    MessageBuffers<T> &buffers = message_buffers<T>(ws);
+    buffers.resize(code);
+    const vector<T> &message_llr = message_llrs(llrs, buffers);
+    if (config.schedule == Schedule::layered) {
+        return decode_layered(code, message_llr, syndrome, ws, buffers, config);
+    }
+    return decode_flooding(code, message_llr, syndrome, ws, buffers, config);
+}
+
+
+/**
+ * @brief checks the inputs of the decoder against the code and the workspace
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace
+ */
+static void check_decoder_inputs(const LdpcCode &code,
+                                 const vector<double> &llrs,
+                                 const vector<bool> &syndrome,
+                                 const DecoderWorkspace &ws) {
+    if (llrs.size() != code.n_cols) {
+        throw runtime_error("input doesn't match H.");
+    }
+
+    if (syndrome.size() != code.n_rows) {
+        throw runtime_error(
+                "checksum doesn't match number of rows in H");
+    }
+
+    if (ws.out.size() != code.n_cols || ws.unsatisfied.size() != code.n_rows) {
+        throw runtime_error("decoder workspace doesn't match H.");
+    }
+}
+
+
+/**
+ * @brief Tries to decode the given codeword with the check node rule and limits of config
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_at_current_rate(const LdpcCode &code,
+                            const vector<double> &llrs,
+                            const vector<bool> &syndrome,
+                            DecoderWorkspace &ws,
+                            const DecoderConfig &config) {
+    check_decoder_inputs(code, llrs, syndrome, ws);
+    if (ws.statistics) {
+        ws.statistics->reset();
     }
 
-    return {false, out};  // Decoding was not successful.
+    switch (config.message_type) {
+        case MessageType::fixed_point:
+            return decode_fixed_point(code, llrs, syndrome, ws, config);
+        case MessageType::float32:
+            return decode_messages<float>(code, llrs, syndrome, ws, config);
+        case MessageType::float64:
+            break;
+    }
+    return decode_messages<double>(code, llrs, syndrome, ws, config);
+}
+
+
+/**
+ * @brief Tries to decode the given codeword with the layered (row-serial) schedule
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_layered(const LdpcCode &code,
+                    const vector<double> &llrs,
+                    const vector<bool> &syndrome,
+                    DecoderWorkspace &ws,
+                    const DecoderConfig &config) {
+    DecoderConfig layered = config;
+    layered.schedule = Schedule::layered;
+    return decode_at_current_rate(code, llrs, syndrome, ws, layered);
+}
+
+
+/**
+ * @brief Tries to decode the given codeword, convenience version using a temporary workspace
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param code the LDPC code
+ * @param max_num_iter max number of decoding iterations
+ * @param vsat cut-off value for messages
+ * @return success flag and the decoded word
+ */
+tuple<bool, vector<bool>> decode_at_current_rate(const vector<double> &llrs,
+                                                 const vector<bool> &syndrome,
+                                                 const LdpcCode &code,
+                                                 const std::size_t max_num_iter,
+                                                 const double vsat) {
+    DecoderWorkspace ws = make_decoder_workspace(code);
+    const bool success = decode_at_current_rate(code, llrs, syndrome, ws, max_num_iter, vsat);
+    return {success, std::move(ws.out)};
 }
 
 
 /**
  * @brief caps the values of a vector in both positive and negative direction
- * @tparam T
+ * @tparam T message type (float or double)
  * @param mv The vector to cap
  * @param vsat the limit to cap, +/-
  */
 template<typename T>
-static void saturate(vector<vector<T>> &mv,
+static void saturate(vector<T> &mv,
                      const double vsat) {
-    for (auto &v : mv) {
-        for (auto &a : v) {
-            if (a > vsat) { a = vsat; }
-            else if (a < -vsat) { a = -vsat; }
-        }
+    for (auto &a : mv) {
+        if (a > vsat) { a = vsat; }
+        else if (a < -vsat) { a = -vsat; }
     }
 }
 
@@ -168,8 +510,9 @@ static void saturate(vector<vector<T>> &mv,
  * @param n_rows number of rows of H
  * @return the matrix product (the syndrome)
  */
-vector<bool>  encode(vector<bool> &in, vector<uint32_t> column_pointers,
-                     vector<uint16_t> row_index, uint16_t n_rows) {
+template<typename RowIndex>
+vector<bool>  encode(const vector<bool> &in, const vector<uint32_t> &column_pointers,
+                     const vector<RowIndex> &row_index, size_t n_rows) {
 
 
     // initialize the output vector to all 0/false
@@ -186,24 +529,74 @@ vector<bool>  encode(vector<bool> &in, vector<uint32_t> column_pointers,
 }
 
 
+/**
+ * @brief calculates the syndrome of the codeword into an existing buffer
+ * @param code the LDPC code
+ * @param in the input vector to multply with H
+ * @param out output syndrome, must have n_rows entries
+ */
+void encode(const LdpcCode &code, const vector<bool> &in, vector<bool> &out) {
+    fill(out.begin(), out.end(), false);
+    for (size_t col = 0; col < in.size(); col++) {
+        if (!in[col]) {
+            continue;
+        }
+        for (size_t j = code.column_pointers[col]; j < code.column_pointers[col + 1]; j++) {
+            out[code.row_index[j]] = !out[code.row_index[j]];
+        }
+    }
+}
+
+
+/**
+ * @brief calculates the syndrome of a packed codeword with word-level operations
+ * @param code the LDPC code
+ * @param in the packed input frame with n_cols bits
+ * @param out output, packed syndrome with n_rows bits
+ */
+void encode(const LdpcCode &code, const PackedFrame &in, PackedFrame &out) {
+    packed_syndrome(code.packed_h, in, out);
+}
+
+
+/**
+ * @brief calculates the syndromes of many packed codewords, bit-sliced 64 frames at a time
+ * @param code the LDPC code
+ * @param in the packed input frames with n_cols bits each
+ * @param out output, packed syndromes with n_rows bits each
+ */
+void encode(const LdpcCode &code, const vector<PackedFrame> &in, vector<PackedFrame> &out) {
+    packed_syndrome(code.packed_h, in, out);
+}
+
+
 /**
  * @brief calculates the initial log likelihood ratios
  * @param y the received message
  * @param p the crossover probability
  * @return log-likelihood rations
  */
-vector<double> bsc_llr(vector<bool> &y, double p) {
-    vector<double> llr = vector<double>(y.size(), 0);
+vector<double> bsc_llr(const vector<bool> &y, double p) {
+    vector<double> llr;
+    bsc_llr(y, p, llr);
+    return llr;
+}
+
+
+/**
+ * @brief calculates the initial log likelihood ratios into an existing buffer
+ * @param y the received message
+ * @param p the crossover probability
+ * @param llr output, resized to the size of y
+ */
+template<typename T>
+void bsc_llr(const vector<bool> &y, double p, vector<T> &llr) {
+    llr.resize(y.size());
+    const T llr_one = static_cast<T>(log(p/(1-p)));
+    const T llr_zero = static_cast<T>(log((1-p)/p));
     for (size_t i = 0; i<y.size(); i++){
-        if (y[i]){
-            llr[i] = log(p/(1-p));
-        }
-        else{
-            llr[i] = log((1-p)/p);
-        }
+        llr[i] = y[i] ? llr_one : llr_zero;
     }
-    //cout << y.size() << endl;
-    return llr;
 }
 
 
@@ -215,22 +608,33 @@ vector<double> bsc_llr(vector<bool> &y, double p) {
  * @param row_index row indices of H in CSC
  * @return List of list of positions of variable nodes and List of list of positions of check nodes
  */
+template<typename RowIndex>
 tuple<vector<vector<int>>, vector<vector<int>>> calculate_vn_cv(int n_cols,
                                                                 int n_rows,
-                                                                vector<uint32_t> column_pointers,
-                                                                vector<uint16_t> row_index) {
+                                                                const vector<uint32_t> &column_pointers,
+                                                                const vector<RowIndex> &row_index) {
 
     vector<vector<int>> pos_varn = vector<vector<int>>(n_rows, vector<int>{});
     vector<vector<int>> pos_checkn = vector<vector<int>>(n_cols, vector<int>{});
 
+    // reserve the exact degrees first so that the push_backs below never reallocate
+    vector<size_t> check_degree(n_rows);
+    for (const auto r : row_index) {
+        check_degree[r]++;
+    }
+    for (int i{}; i < n_rows; ++i) {
+        pos_varn[i].reserve(check_degree[i]);
+    }
+    for (int col = 0; col < n_cols; col++) {
+        pos_checkn[col].reserve(column_pointers[col + 1u] - column_pointers[col]);
+    }
+
     for (int col = 0; col < n_cols; col++) {
         for (size_t j = column_pointers[col]; j < column_pointers[col + 1u]; j++) {
-            pos_varn[row_index[j]].push_back(col); // I am pretty sure this is terrible, new alloctiaon each iter
+            pos_varn[row_index[j]].push_back(col);
         }
     }
 
-    pos_checkn.assign(n_cols, vector<int>{});
-
     for (int i{}; i < pos_varn.size(); ++i) {
         for (auto &vn : pos_varn[i]) {
             pos_checkn[vn].push_back(i);
@@ -241,112 +645,421 @@ tuple<vector<vector<int>>, vector<vector<int>>> calculate_vn_cv(int n_cols,
 
 
 /**
- * @brief performs the check node update step
- * @param msg_c the array containing the check messages
- * @param msg_v the array containing the variable messages
- * @param syndrome the syndrome of the codeword
- * @param pos_varn List of lists of positions of variable nodes
- * @param pos_checkn List of lists of positions of check nodes
+ * @brief builds the flat edge-indexed Tanner graph of H
  * @param n_cols number of columns of H
  * @param n_rows number of rows of H
+ * @param column_pointers column pointers of H in CSC
+ * @param row_index row indices of H in CSC
+ * @return the Tanner graph with both edge orderings and the permutations between them
  */
-void check_node_update(vector<vector<double>> &msg_c,
-                       const vector<vector<double>> &msg_v,
-                       const vector<bool> &syndrome,
-                       const vector<vector<int>> &pos_varn,
-                       const vector<vector<int>> &pos_checkn,
-                       const int n_cols,
-                       const int n_rows) {
-    double msg_part{};
-    vector<size_t> mc_position(n_cols);
-
-    for (size_t m{}; m < n_rows; ++m) {
+template<typename RowIndex>
+TannerGraph build_tanner_graph(int n_cols,
+                               int n_rows,
+                               const vector<uint32_t> &column_pointers,
+                               const vector<RowIndex> &row_index) {
+    if (column_pointers.size() != static_cast<size_t>(n_cols) + 1
+        || row_index.size() != column_pointers.back()) {
+        throw runtime_error("CSC arrays don't match the dimensions of H.");
+    }
+
+    TannerGraph graph;
+    graph.n_cols = n_cols;
+    graph.n_rows = n_rows;
+    const size_t n_edges = row_index.size();
+
+    // variable order is the CSC order
+    graph.var_offsets = column_pointers;
+    graph.var_checks = vector<uint32_t>(row_index.begin(), row_index.end());
+
+    // count the degree of each check node, then turn the counts into offsets
+    vector<uint32_t> check_offsets(n_rows + 1, 0);
+    for (const auto r : row_index) {
+        if (r >= static_cast<uint32_t>(n_rows)) {
+            throw runtime_error("row index exceeds number of rows in H.");
+        }
+        check_offsets[r + 1]++;
+    }
+    partial_sum(check_offsets.begin(), check_offsets.end(), check_offsets.begin());
+
+    // scatter the edges into check order, columns stay ascending within each row
+    vector<uint32_t> check_vars(n_edges), check_to_var_edge(n_edges), var_to_check_edge(n_edges);
+    vector<uint32_t> fill_pos(check_offsets.begin(), check_offsets.end() - 1);
+    for (int col = 0; col < n_cols; col++) {
+        for (uint32_t j = column_pointers[col]; j < column_pointers[col + 1u]; j++) {
+            const uint32_t e = fill_pos[row_index[j]]++;
+            check_vars[e] = col;
+            check_to_var_edge[e] = j;
+            var_to_check_edge[j] = e;
+        }
+    }
+    graph.check_offsets = std::move(check_offsets);
+    graph.check_vars = std::move(check_vars);
+    graph.check_to_var_edge = std::move(check_to_var_edge);
+    graph.var_to_check_edge = std::move(var_to_check_edge);
+    build_narrow_edges(graph);
+    return graph;
+}
+
+
+/**
+ * @brief fills the 16-bit permutations of a graph with at most narrow_edge_limit edges
+ * @param graph flat Tanner graph of H, its 32-bit permutations must be built
+ */
+void build_narrow_edges(TannerGraph &graph) {
+    graph.check_to_var_edge16.clear();
+    graph.var_to_check_edge16.clear();
+    if (graph.n_edges() == 0 || graph.n_edges() > narrow_edge_limit) {
+        return;
+    }
+    graph.check_to_var_edge16.assign(graph.check_to_var_edge.begin(), graph.check_to_var_edge.end());
+    graph.var_to_check_edge16.assign(graph.var_to_check_edge.begin(), graph.var_to_check_edge.end());
+    graph.check_to_var_edge16.resize(graph.n_edges() + narrow_edge_padding, 0);
+    graph.var_to_check_edge16.resize(graph.n_edges() + narrow_edge_padding, 0);
+}
+
+
+/**
+ * @brief builds the code object, including its Tanner graph and degree profile
+ * @tparam RowIndex uint16_t or uint32_t, the .npy files of small codes hold 16-bit row indices
+ * @param n_cols number of columns of H
+ * @param n_rows number of rows of H
+ * @param column_pointers column pointers of H in CSC
+ * @param row_index row indices of H in CSC
+ * @return the code
+ */
+template<typename RowIndex>
+LdpcCode build_ldpc_code(int n_cols,
+                         int n_rows,
+                         vector<uint32_t> column_pointers,
+                         const vector<RowIndex> &row_index) {
+    LdpcCode code;
+    code.n_cols = n_cols;
+    code.n_rows = n_rows;
+    code.graph = build_tanner_graph(n_cols, n_rows, column_pointers, row_index);
+    code.column_pointers = std::move(column_pointers);
+    code.row_index = code.graph.var_checks;
+
+    vector<uint32_t> var_degrees(n_cols);
+    for (int col = 0; col < n_cols; col++) {
+        var_degrees[col] = code.graph.var_offsets[col + 1] - code.graph.var_offsets[col];
+    }
+    vector<uint32_t> check_degrees(n_rows);
+    for (int row = 0; row < n_rows; row++) {
+        check_degrees[row] = code.graph.check_offsets[row + 1] - code.graph.check_offsets[row];
+    }
+    code.var_degrees = std::move(var_degrees);
+    code.check_degrees = std::move(check_degrees);
+    code.max_var_degree = n_cols ? *max_element(code.var_degrees.begin(), code.var_degrees.end()) : 0;
+    code.max_check_degree = n_rows ? *max_element(code.check_degrees.begin(), code.check_degrees.end()) : 0;
+    code.packed_h = build_packed_parity_check(n_cols, n_rows, code.graph.check_offsets, code.graph.check_vars);
+    return code;
+}
+
+
+/**
+ * @brief allocates a decoder workspace sized for the given code
+ * @param code the LDPC code
+ * @return the workspace
+ */
+DecoderWorkspace make_decoder_workspace(const LdpcCode &code) {
+    DecoderWorkspace ws;
+    ws.f64.resize(code);
+    ws.out.resize(code.n_cols);
+    ws.unsatisfied.resize(code.n_rows);
+    return ws;
+}
+
+
+/**
+ * @brief performs the check node update step
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ */
+template<typename T, typename Index>
+static void check_node_update(vector<T> &msg_c,
+                              const vector<T> &msg_v,
+                              const vector<bool> &syndrome,
+                              const TannerGraph &graph,
+                              const Index *c2v) {
+    T msg_part{};
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
         // product of incoming messages
-        double mc_prod = 1 - 2 * static_cast<double>(syndrome[m]);
-        // Note: pos_varn[m].size() = check_node_degrees[m]
-        const auto curr_check_node_degree = pos_varn[m].size();
-        for (std::size_t k{}; k < curr_check_node_degree; ++k) {
-            mc_prod *= ::tanh(0.5 * msg_v[m][k]);
+        T mc_prod = 1 - 2 * static_cast<T>(syndrome[m]);
+        for (uint32_t e = begin; e < end; ++e) {
+            mc_prod *= std::tanh(T(0.5) * msg_v[e]);
         }
 
-        for (std::size_t k{}; k < curr_check_node_degree; ++k) {
+        for (uint32_t e = begin; e < end; ++e) {
             // computing message from
-            if (msg_v[m][k] == 0.) {
+            if (msg_v[e] == 0) {
                 msg_part = 1;
-                for (std::size_t non_k{}; non_k < curr_check_node_degree; ++non_k) {
-                    if (non_k != k) {
-                        msg_part *= ::tanh(0.5 * msg_v[m][k]);
+                for (uint32_t non_e = begin; non_e < end; ++non_e) {
+                    if (non_e != e) {
+                        msg_part *= std::tanh(T(0.5) * msg_v[e]);
                     }
                 }
             } else {
-                msg_part = mc_prod / ::tanh(0.5 * msg_v[m][k]);
+                msg_part = mc_prod / std::tanh(T(0.5) * msg_v[e]);
             }
 
-            auto msg_final = ::log((1 + msg_part) / (1 - msg_part));
+            // place the message at the position of this edge in variable order
+            msg_c[c2v[e]] = std::log((1 + msg_part) / (1 - msg_part));
+        }
+    }
+}
 
-            // place the message at the correct position in the output array
-            const int curr_pos_varn = pos_varn[m][k];
-            msg_c[curr_pos_varn][mc_position[curr_pos_varn]] = msg_final;
-            mc_position[curr_pos_varn]++;
+
+/**
+ * @brief performs the check node update step
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ */
+template<typename T>
+void check_node_update(vector<T> &msg_c,
+                       const vector<T> &msg_v,
+                       const vector<bool> &syndrome,
+                       const TannerGraph &graph) {
+    with_edge_index(graph, [&](const auto *c2v, const auto *) {
+        check_node_update(msg_c, msg_v, syndrome, graph, c2v);
+    });
+}
+
+
+/**
+ * @brief performs the check node update step with the min-sum approximation
+ *
+ * Each check node is reduced in a single pass to its two smallest magnitudes, the
+ * position of the smallest one and the sign parity. The outgoing magnitude is
+ * max(scale * min - offset, 0), which gives plain (1, 0), normalized (scale, 0)
+ * and offset (1, offset) min-sum.
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ */
+template<typename T, typename Index>
+static void check_node_update_min_sum(vector<T> &msg_c,
+                                      const vector<T> &msg_v,
+                                      const vector<bool> &syndrome,
+                                      const TannerGraph &graph,
+                                      const double scale,
+                                      const double offset,
+                                      const Index *c2v) {
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
+        // one pass: two smallest magnitudes, position of the smallest, sign parity
+        T min1 = numeric_limits<T>::infinity();
+        T min2 = numeric_limits<T>::infinity();
+        uint32_t min1_pos = begin;
+        bool parity = syndrome[m];
+        for (uint32_t e = begin; e < end; ++e) {
+            const T mag = std::abs(msg_v[e]);
+            parity ^= msg_v[e] < 0;
+            if (mag < min1) {
+                min2 = min1;
+                min1 = mag;
+                min1_pos = e;
+            } else if (mag < min2) {
+                min2 = mag;
+            }
+        }
+
+        const T out1 = min_sum_magnitude(min1, T(scale), T(offset));
+        const T out2 = min_sum_magnitude(min2, T(scale), T(offset));
+        for (uint32_t e = begin; e < end; ++e) {
+            const T mag = e == min1_pos ? out2 : out1;
+            const bool negative = parity != (msg_v[e] < 0);
+            msg_c[c2v[e]] = negative ? -mag : mag;
         }
     }
 }
 
 
+/**
+ * @brief performs the check node update step with the min-sum approximation
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ */
+template<typename T>
+void check_node_update_min_sum(vector<T> &msg_c,
+                               const vector<T> &msg_v,
+                               const vector<bool> &syndrome,
+                               const TannerGraph &graph,
+                               const double scale,
+                               const double offset) {
+    with_edge_index(graph, [&](const auto *c2v, const auto *) {
+        check_node_update_min_sum(msg_c, msg_v, syndrome, graph, scale, offset, c2v);
+    });
+}
+
+
+/**
+ * @brief scale and offset of the min-sum kernel for the rule in config
+ * @param config decoder parameters
+ * @param scale output, scaling factor (1 unless normalized min-sum)
+ * @param offset output, offset (0 unless offset min-sum)
+ */
+void min_sum_parameters(const DecoderConfig &config, double &scale, double &offset) {
+    // plain min-sum is the normalized/offset kernel with neutral parameters
+    scale = 1.;
+    offset = 0.;
+    if (config.rule == CheckNodeRule::normalized_min_sum) {
+        scale = config.ms_scale;
+    } else if (config.rule == CheckNodeRule::offset_min_sum) {
+        offset = config.ms_offset;
+    }
+}
+
+
 /**
  * @brief performs the variable node update step
- * @param msg_v the array containing the variable messages
- * @param msg_c the array containing the check messages
+ * @param msg_v the array containing the variable messages, check order
+ * @param msg_c the array containing the check messages, variable order
  * @param llrs intial log likelihood ratios
- * @param pos_varn List of lists of positions of variable nodes
- * @param pos_checkn List of lists of positions of check nodes
- * @param n_cols number of columns of H
+ * @param graph flat Tanner graph of H
  */
-void var_node_update(vector<vector<double>> &msg_v,
-                     const vector<vector<double>> &msg_c,
-                     const vector<double> &llrs,
-                     const vector<vector<int>> &pos_varn,
-                     const vector<vector<int>> &pos_checkn,
-                     const int n_cols){
-    vector<size_t> mv_position(n_cols);
-
+template<typename T, typename Index>
+static void var_node_update(vector<T> &msg_v,
+                            const vector<T> &msg_c,
+                            const vector<T> &llrs,
+                            const TannerGraph &graph,
+                            const Index *v2c) {
     for (size_t m{}; m < llrs.size(); ++m) {
-        const double mv_sum = accumulate(msg_c[m].begin(), msg_c[m].end(), llrs[m]);
-
-        // Note: pos_checkn[m].size() = var_node_degs[m]
-        for (size_t k{}; k < pos_checkn[m].size(); ++k) {
-            const double msg = mv_sum - msg_c[m][k];
+        const uint32_t begin = graph.var_offsets[m];
+        const uint32_t end = graph.var_offsets[m + 1];
+        const T mv_sum = accumulate(msg_c.begin() + begin, msg_c.begin() + end, llrs[m]);
 
-            // place the message at the correct position in the output array
-            const int curr_pos_cn = pos_checkn[m][k];
-            msg_v[curr_pos_cn][mv_position[curr_pos_cn]] = msg;
-            mv_position[curr_pos_cn]++;
+        for (uint32_t e = begin; e < end; ++e) {
+            // place the message at the position of this edge in check order
+            msg_v[v2c[e]] = mv_sum - msg_c[e];
         }
     }
 }
 
 
+/**
+ * @brief performs the variable node update step
+ * @param msg_v the array containing the variable messages, check order
+ * @param msg_c the array containing the check messages, variable order
+ * @param llrs intial log likelihood ratios
+ * @param graph flat Tanner graph of H
+ */
+template<typename T>
+void var_node_update(vector<T> &msg_v,
+                     const vector<T> &msg_c,
+                     const vector<T> &llrs,
+                     const TannerGraph &graph) {
+    with_edge_index(graph, [&](const auto *, const auto *v2c) {
+        var_node_update(msg_v, msg_c, llrs, graph, v2c);
+    });
+}
+
+
 /**
  * @brief sums up all messages to calculate if the llr is negative or positive, returns
  * the current most likely bit
  * @param out the vector to be fille dwith the bits
  * @param llrs the initial likelihoods
- * @param msg_c the current messages
+ * @param msg_c the current check messages, variable order
+ * @param graph flat Tanner graph of H
  */
+template<typename T>
 void hard_decision(
         vector<bool> &out,
-        const vector<double> &llrs,
-        const vector<vector<double>> &msg_c){
-    fill(out.begin(), out.end(), 0);
+        const vector<T> &llrs,
+        const vector<T> &msg_c,
+        const TannerGraph &graph){
     for (size_t j{}; j < llrs.size(); ++j) {
-        const double curr_sum = accumulate(msg_c[j].begin(), msg_c[j].end(), llrs[j]);
-        if (curr_sum < 0) {
-            out[j] = 1;
-        }
+        const T curr_sum = accumulate(msg_c.begin() + graph.var_offsets[j],
+                                           msg_c.begin() + graph.var_offsets[j + 1], llrs[j]);
+        out[j] = curr_sum < 0;
     }
 }
 
 
+/**
+ * @brief resets the hard decision to all zeros and the check parities to the syndrome
+ * @param ws decoder workspace, out, unsatisfied and n_unsatisfied are reset
+ * @param syndrome The checksum/syndrome of the codeword
+ */
+void reset_syndrome_tracking(DecoderWorkspace &ws, const vector<bool> &syndrome) {
+    fill(ws.out.begin(), ws.out.end(), false);
+    ws.n_unsatisfied = 0;
+    for (size_t m{}; m < syndrome.size(); ++m) {
+        ws.unsatisfied[m] = syndrome[m];
+        ws.n_unsatisfied += syndrome[m];
+    }
+}
 
 
+/**
+ * @brief hard decision that only updates the parities of the checks whose bits changed
+ * @param ws decoder workspace, out and the check parities are updated
+ * @param llrs the initial likelihoods
+ * @param msg_c the current check messages, variable order
+ * @param graph flat Tanner graph of H
+ * @return number of unsatisfied checks after the decision
+ */
+template<typename T>
+size_t hard_decision(DecoderWorkspace &ws, const vector<T> &llrs, const vector<T> &msg_c,
+                     const TannerGraph &graph) {
+    for (size_t j{}; j < llrs.size(); ++j) {
+        const T curr_sum = accumulate(msg_c.begin() + graph.var_offsets[j],
+                                           msg_c.begin() + graph.var_offsets[j + 1], llrs[j]);
+        update_decision(ws, graph, j, curr_sum < 0);
+    }
+    return ws.n_unsatisfied;
+}
+
 
+// the floating point kernels are instantiated for both message types
+template void hard_decision<float>(vector<bool> &, const vector<float> &, const vector<float> &, const TannerGraph &);
+template void hard_decision<double>(vector<bool> &, const vector<double> &, const vector<double> &, const TannerGraph &);
+template size_t hard_decision<float>(DecoderWorkspace &, const vector<float> &, const vector<float> &,
+                                     const TannerGraph &);
+template size_t hard_decision<double>(DecoderWorkspace &, const vector<double> &, const vector<double> &,
+                                      const TannerGraph &);
+template void var_node_update<float>(vector<float> &, const vector<float> &, const vector<float> &,
+                                     const TannerGraph &);
+template void var_node_update<double>(vector<double> &, const vector<double> &, const vector<double> &,
+                                      const TannerGraph &);
+template void check_node_update<float>(vector<float> &, const vector<float> &, const vector<bool> &,
+                                       const TannerGraph &);
+template void check_node_update<double>(vector<double> &, const vector<double> &, const vector<bool> &,
+                                        const TannerGraph &);
+template void check_node_update_min_sum<float>(vector<float> &, const vector<float> &, const vector<bool> &,
+                                               const TannerGraph &, double, double);
+template void check_node_update_min_sum<double>(vector<double> &, const vector<double> &, const vector<bool> &,
+                                                const TannerGraph &, double, double);
+template void bsc_llr<float>(const vector<bool> &, double, vector<float> &);
+template void bsc_llr<double>(const vector<bool> &, double, vector<double> &);
+
+// the CSC row indices come as 16-bit (small codes) or 32-bit entries
+template vector<bool> encode<uint16_t>(const vector<bool> &, const vector<uint32_t> &, const vector<uint16_t> &,
+                                       size_t);
+template vector<bool> encode<uint32_t>(const vector<bool> &, const vector<uint32_t> &, const vector<uint32_t> &,
+                                       size_t);
+template tuple<vector<vector<int>>, vector<vector<int>>> calculate_vn_cv<uint16_t>(int, int, const vector<uint32_t> &,
+                                                                                   const vector<uint16_t> &);
+template tuple<vector<vector<int>>, vector<vector<int>>> calculate_vn_cv<uint32_t>(int, int, const vector<uint32_t> &,
+                                                                                   const vector<uint32_t> &);
+template TannerGraph build_tanner_graph<uint16_t>(int, int, const vector<uint32_t> &, const vector<uint16_t> &);
+template TannerGraph build_tanner_graph<uint32_t>(int, int, const vector<uint32_t> &, const vector<uint32_t> &);
+template LdpcCode build_ldpc_code<uint16_t>(int, int, vector<uint32_t>, const vector<uint16_t> &);
+template LdpcCode build_ldpc_code<uint32_t>(int, int, vector<uint32_t>, const vector<uint32_t> &);
@@ -31,103 +31,567 @@ header file for the actual decoder implementation
 // Includes
 //----------------------------------------------------------------------
 #include <vector>
+#include <string>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <algorithm>
 #include <random>
 #include <tuple>
+#include <chrono>
 #include "simulation_utils.h"
+#include "packed_bits.h"
 
 #ifndef INFORMATION_THEORY_ENCODING_DECODING_H
 #define INFORMATION_THEORY_ENCODING_DECODING_H
 
-#endif //INFORMATION_THEORY_ENCODING_DECODING_H
-
 using namespace std;
 
 
+/**
+ * @brief flat, edge-indexed representation of the Tanner graph of H
+ *
+ * Every edge is stored twice: once in check order (row by row) and once in
+ * variable order (column by column, which is exactly the CSC order). Messages
+ * from variable to check nodes live in check order, messages from check to
+ * variable nodes live in variable order, so both update steps read their input
+ * contiguously and scatter their output through one of the permutations.
+ *
+ * Graphs with at most 65536 edges also keep both permutations with 16-bit entries.
+ * The decoder kernels are templated on the index type and read these, which halves
+ * the index traffic of every iteration for the small codes, large codes fall back
+ * to the 32-bit permutations (see with_edge_index).
+ */
+struct TannerGraph {
+    int n_cols{};
+    int n_rows{};
+    CodeArray<uint32_t> check_offsets;      // n_rows + 1 entries, first edge of each check node
+    CodeArray<uint32_t> check_vars;         // variable node of each edge, check order
+    CodeArray<uint32_t> var_offsets;        // n_cols + 1 entries, first edge of each variable node
+    CodeArray<uint32_t> var_checks;         // check node of each edge, variable order
+    CodeArray<uint32_t> check_to_var_edge;  // position of a check-order edge in variable order
+    CodeArray<uint32_t> var_to_check_edge;  // position of a variable-order edge in check order
+    vector<uint16_t> check_to_var_edge16;   // check_to_var_edge with 16-bit entries, padded, or empty
+    vector<uint16_t> var_to_check_edge16;   // var_to_check_edge with 16-bit entries, padded, or empty
+
+    size_t n_edges() const { return check_vars.size(); }
+
+    bool narrow_edges() const { return !check_to_var_edge16.empty(); }
+};
+
+
+// largest number of edges for which the 16-bit permutations are built
+const size_t narrow_edge_limit = size_t(1) << 16;
+
+// zero entries after the 16-bit permutations, so vector kernels may load whole registers
+const size_t narrow_edge_padding = 32;
+
+
+/**
+ * @brief calls f with the two edge permutations of a graph, the 16-bit ones when the
+ * graph has them and the 32-bit ones otherwise, so that every kernel taking them is
+ * instantiated for both index widths
+ * @param graph flat Tanner graph of H
+ * @param f callable taking the check_to_var and var_to_check pointers
+ */
+template<typename Function>
+inline void with_edge_index(const TannerGraph &graph, Function &&f) {
+    if (graph.narrow_edges()) {
+        f(graph.check_to_var_edge16.data(), graph.var_to_check_edge16.data());
+    } else {
+        f(graph.check_to_var_edge.data(), graph.var_to_check_edge.data());
+    }
+}
+
+
+/**
+ * @brief an LDPC code, built once from the CSC arrays of H and shared read-only
+ * by everything that encodes or decodes with it
+ *
+ * A code built in memory owns its arrays, a code loaded from a code file borrows
+ * them from the mapping of the file (see load_code_file), except for the 16-bit
+ * edge permutations, which are always built.
+ */
+struct LdpcCode {
+    int n_cols{};
+    int n_rows{};
+    CodeArray<uint32_t> column_pointers;  // column pointers of H in CSC
+    CodeArray<uint32_t> row_index;        // row indices of H in CSC
+    TannerGraph graph;
+    CodeArray<uint32_t> var_degrees;      // degree of each variable node (column of H)
+    CodeArray<uint32_t> check_degrees;    // degree of each check node (row of H)
+    uint32_t max_var_degree{};
+    uint32_t max_check_degree{};
+    PackedParityCheck packed_h;           // row-major packed form of H for the packed encoder
+};
+
+
+/**
+ * @brief rule used to compute the check node messages
+ */
+enum class CheckNodeRule {
+    sum_product,         // exact tanh rule, the reference
+    min_sum,             // plain min-sum
+    normalized_min_sum,  // min-sum with the magnitude scaled by ms_scale
+    offset_min_sum       // min-sum with ms_offset subtracted from the magnitude
+};
+
+
+/**
+ * @brief order in which the nodes are updated
+ */
+enum class Schedule {
+    flooding,  // all check nodes, then all variable nodes
+    layered    // check node by check node, posteriors updated right after each row
+};
+
+
+/**
+ * @brief instruction set used by the node update kernels
+ */
+enum class SimdLevel {
+    automatic,  // best level supported by the CPU, detected at runtime
+    scalar,     // plain C++ reference kernels
+    avx2,
+    avx512
+};
+
+
+/**
+ * @brief scalar type of the decoder messages
+ */
+enum class MessageType {
+    float64,     // double, the reference
+    float32,     // float, twice the messages per cache line and vector register
+    fixed_point  // 8/16-bit integers, see fixed_point_decoder.h
+};
+
+
+/**
+ * @brief parses a check node rule given by name
+ * @param name the name as in CheckNodeRule, e.g. "normalized_min_sum"
+ * @return the rule
+ */
+CheckNodeRule check_node_rule_from_name(const std::string &name);
+
+
+/**
+ * @brief parses a SIMD level given by name
+ * @param name the name as printed by simd_level_name, e.g. "avx2"
+ * @return the level
+ */
+SimdLevel simd_level_from_name(const std::string &name);
+
+
+/**
+ * @brief parameters of the decoder
+ */
+struct DecoderConfig {
+    CheckNodeRule rule = CheckNodeRule::sum_product;
+    Schedule schedule = Schedule::flooding;
+    SimdLevel simd = SimdLevel::automatic;
+    MessageType message_type = MessageType::float64;
+    double ms_scale = 0.75;            // scaling factor of normalized min-sum
+    double ms_offset = 0.5;            // offset of offset min-sum
+    std::size_t max_num_iter = 50;     // max number of decoding iterations
+    double vsat = 100;                 // cut-off value for messages
+    int fixed_bits = 8;                // message width of the fixed-point decoder (2..16)
+    int fixed_frac_bits = 2;           // fractional bits of the fixed-point messages
+    bool warm_start = false;           // continue from the messages left in the workspace instead of the LLRs
+};
+
+
+/**
+ * @brief why the decoder stopped
+ */
+enum class Termination {
+    converged,       // the hard decision matches the syndrome
+    max_iterations,  // max_num_iter iterations without convergence
+    diverged         // a message became NaN
+};
+
+
+/**
+ * @brief what the decoder did on one frame, filled in while DecoderWorkspace::statistics
+ * points to it
+ *
+ * The flooding decoder updates the check parities during the hard decision, so the
+ * syndrome check phase is the stopping test (syndrome weight and NaN scan). The
+ * layered schedule counts its row updates as check node time, the fixed-point decoder
+ * its fused variable node update and hard decision as variable node time.
+ */
+struct FrameStatistics {
+    size_t iterations = 0;             // iterations run, including the last one
+    Termination termination = Termination::max_iterations;
+    vector<uint32_t> unsatisfied;      // unsatisfied checks after every iteration
+    double check_node_seconds = 0;
+    double var_node_seconds = 0;
+    double hard_decision_seconds = 0;
+    double syndrome_check_seconds = 0;
+
+    void reset() {
+        iterations = 0;
+        termination = Termination::max_iterations;
+        unsatisfied.clear();
+        check_node_seconds = 0;
+        var_node_seconds = 0;
+        hard_decision_seconds = 0;
+        syndrome_check_seconds = 0;
+    }
+};
+
+
+/**
+ * @brief adds the time since the previous lap to a phase of a FrameStatistics, does
+ * nothing (and reads no clock) without one
+ */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(FrameStatistics *statistics) : statistics(statistics) {
+        if (statistics) {
+            last = chrono::steady_clock::now();
+        }
+    }
+
+    /**
+     * @brief ends the current phase
+     * @param phase the member of FrameStatistics the time goes to
+     */
+    void lap(double FrameStatistics::*phase) {
+        if (statistics) {
+            const auto now = chrono::steady_clock::now();
+            statistics->*phase += chrono::duration<double>(now - last).count();
+            last = now;
+        }
+    }
+
+private:
+    FrameStatistics *statistics;
+    chrono::steady_clock::time_point last;
+};
+
+
+/**
+ * @brief the message buffers of the decoder for one message type
+ * @tparam T message type
+ */
+template<typename T>
+struct MessageBuffers {
+    vector<T> msg_v;                   // messages from variable nodes to check nodes, check order
+    vector<T> msg_c;                   // messages from check nodes to variable nodes, variable order
+    vector<T> llrs;                    // initial LLRs converted to T, unused for double
+    vector<T> posterior;               // posterior LLRs of the layered schedule
+    vector<T> check_scratch;           // per check node scratch of the vectorized and layered kernels
+
+    void resize(const LdpcCode &code) {
+        msg_v.resize(code.graph.n_edges());
+        msg_c.resize(code.graph.n_edges());
+        llrs.resize(code.n_cols);
+        posterior.resize(code.n_cols);
+        check_scratch.resize(code.max_check_degree);
+    }
+};
+
+
+/**
+ * @brief all message and scratch buffers of the decoder, sized for one code
+ *
+ * A workspace is reused across frames so that decoding does not allocate in steady
+ * state. It is not shared, every thread needs its own. The parity of every check is
+ * tracked as the hard decision changes, so n_unsatisfied can be read after (or
+ * between) decodes to monitor convergence.
+ */
+struct DecoderWorkspace {
+    // messages per message type, double is allocated up front, the others on first use
+    MessageBuffers<double> f64;
+    MessageBuffers<float> f32;
+    MessageBuffers<int8_t> fixed8;     // fixed-point messages up to 8 bits
+    MessageBuffers<int16_t> fixed16;   // fixed-point messages above 8 bits
+
+    vector<bool> out;                  // current hard decision
+    vector<uint8_t> unsatisfied;       // per check node, 1 if the hard decision violates its syndrome bit
+    size_t n_unsatisfied = 0;          // number of unsatisfied checks, 0 once decoding succeeded
+
+    vector<int32_t> fixed_scratch;     // forward/backward sums of the fixed-point check node
+    vector<int32_t> boxplus_table;     // correction term of the fixed-point boxplus
+    int boxplus_frac_bits = -1;        // fractional bits boxplus_table was built for
+
+    FrameStatistics *statistics = nullptr;  // optional sink, every decode fills it in while set
+};
+
+
+/**
+ * @brief the message buffers of a workspace for message type T
+ */
+template<typename T>
+MessageBuffers<T> &message_buffers(DecoderWorkspace &ws);
+
+template<>
+inline MessageBuffers<double> &message_buffers<double>(DecoderWorkspace &ws) { return ws.f64; }
+
+template<>
+inline MessageBuffers<float> &message_buffers<float>(DecoderWorkspace &ws) { return ws.f32; }
+
+template<>
+inline MessageBuffers<int8_t> &message_buffers<int8_t>(DecoderWorkspace &ws) { return ws.fixed8; }
+
+template<>
+inline MessageBuffers<int16_t> &message_buffers<int16_t>(DecoderWorkspace &ws) { return ws.fixed16; }
+
+
+
 
 /**
  * @brief Tries to decode the given codeword using the given parity check matrix
+ * @param code the LDPC code
  * @param llrs inital log-likelihood ratios
  * @param syndrome The checksum/syndrome of the codeword
- * @param n_cols number of columns of H
- * @param n_rows number of rows of H
- * @param pos_varn List of lists of positions of variable nodes
- * @param pos_checkn List of lists of positions of check nodes
- * @param column_pointers column pointers of H in CSC
- * @param row_index row indices of H in CSC
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
  * @param max_num_iter max number of decoding iterations
  * @param vsat cut-off value for messages
- * @return
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_at_current_rate(const LdpcCode &code,
+                            const vector<double> &llrs,
+                            const vector<bool> &syndrome,
+                            DecoderWorkspace &ws,
+                            std::size_t max_num_iter = 50,
+                            double vsat = 100);
+
+
+/**
+ * @brief Tries to decode the given codeword with the check node rule and limits of config
+ *
+ * config.message_type picks the instantiation of the decoder core at runtime: double
+ * or float messages with the configured schedule, or the fixed-point decoder of
+ * fixed_point_decoder.h. The LLRs are converted to the message type once per call.
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_at_current_rate(const LdpcCode &code,
+                            const vector<double> &llrs,
+                            const vector<bool> &syndrome,
+                            DecoderWorkspace &ws,
+                            const DecoderConfig &config);
+
+
+/**
+ * @brief Tries to decode the given codeword with the layered (row-serial) schedule
+ *
+ * Keeps only the check to variable messages (check order, in ws.msg_v) and the
+ * posterior LLRs. Every check node row reads its incoming messages from the
+ * posteriors and writes the updated posteriors back right away, so later rows of the
+ * same iteration already see the new information. One iteration is one sweep over
+ * all rows, after which the hard decision is checked against the syndrome.
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_layered(const LdpcCode &code,
+                    const vector<double> &llrs,
+                    const vector<bool> &syndrome,
+                    DecoderWorkspace &ws,
+                    const DecoderConfig &config);
+
+
+/**
+ * @brief Tries to decode the given codeword, convenience version using a temporary workspace
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param code the LDPC code
+ * @param max_num_iter max number of decoding iterations
+ * @param vsat cut-off value for messages
+ * @return success flag and the decoded word
  */
 tuple<bool, vector<bool>> decode_at_current_rate(const vector<double> &llrs,
                                                  const vector<bool> &syndrome,
-                                                 const int n_cols,
-                                                 const int n_rows,
-                                                 const vector<vector<int>> &pos_varn,
-                                                 const vector<vector<int>> &pos_checkn,
-                                                 const vector<uint32_t> column_pointers,
-                                                 const vector<uint16_t> row_index,
-                                                 const std::size_t max_num_iter,
-                                                 const double vsat);
+                                                 const LdpcCode &code,
+                                                 std::size_t max_num_iter = 50,
+                                                 double vsat = 100);
 
 
 
 /**
  * @brief caps the values of a vector in both positive and negative direction
- * @tparam T
+ * @tparam T message type (float or double)
  * @param mv The vector to cap
  * @param vsat the limit to cap, +/-
  */
 template<typename T>
-static void saturate(vector<vector<T>> &mv, const double vsat);
+static void saturate(vector<T> &mv, const double vsat);
 
 /**
  * @brief sums up all messages to calculate if the llr is negative or positive, returns
  * the current most likely bit
+ * @tparam T message type (float or double)
  * @param out the vector to be fille dwith the bits
  * @param llrs the initial likelihoods
- * @param msg_c the current messages
+ * @param msg_c the current check messages, variable order
+ * @param graph flat Tanner graph of H
+ */
+template<typename T>
+void hard_decision(vector<bool> &out, const vector<T> &llrs, const vector<T> &msg_c,
+                   const TannerGraph &graph);
+
+
+/**
+ * @brief resets the hard decision to all zeros and the check parities to the syndrome
+ * @param ws decoder workspace, out, unsatisfied and n_unsatisfied are reset
+ * @param syndrome The checksum/syndrome of the codeword
+ */
+void reset_syndrome_tracking(DecoderWorkspace &ws, const vector<bool> &syndrome);
+
+
+/**
+ * @brief sets one bit of the hard decision and flips the parity of its checks if it changed
+ *
+ * Keeps ws.unsatisfied and ws.n_unsatisfied in sync with ws.out at O(degree) cost per
+ * changed bit, so the termination test doesn't need to re-encode the whole word.
+ * @param ws decoder workspace
+ * @param graph flat Tanner graph of H
+ * @param j index of the variable node
+ * @param bit new hard decision of the variable node
+ */
+inline void update_decision(DecoderWorkspace &ws, const TannerGraph &graph, const size_t j, const bool bit) {
+    if (ws.out[j] == bit) {
+        return;
+    }
+    ws.out[j] = bit;
+    for (uint32_t e = graph.var_offsets[j]; e < graph.var_offsets[j + 1]; ++e) {
+        uint8_t &u = ws.unsatisfied[graph.var_checks[e]];
+        u ^= 1;
+        if (u) { ++ws.n_unsatisfied; }
+        else { --ws.n_unsatisfied; }
+    }
+}
+
+
+/**
+ * @brief counts a finished iteration and its syndrome weight in ws.statistics, if set
+ * @param ws decoder workspace
+ */
+inline void record_iteration(DecoderWorkspace &ws) {
+    if (ws.statistics) {
+        ++ws.statistics->iterations;
+        ws.statistics->unsatisfied.push_back(static_cast<uint32_t>(ws.n_unsatisfied));
+    }
+}
+
+
+/**
+ * @brief records why the decoder stopped in ws.statistics, if set
+ * @param ws decoder workspace
+ * @param reason the reason
+ * @return true if the decoder converged, the return value of the decoder
+ */
+inline bool stop_decoding(DecoderWorkspace &ws, const Termination reason) {
+    if (ws.statistics) {
+        ws.statistics->termination = reason;
+    }
+    return reason == Termination::converged;
+}
+
+
+/**
+ * @brief hard decision that only updates the parities of the checks whose bits changed
+ * @tparam T message type (float or double)
+ * @param ws decoder workspace, out and the check parities are updated
+ * @param llrs the initial likelihoods
+ * @param msg_c the current check messages, variable order
+ * @param graph flat Tanner graph of H
+ * @return number of unsatisfied checks after the decision
  */
-void hard_decision(vector<bool> &out, const vector<double> &llrs, const vector<vector<double>> &msg_c);
+template<typename T>
+size_t hard_decision(DecoderWorkspace &ws, const vector<T> &llrs, const vector<T> &msg_c,
+                     const TannerGraph &graph);
 
 
 
 /**
  * @brief performs the variable node update step
- * @param msg_v the array containing the variable messages
- * @param msg_c the array containing the check messages
+ * @tparam T message type (float or double)
+ * @param msg_v the array containing the variable messages, check order
+ * @param msg_c the array containing the check messages, variable order
  * @param llrs intial log likelihood ratios
- * @param pos_varn List of lists of positions of variable nodes
- * @param pos_checkn List of lists of positions of check nodes
- * @param n_cols number of columns of H
+ * @param graph flat Tanner graph of H
  */
-void var_node_update(vector<vector<double>> &msg_v,
-                     const vector<vector<double>> &msg_c,
-                     const vector<double> &llrs,
-                     const vector<vector<int>> &pos_varn,
-                     const vector<vector<int>> &pos_checkn,
-                     const int n_cols);
+template<typename T>
+void var_node_update(vector<T> &msg_v,
+                     const vector<T> &msg_c,
+                     const vector<T> &llrs,
+                     const TannerGraph &graph);
 
 
 /**
  * @brief performs the check node update step
- * @param msg_c the array containing the check messages
- * @param msg_v the array containing the variable messages
+ * @tparam T message type (float or double)
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
  * @param syndrome the syndrome of the codeword
- * @param pos_varn List of lists of positions of variable nodes
- * @param pos_checkn List of lists of positions of check nodes
- * @param n_cols number of columns of H
- * @param n_rows number of rows of H
+ * @param graph flat Tanner graph of H
  */
-void check_node_update(vector<vector<double>> &msg_c,
-                       const vector<vector<double>> &msg_v,
+template<typename T>
+void check_node_update(vector<T> &msg_c,
+                       const vector<T> &msg_v,
                        const vector<bool> &syndrome,
-                       const vector<vector<int>> &pos_varn,
-                       const vector<vector<int>> &pos_checkn,
-                       const int n_cols,
-                       const int n_rows);
+                       const TannerGraph &graph);
+
+
+/**
+ * @brief performs the check node update step with the min-sum approximation
+ *
+ * Each check node is reduced in a single pass to its two smallest magnitudes, the
+ * position of the smallest one and the sign parity. The outgoing magnitude is
+ * max(scale * min - offset, 0), which gives plain (1, 0), normalized (scale, 0)
+ * and offset (1, offset) min-sum.
+ * @tparam T message type (float or double)
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ */
+template<typename T>
+void check_node_update_min_sum(vector<T> &msg_c,
+                               const vector<T> &msg_v,
+                               const vector<bool> &syndrome,
+                               const TannerGraph &graph,
+                               double scale,
+                               double offset);
+
+
+/**
+ * @brief scale and offset of the min-sum kernel for the rule in config
+ * @param config decoder parameters
+ * @param scale output, scaling factor (1 unless normalized min-sum)
+ * @param offset output, offset (0 unless offset min-sum)
+ */
+void min_sum_parameters(const DecoderConfig &config, double &scale, double &offset);
+
+
+/**
+ * @brief outgoing min-sum magnitude max(scale * min - offset, 0)
+ *
+ * The product is rounded on its own so that no kernel (scalar or vectorized, with or
+ * without FMA) can contract it and the min-sum kernels stay bit-for-bit comparable.
+ * @param min the incoming minimum
+ * @param scale scaling factor
+ * @param offset offset
+ * @return the outgoing magnitude
+ */
+template<typename T>
+inline T min_sum_magnitude(const T min, const T scale, const T offset) {
+    volatile T scaled = scale * min;
+    return max(scaled - offset, T(0));
+}
 
 
 /**
@@ -138,10 +602,57 @@ void check_node_update(vector<vector<double>> &msg_c,
  * @param row_index row indices of H in CSC
  * @return List of list of positions of variable nodes and List of list of positions of check nodes
  */
+template<typename RowIndex>
 tuple<vector<vector<int>>, vector<vector<int>>> calculate_vn_cv(int n_cols,
                                                                 int n_rows,
-                                                                vector<uint32_t> column_pointers,
-                                                                vector<uint16_t> row_index);
+                                                                const vector<uint32_t> &column_pointers,
+                                                                const vector<RowIndex> &row_index);
+
+
+/**
+ * @brief builds the code object, including its Tanner graph and degree profile
+ * @tparam RowIndex uint16_t or uint32_t, the .npy files of small codes hold 16-bit row indices
+ * @param n_cols number of columns of H
+ * @param n_rows number of rows of H
+ * @param column_pointers column pointers of H in CSC
+ * @param row_index row indices of H in CSC
+ * @return the code
+ */
+template<typename RowIndex>
+LdpcCode build_ldpc_code(int n_cols,
+                         int n_rows,
+                         vector<uint32_t> column_pointers,
+                         const vector<RowIndex> &row_index);
+
+
+/**
+ * @brief allocates a decoder workspace sized for the given code
+ * @param code the LDPC code
+ * @return the workspace
+ */
+DecoderWorkspace make_decoder_workspace(const LdpcCode &code);
+
+
+/**
+ * @brief builds the flat edge-indexed Tanner graph of H
+ * @param n_cols number of columns of H
+ * @param n_rows number of rows of H
+ * @param column_pointers column pointers of H in CSC
+ * @param row_index row indices of H in CSC
+ * @return the Tanner graph with both edge orderings and the permutations between them
+ */
+template<typename RowIndex>
+TannerGraph build_tanner_graph(int n_cols,
+                               int n_rows,
+                               const vector<uint32_t> &column_pointers,
+                               const vector<RowIndex> &row_index);
+
+
+/**
+ * @brief fills the 16-bit permutations of a graph with at most narrow_edge_limit edges
+ * @param graph flat Tanner graph of H, its 32-bit permutations must be built
+ */
+void build_narrow_edges(TannerGraph &graph);
 
 /**
  * @brief calculates the initial log likelihood ratios
@@ -149,7 +660,18 @@ tuple<vector<vector<int>>, vector<vector<int>>> calculate_vn_cv(int n_cols,
  * @param p the crossover probability
  * @return log-likelihood rations
  */
-vector<double> bsc_llr(vector<bool> &y, double p);
+vector<double> bsc_llr(const vector<bool> &y, double p);
+
+
+/**
+ * @brief calculates the initial log likelihood ratios into an existing buffer
+ * @param y the received message
+ * @param p the crossover probability
+ * @tparam T message type (float or double)
+ * @param llr output, resized to the size of y
+ */
+template<typename T>
+void bsc_llr(const vector<bool> &y, double p, vector<T> &llr);
 
 
 /**
@@ -160,5 +682,35 @@ vector<double> bsc_llr(vector<bool> &y, double p);
  * @param n_rows number of rows of H
  * @return the matrix product (the syndrome)
  */
-vector<bool>  encode(vector<bool> &in, vector<uint32_t> column_pointers,
-                     vector<uint16_t> row_index, uint16_t n_rows);
+template<typename RowIndex>
+vector<bool>  encode(const vector<bool> &in, const vector<uint32_t> &column_pointers,
+                     const vector<RowIndex> &row_index, size_t n_rows);
+
+
+/**
+ * @brief calculates the syndrome of the codeword into an existing buffer
+ * @param code the LDPC code
+ * @param in the input vector to multply with H
+ * @param out output syndrome, must have n_rows entries
+ */
+void encode(const LdpcCode &code, const vector<bool> &in, vector<bool> &out);
+
+
+/**
+ * @brief calculates the syndrome of a packed codeword with word-level operations
+ * @param code the LDPC code
+ * @param in the packed input frame with n_cols bits
+ * @param out output, packed syndrome with n_rows bits
+ */
+void encode(const LdpcCode &code, const PackedFrame &in, PackedFrame &out);
+
+
+/**
+ * @brief calculates the syndromes of many packed codewords, bit-sliced 64 frames at a time
+ * @param code the LDPC code
+ * @param in the packed input frames with n_cols bits each
+ * @param out output, packed syndromes with n_rows bits each
+ */
+void encode(const LdpcCode &code, const vector<PackedFrame> &in, vector<PackedFrame> &out);
+
+#endif //INFORMATION_THEORY_ENCODING_DECODING_H
@@ -0,0 +1,372 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Fixed-point decoder with 8- and 16-bit message stores.
+*/
+
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+#include "fixed_point_decoder.h"
+
+using namespace std;
+
+
+/**
+ * @brief quantizes a value to the fixed-point format, rounding to nearest and saturating
+ * @param v the value
+ * @param bits message width in bits
+ * @param frac_bits fractional bits
+ * @return the fixed-point value
+ */
+int32_t quantize_fixed(const double v, const int bits, const int frac_bits) {
+    const double max_mag = fixed_max_magnitude(bits);
+    const double scaled = round(ldexp(v, frac_bits));
+    if (std::isnan(scaled)) {
+        return 0;
+    }
+    return static_cast<int32_t>(min(max(scaled, -max_mag), max_mag));
+}
+
+
+/**
+ * @brief clamps a 32-bit intermediate to the symmetric message range
+ */
+static inline int32_t saturate_fixed(const int32_t v, const int32_t max_mag) {
+    return v > max_mag ? max_mag : (v < -max_mag ? -max_mag : v);
+}
+
+
+/**
+ * @brief tabulates the boxplus correction log(1 + exp(-x)) in fixed point
+ *
+ * Entry i holds the correction for |x| = i / 2^frac_bits, the table ends where the
+ * rounded correction becomes zero.
+ * @param ws decoder workspace, boxplus_table is rebuilt if frac_bits changed
+ * @param frac_bits fractional bits
+ */
+static void build_boxplus_table(DecoderWorkspace &ws, const int frac_bits) {
+    if (ws.boxplus_frac_bits == frac_bits) {
+        return;
+    }
+    ws.boxplus_table.clear();
+    for (int32_t i = 0;; ++i) {
+        const double x = ldexp(static_cast<double>(i), -frac_bits);
+        const int32_t f = static_cast<int32_t>(lround(ldexp(log1p(exp(-x)), frac_bits)));
+        if (f == 0) {
+            break;
+        }
+        ws.boxplus_table.push_back(f);
+    }
+    ws.boxplus_frac_bits = frac_bits;
+}
+
+
+/**
+ * @brief boxplus of two fixed-point LLRs, sign(a)sign(b)min(|a|,|b|) + f(|a+b|) - f(|a-b|)
+ * @param a first LLR
+ * @param b second LLR
+ * @param table correction table of build_boxplus_table
+ * @return the combined LLR, never larger in magnitude than min(|a|,|b|)
+ */
+static inline int32_t boxplus_fixed(const int32_t a, const int32_t b, const vector<int32_t> &table) {
+    const auto correction = [&table](const int32_t x) {
+        return static_cast<size_t>(x) < table.size() ? table[x] : 0;
+    };
+    const int32_t m = min(abs(a), abs(b));
+    const int32_t c = correction(abs(a + b)) - correction(abs(a - b));
+    if ((a < 0) != (b < 0)) {
+        return min(-m + c, 0);
+    }
+    return max(m + c, 0);
+}
+
+
+/**
+ * @brief fixed-point sum-product check node update, forward/backward boxplus per row
+ * @param msg_c output, check messages, variable order
+ * @param msg_v variable messages, check order
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param ws decoder workspace, provides the scratch and the boxplus table
+ * @param max_mag largest message magnitude
+ * @param c2v check_to_var edge permutation, 16 or 32 bit
+ */
+template<typename T, typename Index>
+static void check_node_update_fixed_sum_product(vector<T> &msg_c,
+                                                const vector<T> &msg_v,
+                                                const vector<bool> &syndrome,
+                                                const TannerGraph &graph,
+                                                DecoderWorkspace &ws,
+                                                const int32_t max_mag,
+                                                const Index *c2v) {
+    const vector<int32_t> &table = ws.boxplus_table;
+    for (size_t m = 0; m < static_cast<size_t>(graph.n_rows); ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t deg = graph.check_offsets[m + 1] - begin;
+        const int32_t sign = syndrome[m] ? -1 : 1;
+        if (deg == 1) {
+            msg_c[c2v[begin]] = static_cast<T>(sign * max_mag);
+            continue;
+        }
+
+        // forward[k] combines messages 0..k, backward[k] combines k..deg-1
+        int32_t *forward = ws.fixed_scratch.data();
+        int32_t *backward = forward + deg;
+        forward[0] = msg_v[begin];
+        for (uint32_t k = 1; k < deg; ++k) {
+            forward[k] = boxplus_fixed(forward[k - 1], msg_v[begin + k], table);
+        }
+        backward[deg - 1] = msg_v[begin + deg - 1];
+        for (uint32_t k = deg - 1; k-- > 0;) {
+            backward[k] = boxplus_fixed(msg_v[begin + k], backward[k + 1], table);
+        }
+
+        for (uint32_t k = 0; k < deg; ++k) {
+            int32_t extrinsic;
+            if (k == 0) {
+                extrinsic = backward[1];
+            } else if (k == deg - 1) {
+                extrinsic = forward[deg - 2];
+            } else {
+                extrinsic = boxplus_fixed(forward[k - 1], backward[k + 1], table);
+            }
+            msg_c[c2v[begin + k]] = static_cast<T>(saturate_fixed(sign * extrinsic, max_mag));
+        }
+    }
+}
+
+
+/**
+ * @brief fixed-point min-sum check node update
+ * @param msg_c output, check messages, variable order
+ * @param msg_v variable messages, check order
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale_q8 min-sum scaling factor with 8 fractional bits
+ * @param offset_q min-sum offset in the message format
+ * @param max_mag largest message magnitude
+ * @param c2v check_to_var edge permutation, 16 or 32 bit
+ */
+template<typename T, typename Index>
+static void check_node_update_fixed_min_sum(vector<T> &msg_c,
+                                            const vector<T> &msg_v,
+                                            const vector<bool> &syndrome,
+                                            const TannerGraph &graph,
+                                            const int32_t scale_q8,
+                                            const int32_t offset_q,
+                                            const int32_t max_mag,
+                                            const Index *c2v) {
+    const auto magnitude = [=](const int32_t min) {
+        return saturate_fixed(max(((min * scale_q8 + 128) >> 8) - offset_q, 0), max_mag);
+    };
+    for (size_t m = 0; m < static_cast<size_t>(graph.n_rows); ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+        int32_t min1 = max_mag;  // an empty minimum is the largest magnitude
+        int32_t min2 = max_mag;
+        uint32_t min1_pos = begin;
+        bool parity = syndrome[m];
+        for (uint32_t e = begin; e < end; ++e) {
+            const int32_t v = msg_v[e];
+            const int32_t mag = abs(v);
+            parity ^= v < 0;
+            if (mag < min1) {
+                min2 = min1;
+                min1 = mag;
+                min1_pos = e;
+            } else if (mag < min2) {
+                min2 = mag;
+            }
+        }
+
+        const int32_t out1 = magnitude(min1);
+        const int32_t out2 = magnitude(min2);
+        for (uint32_t e = begin; e < end; ++e) {
+            const int32_t mag = e == min1_pos ? out2 : out1;
+            msg_c[c2v[e]] = static_cast<T>(parity != (msg_v[e] < 0) ? -mag : mag);
+        }
+    }
+}
+
+
+/**
+ * @brief fixed-point variable node update fused with the hard decision
+ * @param msg_v output, variable messages, check order
+ * @param msg_c check messages, variable order
+ * @param llrs quantized initial LLRs
+ * @param graph flat Tanner graph of H
+ * @param ws decoder workspace, the hard decision and check parities are updated
+ * @param max_mag largest message magnitude
+ * @param v2c var_to_check edge permutation, 16 or 32 bit
+ * @return number of unsatisfied checks after the decision
+ */
+template<typename T, typename Index>
+static size_t var_node_update_fixed(vector<T> &msg_v,
+                                    const vector<T> &msg_c,
+                                    const vector<T> &llrs,
+                                    const TannerGraph &graph,
+                                    DecoderWorkspace &ws,
+                                    const int32_t max_mag,
+                                    const Index *v2c) {
+    for (size_t j = 0; j < llrs.size(); ++j) {
+        const uint32_t begin = graph.var_offsets[j];
+        const uint32_t end = graph.var_offsets[j + 1];
+        int32_t sum = llrs[j];
+        for (uint32_t e = begin; e < end; ++e) {
+            sum += msg_c[e];
+        }
+        for (uint32_t e = begin; e < end; ++e) {
+            msg_v[v2c[e]] = static_cast<T>(saturate_fixed(sum - msg_c[e], max_mag));
+        }
+        update_decision(ws, graph, j, sum < 0);
+    }
+    return ws.n_unsatisfied;
+}
+
+
+/**
+ * @brief the fixed-point decoding loop for one message store type
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+template<typename T>
+static bool decode_fixed_point_store(const LdpcCode &code,
+                                     const vector<double> &llrs,
+                                     const vector<bool> &syndrome,
+                                     DecoderWorkspace &ws,
+                                     const DecoderConfig &config) {
+    const TannerGraph &graph = code.graph;
+    vector<T> &msg_v = message_buffers<T>(ws).msg_v;
+    vector<T> &msg_c = message_buffers<T>(ws).msg_c;
+    vector<T> &q_llrs = message_buffers<T>(ws).llrs;
+    const int bits = config.fixed_bits;
+    const int frac_bits = config.fixed_frac_bits;
+    const int32_t max_mag = fixed_max_magnitude(bits);
+
+    msg_v.resize(graph.n_edges());
+    msg_c.resize(graph.n_edges());
+    q_llrs.resize(code.n_cols);
+    for (size_t j = 0; j < llrs.size(); ++j) {
+        q_llrs[j] = static_cast<T>(quantize_fixed(llrs[j], bits, frac_bits));
+    }
+
+    double ms_scale, ms_offset;
+    min_sum_parameters(config, ms_scale, ms_offset);
+    const int32_t scale_q8 = static_cast<int32_t>(lround(ms_scale * 256));
+    const int32_t offset_q = static_cast<int32_t>(lround(ldexp(ms_offset, frac_bits)));
+    if (config.rule == CheckNodeRule::sum_product) {
+        build_boxplus_table(ws, frac_bits);
+        ws.fixed_scratch.resize(2 * static_cast<size_t>(code.max_check_degree));
+    }
+
+    // initialize msg_v
+    for (size_t e = 0; e < msg_v.size(); ++e) {
+        msg_v[e] = q_llrs[graph.check_vars[e]];
+    }
+    reset_syndrome_tracking(ws, syndrome);
+
+    bool success = false;
+    PhaseTimer timer(ws.statistics);
+    with_edge_index(graph, [&](const auto *c2v, const auto *v2c) {
+        for (size_t it = 0; it < config.max_num_iter && !success; ++it) {
+            if (config.rule == CheckNodeRule::sum_product) {
+                check_node_update_fixed_sum_product(msg_c, msg_v, syndrome, graph, ws, max_mag, c2v);
+            } else {
+                check_node_update_fixed_min_sum(msg_c, msg_v, syndrome, graph, scale_q8, offset_q, max_mag, c2v);
+            }
+            timer.lap(&FrameStatistics::check_node_seconds);
+
+            // variable nodes and hard decision, terminate if codeword matches syndrome
+            success = var_node_update_fixed(msg_v, msg_c, q_llrs, graph, ws, max_mag, v2c) == 0;
+            timer.lap(&FrameStatistics::var_node_seconds);
+            record_iteration(ws);
+        }
+    });
+
+    // saturating integers can't diverge
+    return stop_decoding(ws, success ? Termination::converged : Termination::max_iterations);
+}
+
+
+/**
+ * @brief Tries to decode the given codeword with fixed-point messages
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters, config.fixed_bits must be in 2..16
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_fixed_point(const LdpcCode &code,
+                        const vector<double> &llrs,
+                        const vector<bool> &syndrome,
+                        DecoderWorkspace &ws,
+                        const DecoderConfig &config) {
+    // check inputs.
+    if (llrs.size() != code.n_cols) {
+        throw runtime_error("input doesn't match H.");
+    }
+
+    if (syndrome.size() != code.n_rows) {
+        throw runtime_error(
+                "checksum doesn't match number of rows in H");
+    }
+
+    if (ws.out.size() != code.n_cols || ws.unsatisfied.size() != code.n_rows) {
+        throw runtime_error("decoder workspace doesn't match H.");
+    }
+
+    if (config.fixed_bits < 2 || config.fixed_bits > 16) {
+        throw runtime_error("fixed-point messages must have 2 to 16 bits.");
+    }
+
+    if (config.fixed_frac_bits < 0 || config.fixed_frac_bits >= config.fixed_bits) {
+        throw runtime_error("fixed-point fractional bits must be less than the message width.");
+    }
+
+    if (config.schedule != Schedule::flooding) {
+        throw runtime_error("the fixed-point decoder only supports the flooding schedule.");
+    }
+
+    if (config.warm_start) {
+        throw runtime_error("the fixed-point decoder doesn't support warm starts.");
+    }
+
+    if (ws.statistics) {
+        ws.statistics->reset();
+    }
+    if (config.fixed_bits <= 8) {
+        return decode_fixed_point_store<int8_t>(code, llrs, syndrome, ws, config);
+    }
+    return decode_fixed_point_store<int16_t>(code, llrs, syndrome, ws, config);
+}
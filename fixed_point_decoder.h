@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Fixed-point decoder: messages are stored as 8- or 16-bit integers with a
+configurable number of fractional bits, all node updates run on integers and
+saturate to the message range when they are stored.
+*/
+
+
+#ifndef INFORMATION_THEORY_FIXED_POINT_DECODER_H
+#define INFORMATION_THEORY_FIXED_POINT_DECODER_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+/**
+ * @brief largest message magnitude of the fixed-point format, the range is symmetric
+ * @param bits message width in bits
+ * @return 2^(bits-1) - 1
+ */
+inline int32_t fixed_max_magnitude(const int bits) {
+    return (int32_t(1) << (bits - 1)) - 1;
+}
+
+
+/**
+ * @brief quantizes a value to the fixed-point format, rounding to nearest and saturating
+ * @param v the value
+ * @param bits message width in bits
+ * @param frac_bits fractional bits
+ * @return the fixed-point value
+ */
+int32_t quantize_fixed(double v, int bits, int frac_bits);
+
+
+/**
+ * @brief Tries to decode the given codeword with fixed-point messages
+ *
+ * Same flooding schedule and termination as the floating point decoder. The LLRs
+ * are quantized to config.fixed_bits bits with config.fixed_frac_bits fractional
+ * bits, messages are kept in an int8_t store up to 8 bits and an int16_t store above,
+ * intermediate sums use 32 bits and are saturated when stored, so the message range
+ * takes the place of config.vsat. The min-sum rules scale and offset in fixed point,
+ * the sum-product rule uses the boxplus operation with a tabulated correction term.
+ * @param code the LDPC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome The checksum/syndrome of the codeword
+ * @param ws decoder workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters, config.fixed_bits must be in 2..16
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_fixed_point(const LdpcCode &code,
+                        const vector<double> &llrs,
+                        const vector<bool> &syndrome,
+                        DecoderWorkspace &ws,
+                        const DecoderConfig &config);
+
+#endif //INFORMATION_THEORY_FIXED_POINT_DECODER_H
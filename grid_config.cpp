@@ -0,0 +1,532 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Reading grid sweep configs and writing the results of grid sweeps.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <stdexcept>
+#include "grid_config.h"
+#include "simulation_utils.h"
+#include "code_io.h"
+
+using namespace std;
+
+
+/**
+ * @brief parses a number of a config line
+ * @param token the text
+ * @param line line number, for the error message
+ * @return the number
+ */
+static double parse_number(const string &token, const size_t line) {
+    size_t end = 0;
+    double value = 0;
+    try {
+        value = stod(token, &end);
+    } catch (const logic_error &) {
+        end = 0;
+    }
+    if (end == 0 || end != token.size()) {
+        throw runtime_error("grid config line " + to_string(line) + ": not a number: " + token);
+    }
+    return value;
+}
+
+
+/**
+ * @brief parses a non-negative integer of a config line
+ * @param token the text
+ * @param line line number, for the error message
+ * @return the integer
+ */
+static size_t parse_count(const string &token, const size_t line) {
+    const double value = parse_number(token, line);
+    if (value < 0 || value != static_cast<double>(static_cast<size_t>(value))) {
+        throw runtime_error("grid config line " + to_string(line) + ": not a count: " + token);
+    }
+    return static_cast<size_t>(value);
+}
+
+
+/**
+ * @brief sets one key=value option of a decoder line
+ * @param option the option
+ * @param line line number, for the error message
+ * @param grid_decoder the decoder to set it in
+ */
+static void parse_decoder_option(const string &option, const size_t line, GridDecoder &grid_decoder) {
+    DecoderConfig &decoder = grid_decoder.decoder;
+    const size_t eq = option.find('=');
+    const string key = option.substr(0, eq);
+    const string value = eq == string::npos ? string() : option.substr(eq + 1);
+    auto bad_value = [&]() {
+        return runtime_error("grid config line " + to_string(line) + ": bad decoder option: " + option);
+    };
+
+    if (key == "rule") {
+        try {
+            decoder.rule = check_node_rule_from_name(value);
+        } catch (const runtime_error &) {
+            throw bad_value();
+        }
+    } else if (key == "schedule") {
+        if (value == "flooding") { decoder.schedule = Schedule::flooding; }
+        else if (value == "layered") { decoder.schedule = Schedule::layered; }
+        else { throw bad_value(); }
+    } else if (key == "type") {
+        if (value == "double") { decoder.message_type = MessageType::float64; }
+        else if (value == "float") { decoder.message_type = MessageType::float32; }
+        else if (value == "fixed") { decoder.message_type = MessageType::fixed_point; }
+        else { throw bad_value(); }
+    } else if (key == "scale") {
+        decoder.ms_scale = parse_number(value, line);
+    } else if (key == "offset") {
+        decoder.ms_offset = parse_number(value, line);
+    } else if (key == "vsat") {
+        decoder.vsat = parse_number(value, line);
+    } else if (key == "fixed_bits") {
+        decoder.fixed_bits = static_cast<int>(parse_count(value, line));
+    } else if (key == "fixed_frac_bits") {
+        decoder.fixed_frac_bits = static_cast<int>(parse_count(value, line));
+    } else if (key == "iterations") {
+        decoder.max_num_iter = parse_count(value, line);
+    } else if (key == "merges") {
+        grid_decoder.merges = parse_count(value, line);
+    } else if (key == "split") {
+        grid_decoder.merges_per_step = parse_count(value, line);
+    } else {
+        throw bad_value();
+    }
+}
+
+
+/**
+ * @brief reads a grid sweep config
+ * @param in the config text
+ * @return the config
+ */
+GridConfig read_grid_config(istream &in) {
+    GridConfig config;
+    string text;
+    for (size_t line = 1; getline(in, text); ++line) {
+        const size_t comment = text.find('#');
+        if (comment != string::npos) {
+            text.erase(comment);
+        }
+        istringstream tokens(text);
+        vector<string> words;
+        for (string word; tokens >> word;) {
+            words.push_back(word);
+        }
+        if (words.empty()) {
+            continue;
+        }
+
+        const string &key = words[0];
+        auto expect_values = [&](const size_t n) {
+            if (words.size() != n + 1) {
+                throw runtime_error("grid config line " + to_string(line) + ": " + key + " takes "
+                                    + to_string(n) + " value(s).");
+            }
+        };
+
+        if (key == "code") {
+            if (words.size() < 4) {
+                throw runtime_error("grid config line " + to_string(line)
+                                    + ": code needs a name, a file and crossover probabilities.");
+            }
+            GridCode code;
+            code.name = words[1];
+            code.path = words[2];
+            if (words[3] == "linspace") {
+                if (words.size() != 7) {
+                    throw runtime_error("grid config line " + to_string(line)
+                                        + ": linspace takes <min> <max> <steps>.");
+                }
+                code.p_values = linspace(parse_number(words[4], line), parse_number(words[5], line),
+                                         static_cast<int>(parse_count(words[6], line)));
+            } else {
+                for (size_t w = 3; w < words.size(); w++) {
+                    code.p_values.push_back(parse_number(words[w], line));
+                }
+            }
+            for (const auto &existing : config.codes) {
+                if (existing.name == code.name) {
+                    throw runtime_error("grid config line " + to_string(line) + ": duplicate code " + code.name);
+                }
+            }
+            config.codes.push_back(code);
+        } else if (key == "decoder") {
+            if (words.size() < 2) {
+                throw runtime_error("grid config line " + to_string(line) + ": decoder needs a name.");
+            }
+            GridDecoder decoder;
+            decoder.name = words[1];
+            for (size_t w = 2; w < words.size(); w++) {
+                parse_decoder_option(words[w], line, decoder);
+            }
+            config.decoders.push_back(decoder);
+        } else if (key == "iterations") {
+            for (size_t w = 1; w < words.size(); w++) {
+                config.iteration_caps.push_back(parse_count(words[w], line));
+            }
+        } else if (key == "frames") {
+            expect_values(1);
+            config.sweep.frames_per_point = parse_count(words[1], line);
+        } else if (key == "min_frame_errors") {
+            expect_values(1);
+            config.sweep.min_frame_errors = parse_count(words[1], line);
+        } else if (key == "target_relative_width") {
+            expect_values(1);
+            config.sweep.target_relative_width = parse_number(words[1], line);
+        } else if (key == "seconds_per_point") {
+            expect_values(1);
+            config.sweep.seconds_per_point = parse_number(words[1], line);
+        } else if (key == "interval") {
+            expect_values(1);
+            if (words[1] == "wilson") {
+                config.sweep.interval = IntervalMethod::wilson;
+            } else if (words[1] == "clopper_pearson") {
+                config.sweep.interval = IntervalMethod::clopper_pearson;
+            } else {
+                throw runtime_error("grid config line " + to_string(line) + ": unknown interval " + words[1]);
+            }
+        } else if (key == "chunk_size") {
+            expect_values(1);
+            config.sweep.chunk_size = parse_count(words[1], line);
+        } else if (key == "seed") {
+            expect_values(1);
+            config.sweep.seed = parse_count(words[1], line);
+        } else if (key == "threads") {
+            expect_values(1);
+            config.sweep.n_threads = static_cast<unsigned>(parse_count(words[1], line));
+        } else if (key == "batch_size") {
+            expect_values(1);
+            config.sweep.batch_size = parse_count(words[1], line);
+        } else if (key == "output") {
+            expect_values(1);
+            config.output = words[1];
+        } else {
+            throw runtime_error("grid config line " + to_string(line) + ": unknown key " + key);
+        }
+    }
+
+    if (config.codes.empty()) {
+        throw runtime_error("grid config without codes.");
+    }
+    if (config.decoders.empty()) {
+        config.decoders.push_back({"default", DecoderConfig()});
+    }
+    return config;
+}
+
+
+/**
+ * @brief reads a grid sweep config from a file
+ * @param path config file
+ * @return the config
+ */
+GridConfig read_grid_config(const string &path) {
+    ifstream in(path);
+    if (!in) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    return read_grid_config(in);
+}
+
+
+/**
+ * @brief lists the points of the grid, by code, decoder, iteration cap and p
+ * @param config the grid
+ * @return the points
+ */
+vector<GridPoint> grid_points(const GridConfig &config) {
+    vector<GridPoint> points;
+    size_t first_stream = 0;
+    for (size_t c = 0; c < config.codes.size(); c++) {
+        for (size_t d = 0; d < config.decoders.size(); d++) {
+            vector<size_t> caps = config.iteration_caps;
+            if (caps.empty()) {
+                caps.push_back(config.decoders[d].decoder.max_num_iter);
+            }
+            for (const size_t cap : caps) {
+                for (size_t i = 0; i < config.codes[c].p_values.size(); i++) {
+                    points.push_back({c, d, cap, config.codes[c].p_values[i], first_stream + i});
+                }
+            }
+        }
+        first_stream += config.codes[c].p_values.size();
+    }
+    return points;
+}
+
+
+/**
+ * @brief loads the codes of a grid and builds the rate steps of its rate-adaptive decoders
+ * @param config the grid
+ * @return the codes
+ */
+GridCodes load_grid_codes(const GridConfig &config) {
+    GridCodes codes;
+    codes.codes.reserve(config.codes.size());
+    codes.rate_adaptive.resize(config.codes.size() * config.decoders.size());
+    for (size_t c = 0; c < config.codes.size(); c++) {
+        codes.codes.push_back(load_ldpc_code(config.codes[c].path));
+        for (size_t d = 0; d < config.decoders.size(); d++) {
+            const GridDecoder &decoder = config.decoders[d];
+            if (decoder.merges > 0) {
+                const auto merges = default_row_merges(codes.codes[c], decoder.merges);
+                codes.rate_adaptive[c * config.decoders.size() + d] = make_rate_adaptive_code(
+                        codes.codes[c], merges, decoder.merges_per_step ? decoder.merges_per_step : merges.size());
+            }
+        }
+    }
+    return codes;
+}
+
+
+/**
+ * @brief the jobs of the grid points, for run_grid_sweep with the codes in the order
+ * of config.codes
+ * @param config the grid
+ * @param codes the codes, from load_grid_codes
+ * @param points the points, from grid_points
+ * @return one job per point
+ */
+vector<GridJob> make_grid_jobs(const GridConfig &config, const GridCodes &codes, const vector<GridPoint> &points) {
+    vector<GridJob> jobs(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        if (config.decoders.at(points[i].decoder).merges > 0) {
+            jobs[i].rate_adaptive = &codes.rate_adaptive.at(points[i].code * config.decoders.size()
+                                                            + points[i].decoder);
+        }
+        jobs[i].code = points[i].code;
+        jobs[i].p = points[i].p;
+        jobs[i].decoder = config.decoders.at(points[i].decoder).decoder;
+        jobs[i].decoder.max_num_iter = points[i].iteration_cap;
+        jobs[i].stream = points[i].stream;
+    }
+    return jobs;
+}
+
+
+/**
+ * @brief writes the results of a grid sweep as CSV, one line per point
+ * @param out the stream
+ * @param config the grid
+ * @param points the points
+ * @param results one result per point
+ */
+void write_grid_results(ostream &out,
+                        const GridConfig &config,
+                        const vector<GridPoint> &points,
+                        const vector<SweepPointResult> &results) {
+    if (points.size() != results.size()) {
+        throw runtime_error("grid points don't match the results.");
+    }
+    const auto precision = out.precision(10);
+    out << "code,decoder,iterations,p,frames,successes,fer,fer_low,fer_high,syndrome_bits,seconds,stop_reason\n";
+    for (size_t i = 0; i < points.size(); i++) {
+        const SweepPointResult &r = results[i];
+        out << config.codes.at(points[i].code).name << ',' << config.decoders.at(points[i].decoder).name << ','
+            << points[i].iteration_cap << ',' << points[i].p << ',' << r.frames << ',' << r.successes << ','
+            << r.fer << ',' << r.fer_low << ',' << r.fer_high << ',' << r.syndrome_bits << ',' << r.seconds << ','
+            << stop_reason_name(r.stop_reason) << '\n';
+    }
+    out.precision(precision);
+}
+
+
+/**
+ * @brief hash of everything in a grid config that affects its results, so shards of
+ * different configs are not merged
+ *
+ * Covers the code files and crossover probabilities, every decoder parameter, the
+ * iteration caps and the frames, stopping rule, intervals, chunking, seed and batch
+ * size of the sweep. Names, threads, the shard and the output file are left out.
+ * @param config the grid
+ * @return FNV-1a hash of the normalized config text
+ */
+static uint64_t grid_config_hash(const GridConfig &config) {
+    ostringstream text;
+    text.precision(17);
+    for (const auto &code : config.codes) {
+        text << "code " << code.path;
+        for (const double p : code.p_values) {
+            text << ' ' << p;
+        }
+        text << '\n';
+    }
+    for (const auto &d : config.decoders) {
+        const DecoderConfig &c = d.decoder;
+        text << "decoder " << static_cast<int>(c.rule) << ' ' << static_cast<int>(c.schedule) << ' '
+             << static_cast<int>(c.simd) << ' ' << static_cast<int>(c.message_type) << ' ' << c.ms_scale << ' '
+             << c.ms_offset << ' ' << c.max_num_iter << ' ' << c.vsat << ' ' << c.fixed_bits << ' '
+             << c.fixed_frac_bits << ' ' << c.warm_start << ' ' << d.merges << ' ' << d.merges_per_step << '\n';
+    }
+    text << "iterations";
+    for (const size_t cap : config.iteration_caps) {
+        text << ' ' << cap;
+    }
+    const SweepConfig &s = config.sweep;
+    text << "\nsweep " << s.frames_per_point << ' ' << s.min_frame_errors << ' ' << s.target_relative_width << ' '
+         << s.seconds_per_point << ' ' << static_cast<int>(s.interval) << ' ' << s.confidence << ' '
+         << s.chunk_size << ' ' << s.seed << ' ' << s.batch_size << '\n';
+
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char ch : text.str()) {
+        h = (h ^ static_cast<unsigned char>(ch)) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+
+/**
+ * @brief writes the results of one shard of a grid sweep
+ * @param out the stream
+ * @param config the grid, with the shard in config.sweep
+ * @param points the points
+ * @param results one result per point, from run_grid_sweep
+ */
+void write_grid_shard(ostream &out,
+                      const GridConfig &config,
+                      const vector<GridPoint> &points,
+                      const vector<SweepPointResult> &results) {
+    if (points.size() != results.size()) {
+        throw runtime_error("grid points don't match the results.");
+    }
+    const auto precision = out.precision(17);
+    out << "grid_shard 2\n"
+        << "shard " << config.sweep.shard_index << ' ' << config.sweep.shard_count << '\n'
+        << "seed " << config.sweep.seed << '\n'
+        << "frames " << config.sweep.frames_per_point << '\n'
+        << "chunk_size " << config.sweep.chunk_size << '\n'
+        << "min_frame_errors " << config.sweep.min_frame_errors << '\n'
+        << "config " << grid_config_hash(config) << '\n'
+        << "points " << points.size() << '\n';
+    // one line per point: p, seconds, number of chunks, their successes and syndrome bits
+    for (size_t i = 0; i < points.size(); i++) {
+        const SweepPointResult &r = results[i];
+        out << points[i].p << ' ' << r.seconds << ' ' << r.chunk_successes.size();
+        for (const size_t successes : r.chunk_successes) {
+            out << ' ' << successes;
+        }
+        for (const uint64_t bits : r.chunk_syndrome_bits) {
+            out << ' ' << bits;
+        }
+        out << '\n';
+    }
+    out.precision(precision);
+}
+
+
+/**
+ * @brief reads one header entry of a shard file
+ * @param in the shard file
+ * @param path its path, for the error message
+ * @param key the expected key
+ * @return the value
+ */
+static uint64_t read_shard_entry(istream &in, const string &path, const string &key) {
+    string word;
+    uint64_t value = 0;
+    if (!(in >> word >> value) || word != key) {
+        throw runtime_error(path + ": bad shard file, expected " + key + ".");
+    }
+    return value;
+}
+
+
+/**
+ * @brief reads the shard files of a grid sweep and merges them with merge_sweep_shards
+ * @param config the grid the shards were run with
+ * @param paths the shard files, in any order
+ * @return one result per point of grid_points(config), equal to an unsharded run
+ */
+vector<SweepPointResult> merge_grid_shards(const GridConfig &config, const vector<string> &paths) {
+    const vector<GridPoint> points = grid_points(config);
+    vector<vector<SweepPointResult>> shards(paths.size());
+    vector<bool> seen(paths.size());
+    for (const auto &path : paths) {
+        ifstream in(path);
+        if (!in) {
+            throw runtime_error("can't open " + path + ".");
+        }
+        if (read_shard_entry(in, path, "grid_shard") != 2) {
+            throw runtime_error(path + ": unsupported shard file version.");
+        }
+        string word;
+        size_t index = 0;
+        size_t count = 0;
+        if (!(in >> word >> index >> count) || word != "shard") {
+            throw runtime_error(path + ": bad shard file, expected shard.");
+        }
+        if (count != paths.size() || index >= count) {
+            throw runtime_error(path + ": shard " + to_string(index) + " of " + to_string(count)
+                                + ", but " + to_string(paths.size()) + " shard files are given.");
+        }
+        if (seen[index]) {
+            throw runtime_error(path + ": shard " + to_string(index) + " is given twice.");
+        }
+        seen[index] = true;
+        if (read_shard_entry(in, path, "seed") != config.sweep.seed
+            || read_shard_entry(in, path, "frames") != config.sweep.frames_per_point
+            || read_shard_entry(in, path, "chunk_size") != config.sweep.chunk_size
+            || read_shard_entry(in, path, "min_frame_errors") != config.sweep.min_frame_errors
+            || read_shard_entry(in, path, "config") != grid_config_hash(config)
+            || read_shard_entry(in, path, "points") != points.size()) {
+            throw runtime_error(path + ": the shard was run with a different config.");
+        }
+
+        vector<SweepPointResult> &results = shards[index];
+        results.resize(points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            size_t n_chunks = 0;
+            if (!(in >> results[i].p >> results[i].seconds >> n_chunks)) {
+                throw runtime_error(path + ": truncated shard file.");
+            }
+            if (results[i].p != points[i].p) {
+                throw runtime_error(path + ": the shard was run with different crossover probabilities.");
+            }
+            results[i].chunk_successes.resize(n_chunks);
+            for (auto &successes : results[i].chunk_successes) {
+                if (!(in >> successes)) {
+                    throw runtime_error(path + ": truncated shard file.");
+                }
+            }
+            results[i].chunk_syndrome_bits.resize(n_chunks);
+            for (auto &bits : results[i].chunk_syndrome_bits) {
+                if (!(in >> bits)) {
+                    throw runtime_error(path + ": truncated shard file.");
+                }
+            }
+        }
+    }
+    return merge_sweep_shards(config.sweep, shards);
+}
@@ -0,0 +1,214 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Grid sweeps from a config file: a list of codes with their crossover probabilities,
+decoder modes and iteration caps, whose cross product is simulated by
+run_grid_sweep. The format is line based, '#' starts a comment:
+
+    code 1908_212_4 codes/1908_212_4_colmn_pointers.npy linspace 0.0109 0.0144 5
+    code 4095_737_101 codes/4095_737_101_colmn_pointers.npy 0.016 0.018 0.02
+    decoder spa
+    decoder nms_layered rule=normalized_min_sum schedule=layered type=float
+    decoder adaptive rule=normalized_min_sum merges=150 split=25
+    iterations 25 50 100
+    frames 10000
+    min_frame_errors 100
+    seed 1
+    output results/grid.csv
+
+A code takes a name, its file (anything load_ldpc_code reads) and its crossover
+probabilities, given as numbers or as "linspace <min> <max> <steps>". A decoder takes
+a name and key=value options: rule, schedule (flooding, layered), type (double,
+float, fixed), scale, offset, vsat, fixed_bits, fixed_frac_bits and iterations.
+With merges=<pairs> the decoder is rate-adaptive (see rate_adaptive.h): that many
+row pairs of the code are merged, and split=<pairs> of them are revealed per step
+(all at once by default); the results then report the mean syndrome bits revealed.
+Without decoder lines the default DecoderConfig is used, without an iterations line
+every decoder keeps its own cap. The remaining keys set the SweepConfig: frames,
+min_frame_errors, target_relative_width, seconds_per_point, interval (wilson,
+clopper_pearson), chunk_size, seed, threads, batch_size, and output names the CSV
+file of the results. All decoders and iteration caps at one code and p decode the same
+frames, so their differences are not sampling noise of the channel.
+
+Large grids can be split over processes or machines: shard i of N runs every N-th
+chunk of every point (SweepConfig::shard_index, shard_count) and writes its chunk
+results with write_grid_shard; merge_grid_shards combines the shard files into the
+results of a single run.
+*/
+
+
+#ifndef INFORMATION_THEORY_GRID_CONFIG_H
+#define INFORMATION_THEORY_GRID_CONFIG_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include "sweep.h"
+
+using namespace std;
+
+
+/**
+ * @brief a code of the grid with the crossover probabilities to simulate it at
+ */
+struct GridCode {
+    string name;
+    string path;                       // file of the code, for load_ldpc_code
+    vector<double> p_values;
+};
+
+
+/**
+ * @brief a decoder mode of the grid
+ */
+struct GridDecoder {
+    string name;
+    DecoderConfig decoder;
+    size_t merges = 0;                 // row pairs merged for rate-adaptive decoding, 0 decodes at the code rate
+    size_t merges_per_step = 0;        // pairs split per rate step, 0 splits all of them at once
+};
+
+
+/**
+ * @brief a grid sweep: every code at its crossover probabilities with every decoder
+ * and iteration cap
+ */
+struct GridConfig {
+    vector<GridCode> codes;
+    vector<GridDecoder> decoders;      // at least one
+    vector<size_t> iteration_caps;     // empty keeps the max_num_iter of the decoders
+    SweepConfig sweep;                 // frames, stopping rule, seed and threads of all jobs
+    string output;                     // CSV file of the results, empty writes to stdout
+};
+
+
+/**
+ * @brief reads a grid sweep config
+ * @param in the config text
+ * @return the config
+ */
+GridConfig read_grid_config(istream &in);
+
+
+/**
+ * @brief reads a grid sweep config from a file
+ * @param path config file
+ * @return the config
+ */
+GridConfig read_grid_config(const string &path);
+
+
+/**
+ * @brief a job of the grid with the entries it came from
+ */
+struct GridPoint {
+    size_t code{};                     // index into GridConfig::codes
+    size_t decoder{};                  // index into GridConfig::decoders
+    size_t iteration_cap{};            // max_num_iter of the job
+    double p{};
+    size_t stream{};                   // random stream, one per code and p, shared by the decoders
+};
+
+
+/**
+ * @brief lists the points of the grid, by code, decoder, iteration cap and p
+ * @param config the grid
+ * @return the points
+ */
+vector<GridPoint> grid_points(const GridConfig &config);
+
+
+/**
+ * @brief the codes of a grid, each loaded once and shared by all of its jobs
+ */
+struct GridCodes {
+    vector<LdpcCode> codes;            // per entry of GridConfig::codes
+    vector<RateAdaptiveCode> rate_adaptive;  // per code and decoder, code * decoders + decoder,
+                                       // only built for rate-adaptive decoders
+};
+
+
+/**
+ * @brief loads the codes of a grid and builds the rate steps of its rate-adaptive decoders
+ * @param config the grid
+ * @return the codes
+ */
+GridCodes load_grid_codes(const GridConfig &config);
+
+
+/**
+ * @brief the jobs of the grid points, for run_grid_sweep with the codes in the order
+ * of config.codes
+ * @param config the grid
+ * @param codes the codes, from load_grid_codes
+ * @param points the points, from grid_points
+ * @return one job per point
+ */
+vector<GridJob> make_grid_jobs(const GridConfig &config, const GridCodes &codes, const vector<GridPoint> &points);
+
+
+/**
+ * @brief writes the results of a grid sweep as CSV, one line per point: code, decoder,
+ * iterations, p, frames, successes, fer, fer_low, fer_high, syndrome_bits (mean per
+ * frame), seconds, stop_reason
+ * @param out the stream
+ * @param config the grid
+ * @param points the points
+ * @param results one result per point
+ */
+void write_grid_results(ostream &out,
+                        const GridConfig &config,
+                        const vector<GridPoint> &points,
+                        const vector<SweepPointResult> &results);
+
+
+/**
+ * @brief writes the results of one shard of a grid sweep (config.sweep.shard_index of
+ * shard_count), the chunk results of every point for merge_grid_shards
+ * @param out the stream
+ * @param config the grid, with the shard in config.sweep
+ * @param points the points
+ * @param results one result per point, from run_grid_sweep
+ */
+void write_grid_shard(ostream &out,
+                      const GridConfig &config,
+                      const vector<GridPoint> &points,
+                      const vector<SweepPointResult> &results);
+
+
+/**
+ * @brief reads the shard files of a grid sweep and merges them with merge_sweep_shards
+ *
+ * The shards must come from the same config (a hash of the code files, crossover
+ * probabilities, decoders, iteration caps and sweep settings is checked) and cover
+ * every shard index exactly once.
+ * @param config the grid the shards were run with
+ * @param paths the shard files, in any order
+ * @return one result per point of grid_points(config), equal to an unsharded run
+ */
+vector<SweepPointResult> merge_grid_shards(const GridConfig &config, const vector<string> &paths);
+
+
+#endif //INFORMATION_THEORY_GRID_CONFIG_H
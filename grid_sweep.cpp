@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Grid sweep runner: reads a config of codes, crossover probabilities, decoder modes
+and iteration caps (see grid_config.h), loads every code once and simulates all
+points of the grid on one pool of worker threads. The results go to the CSV file
+of the config or stdout, progress to stderr. With --shard i/N only shard i of N
+runs and its chunk results go to <output>.shard<i>, merge_shards combines the shard
+files into the CSV file of a single run.
+
+    grid_sweep grid_sweep.cfg
+    grid_sweep --threads 8 --output results/grid.csv grid_sweep.cfg
+    grid_sweep --shard 0/4 grid_sweep.cfg
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "grid_config.h"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    const string usage = string("usage: ") + argv[0]
+                         + " [--threads <n>] [--output <csv>] [--shard <i>/<n>] <config>";
+    string config_path;
+    string output;
+    unsigned n_threads = 0;
+    bool threads_given = false;
+    size_t shard_index = 0;
+    size_t shard_count = 1;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const string arg = argv[a];
+            auto value = [&]() -> string {
+                if (a + 1 >= argc) {
+                    throw runtime_error(arg + " needs a value.");
+                }
+                return argv[++a];
+            };
+            if (arg == "--threads") {
+                n_threads = static_cast<unsigned>(stoul(value()));
+                threads_given = true;
+            } else if (arg == "--output") {
+                output = value();
+            } else if (arg == "--shard") {
+                const string shard = value();
+                const size_t slash = shard.find('/');
+                if (slash == string::npos) {
+                    throw runtime_error("--shard takes <i>/<n>.");
+                }
+                shard_index = stoul(shard.substr(0, slash));
+                shard_count = stoul(shard.substr(slash + 1));
+                if (shard_count == 0 || shard_index >= shard_count) {
+                    throw runtime_error("--shard " + shard + ": needs 0 <= i < n.");
+                }
+            } else if (config_path.empty() && arg.compare(0, 2, "--") != 0) {
+                config_path = arg;
+            } else {
+                throw runtime_error("unexpected argument " + arg);
+            }
+        }
+        if (config_path.empty()) {
+            throw runtime_error("no config given.");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl << usage << endl;
+        return 2;
+    }
+
+    try {
+        GridConfig config = read_grid_config(config_path);
+        if (threads_given) {
+            config.sweep.n_threads = n_threads;
+        }
+        if (!output.empty()) {
+            config.output = output;
+        }
+        config.sweep.shard_index = shard_index;
+        config.sweep.shard_count = shard_count;
+        const bool sharded = shard_count > 1;
+        if (sharded && !config.output.empty()) {
+            config.output += ".shard" + to_string(shard_index);
+        }
+
+        // every code is loaded once and shared read-only by all jobs
+        const GridCodes codes = load_grid_codes(config);
+        vector<const LdpcCode *> code_pointers;
+        for (size_t c = 0; c < codes.codes.size(); c++) {
+            code_pointers.push_back(&codes.codes[c]);
+            cerr << config.codes[c].name << ": " << codes.codes[c].n_cols << " columns, " << codes.codes[c].n_rows
+                 << " rows, " << config.codes[c].p_values.size() << " crossover probabilities" << endl;
+        }
+
+        const vector<GridPoint> points = grid_points(config);
+        cerr << points.size() << " grid points, up to " << config.sweep.frames_per_point << " frames each";
+        if (sharded) {
+            cerr << ", shard " << shard_index << " of " << shard_count;
+        }
+        cerr << endl;
+        const auto start = chrono::steady_clock::now();
+        const vector<SweepPointResult> results = run_grid_sweep(code_pointers, make_grid_jobs(config, codes, points),
+                                                                config.sweep);
+        cerr << "done in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s"
+             << endl;
+
+        auto write = [&](ostream &out) {
+            if (sharded) {
+                write_grid_shard(out, config, points, results);
+            } else {
+                write_grid_results(out, config, points, results);
+            }
+        };
+        if (config.output.empty()) {
+            write(cout);
+        } else {
+            ofstream out(config.output);
+            write(out);
+            if (!out) {
+                throw runtime_error("can't write " + config.output + ".");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+
+Polynomial expm1 and log approximations of the sum-product kernels: the series
+coefficients used by the intrinsics in simd_kernels.cpp, and the same algorithms
+written with GCC vector extensions for kernels templated on the lane count, as in
+batch_decoder.cpp. Both reduce the arguments the same way, so they give the same
+messages to within a few ulp.
+*/
+
+
+#ifndef INFORMATION_THEORY_LANE_MATH_H
+#define INFORMATION_THEORY_LANE_MATH_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+
+// coefficients 1/(k+1)! of expm1(r) = r * sum_k r^k/(k+1)!, |r| <= ln(2)/2
+static const double expm1_coeffs[12] = {
+        1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320,
+        1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600};
+
+// coefficients 1/(2k+1) of log(m) = 2s * sum_k s^(2k)/(2k+1), s = (m-1)/(m+1)
+static const double log_coeffs[12] = {
+        1.0, 1.0 / 3, 1.0 / 5, 1.0 / 7, 1.0 / 9, 1.0 / 11, 1.0 / 13, 1.0 / 15,
+        1.0 / 17, 1.0 / 19, 1.0 / 21, 1.0 / 23};
+
+static const double ln2_hi = 6.93147180369123816490e-01;
+static const double ln2_lo = 1.90821492927058770002e-10;
+static const double log2_e = 1.44269504088896338700e+00;
+
+
+/**
+ * @brief expm1 of non-positive values, lane by lane; the vectors are passed by
+ * reference, by value they would need the ABI of the wider instruction sets
+ * @tparam D vector of doubles
+ * @tparam I vector of int64_t of the same width
+ * @param x the values
+ * @param result output, expm1 of every lane
+ */
+template<typename D, typename I>
+static inline __attribute__((always_inline)) void lanes_expm1_neg(const D &x, D &result) {
+    const D y = x < -700. ? D{} - 700. : x;
+    // round y / ln(2) to the nearest integer n, kept in the low mantissa bits of shifted
+    const D magic = D{} + 6755399441055744.0;  // 1.5 * 2^52
+    const D shifted = y * log2_e + magic;
+    const D n = shifted - magic;
+    D r = y - n * ln2_hi;
+    r = r - n * ln2_lo;
+
+    D q = D{} + expm1_coeffs[11];
+    for (int k = 10; k >= 0; --k) {
+        q = q * r + expm1_coeffs[k];
+    }
+    const D p = q * r;
+
+    // 2^n through the exponent bits, n is integral and within the normal range here
+    const I n_int = reinterpret_cast<I>(shifted) - reinterpret_cast<I>(magic);
+    const D two_n = reinterpret_cast<D>((n_int + 1023) << 52);
+
+    // expm1(y) = 2^n * expm1(r) + (2^n - 1), exact in r when n == 0
+    result = two_n * p + (two_n - 1.);
+}
+
+
+/**
+ * @brief tanh(x/2), lane by lane
+ * @tparam D vector of doubles
+ * @tparam I vector of int64_t of the same width
+ * @param x the values
+ * @param result output, tanh(x/2) of every lane
+ */
+template<typename D, typename I>
+static inline __attribute__((always_inline)) void lanes_tanh_half(const D &x, D &result) {
+    const I sign_bit = I{} + INT64_MIN;
+    const I x_bits = reinterpret_cast<I>(x);
+    D em;
+    lanes_expm1_neg<D, I>(reinterpret_cast<D>(x_bits | sign_bit), em);  // expm1(-|x|)
+    const D t = -em / (2. + em);
+    result = reinterpret_cast<D>(reinterpret_cast<I>(t) | (x_bits & sign_bit));
+}
+
+
+/**
+ * @brief natural log, lane by lane, with log(0) = -inf, log(inf) = inf, log(<0) = NaN
+ * @tparam D vector of doubles
+ * @tparam I vector of int64_t of the same width
+ * @param x the values
+ * @param result output, log of every lane
+ */
+template<typename D, typename I>
+static inline __attribute__((always_inline)) void lanes_log(const D &x, D &result) {
+    const I bits = reinterpret_cast<I>(x);
+    D m = reinterpret_cast<D>((bits & INT64_C(0x000FFFFFFFFFFFFF)) | INT64_C(0x3FF0000000000000));
+
+    // exponent field to double, positive inputs only
+    const D two_52 = D{} + 4503599627370496.0;
+    D e = reinterpret_cast<D>(((bits >> 52) & 0x7FF) | reinterpret_cast<I>(two_52))
+          - (4503599627370496.0 + 1023.);
+
+    // move m into [sqrt(1/2), sqrt(2))
+    const I big = m > 1.4142135623730951;
+    m = big ? m * 0.5 : m;
+    e = big ? e + 1. : e;
+
+    const D s = (m - 1.) / (m + 1.);
+    const D s2 = s * s;
+    D q = D{} + log_coeffs[11];
+    for (int k = 10; k >= 0; --k) {
+        q = q * s2 + log_coeffs[k];
+    }
+    const D log_m = (s + s) * q;
+    D res = e * ln2_hi + (log_m + e * ln2_lo);
+
+    // special values
+    const D inf = D{} + HUGE_VAL;
+    res = x == inf ? inf : res;
+    res = x == 0. ? -inf : res;
+    result = x >= 0. ? res : D{} + NAN;
+}
+
+
+#endif //INFORMATION_THEORY_LANE_MATH_H
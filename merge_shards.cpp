@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Merges the shard files of a grid sweep run with grid_sweep --shard i/N into the CSV
+file a single grid_sweep run of the same config writes: the stopping rule is
+replayed over the chunks of all shards in order, only the seconds column differs
+(it sums the time of all shards).
+
+    grid_sweep --shard 0/2 grid_sweep.cfg    (on one machine)
+    grid_sweep --shard 1/2 grid_sweep.cfg    (on another)
+    merge_shards grid_sweep.cfg results/grid.csv.shard0 results/grid.csv.shard1
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "grid_config.h"
+
+using namespace std;
+
+
+int main(int argc, char **argv) {
+    const string usage = string("usage: ") + argv[0] + " [--output <csv>] <config> <shard file>...";
+    string config_path;
+    string output;
+    vector<string> shard_paths;
+    try {
+        for (int a = 1; a < argc; ++a) {
+            const string arg = argv[a];
+            if (arg == "--output") {
+                if (a + 1 >= argc) {
+                    throw runtime_error(arg + " needs a value.");
+                }
+                output = argv[++a];
+            } else if (arg.compare(0, 2, "--") == 0) {
+                throw runtime_error("unexpected argument " + arg);
+            } else if (config_path.empty()) {
+                config_path = arg;
+            } else {
+                shard_paths.push_back(arg);
+            }
+        }
+        if (config_path.empty() || shard_paths.empty()) {
+            throw runtime_error("no config or no shard files given.");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl << usage << endl;
+        return 2;
+    }
+
+    try {
+        GridConfig config = read_grid_config(config_path);
+        if (!output.empty()) {
+            config.output = output;
+        }
+        const vector<SweepPointResult> results = merge_grid_shards(config, shard_paths);
+        const vector<GridPoint> points = grid_points(config);
+        if (config.output.empty()) {
+            write_grid_results(cout, config, points, results);
+        } else {
+            ofstream out(config.output);
+            write_grid_results(out, config, points, results);
+            if (!out) {
+                throw runtime_error("can't write " + config.output + ".");
+            }
+        }
+        cerr << "merged " << shard_paths.size() << " shards, " << points.size() << " grid points" << endl;
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
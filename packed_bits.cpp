@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Bit-packed frames and the word-level syndrome encoder.
+*/
+
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "packed_bits.h"
+
+using namespace std;
+
+
+/**
+ * @brief allocates an all zero packed frame
+ * @param n_bits number of bits in the frame
+ * @return the frame
+ */
+PackedFrame make_packed_frame(const size_t n_bits) {
+    PackedFrame frame;
+    frame.n_bits = n_bits;
+    frame.words.assign(packed_words(n_bits), 0);
+    return frame;
+}
+
+
+/**
+ * @brief packs a vector<bool> into an existing frame, resized as needed
+ * @param in the bits to pack
+ * @param out output, the packed frame
+ */
+void pack_bits(const vector<bool> &in, PackedFrame &out) {
+    out.n_bits = in.size();
+    out.words.assign(packed_words(in.size()), 0);
+    for (size_t i = 0; i < in.size(); i++) {
+        out.words[i / packed_word_bits] |= uint64_t(in[i]) << (i % packed_word_bits);
+    }
+}
+
+
+/**
+ * @brief packs a vector<bool> into a new frame
+ * @param in the bits to pack
+ * @return the packed frame
+ */
+PackedFrame pack_bits(const vector<bool> &in) {
+    PackedFrame out;
+    pack_bits(in, out);
+    return out;
+}
+
+
+/**
+ * @brief unpacks a frame into a vector<bool>, resized as needed
+ * @param in the packed frame
+ * @param out output, one entry per bit
+ */
+void unpack_bits(const PackedFrame &in, vector<bool> &out) {
+    out.resize(in.n_bits);
+    for (size_t i = 0; i < in.n_bits; i++) {
+        out[i] = in.get(i);
+    }
+}
+
+
+/**
+ * @brief builds the packed row-major form of H from its check node adjacency
+ * @param n_cols number of columns of H
+ * @param n_rows number of rows of H
+ * @param check_offsets n_rows + 1 entries, first entry of each row in check_vars
+ * @param check_vars column of each nonzero entry, row by row
+ * @return the packed parity check matrix
+ */
+PackedParityCheck build_packed_parity_check(const int n_cols,
+                                            const int n_rows,
+                                            const CodeArray<uint32_t> &check_offsets,
+                                            const CodeArray<uint32_t> &check_vars) {
+    if (check_offsets.size() != static_cast<size_t>(n_rows) + 1) {
+        throw runtime_error("check offsets don't match the number of rows.");
+    }
+
+    // merge the columns of every row word by word
+    vector<vector<pair<uint32_t, uint64_t>>> rows(n_rows);
+    vector<uint32_t> cols;
+    for (int row = 0; row < n_rows; row++) {
+        cols.assign(check_vars.begin() + check_offsets[row], check_vars.begin() + check_offsets[row + 1]);
+        sort(cols.begin(), cols.end());
+        for (const uint32_t col : cols) {
+            if (col >= static_cast<uint32_t>(n_cols)) {
+                throw runtime_error("column index out of range.");
+            }
+            const uint32_t word = col / packed_word_bits;
+            const uint64_t bit = uint64_t(1) << (col % packed_word_bits);
+            if (!rows[row].empty() && rows[row].back().first == word) {
+                rows[row].back().second ^= bit;  // a doubled entry cancels out, like in encode()
+            } else {
+                rows[row].emplace_back(word, bit);
+            }
+        }
+    }
+
+    PackedParityCheck h;
+    h.n_cols = n_cols;
+    h.n_rows = n_rows;
+    for (const auto &terms : rows) {
+        h.row_terms = max(h.row_terms, static_cast<uint32_t>(terms.size()));
+    }
+    vector<uint32_t> word_index(static_cast<size_t>(n_rows) * h.row_terms, 0);
+    vector<uint64_t> word_mask(static_cast<size_t>(n_rows) * h.row_terms, 0);
+    for (int row = 0; row < n_rows; row++) {
+        for (size_t t = 0; t < rows[row].size(); t++) {
+            word_index[row * h.row_terms + t] = rows[row][t].first;
+            word_mask[row * h.row_terms + t] = rows[row][t].second;
+        }
+    }
+    h.word_index = std::move(word_index);
+    h.word_mask = std::move(word_mask);
+
+    h.row_offsets = check_offsets;
+    h.row_cols = check_vars;
+    return h;
+}
+
+
+/**
+ * @brief transposes a 64x64 bit matrix in place, bit j of a[i] swaps with bit i of a[j]
+ * @param a the 64 rows of the matrix
+ */
+static void transpose64(uint64_t *a) {
+    uint64_t m = 0x00000000FFFFFFFFULL;
+    for (unsigned j = 32; j != 0; j >>= 1, m ^= m << j) {
+        for (unsigned k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            const uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+
+/**
+ * @brief calculates the syndrome H*in of a packed frame
+ * @param h packed parity check matrix
+ * @param in input frame with h.n_cols bits
+ * @param out output syndrome, resized to h.n_rows bits
+ */
+void packed_syndrome(const PackedParityCheck &h, const PackedFrame &in, PackedFrame &out) {
+    if (in.n_bits != static_cast<size_t>(h.n_cols) || in.words.size() != packed_words(in.n_bits)) {
+        throw runtime_error("input doesn't match H.");
+    }
+    out.n_bits = h.n_rows;
+    out.words.resize(packed_words(h.n_rows));
+
+    const uint64_t *x = in.words.data();
+    const uint32_t *word_index = h.word_index.data();
+    const uint64_t *word_mask = h.word_mask.data();
+    const uint32_t row_terms = h.row_terms;
+
+    // 64 check nodes make up one output word
+    for (size_t w = 0; w < out.words.size(); w++) {
+        const size_t row_begin = w * packed_word_bits;
+        const size_t row_end = min(row_begin + packed_word_bits, static_cast<size_t>(h.n_rows));
+        uint64_t syndrome_word = 0;
+        for (size_t row = row_begin; row < row_end; row++) {
+            uint64_t acc = 0;
+            for (uint32_t t = 0; t < row_terms; t++) {
+                acc ^= x[word_index[row * row_terms + t]] & word_mask[row * row_terms + t];
+            }
+            syndrome_word |= uint64_t(__builtin_parityll(acc)) << (row - row_begin);
+        }
+        out.words[w] = syndrome_word;
+    }
+}
+
+
+/**
+ * @brief calculates the syndromes of many packed frames at once
+ * @param h packed parity check matrix
+ * @param in input frames with h.n_cols bits each
+ * @param out output syndromes, resized to in.size() frames of h.n_rows bits
+ */
+void packed_syndrome(const PackedParityCheck &h, const vector<PackedFrame> &in, vector<PackedFrame> &out) {
+    const size_t in_words = packed_words(h.n_cols);
+    const size_t out_words = packed_words(h.n_rows);
+    for (const auto &frame : in) {
+        if (frame.n_bits != static_cast<size_t>(h.n_cols) || frame.words.size() != in_words) {
+            throw runtime_error("input doesn't match H.");
+        }
+    }
+    out.resize(in.size());
+    for (auto &frame : out) {
+        frame.n_bits = h.n_rows;
+        frame.words.resize(out_words);
+    }
+
+    // column c of all frames of a block lives in sliced_cols[c], bit f belongs to frame f
+    vector<uint64_t> sliced_cols(in_words * packed_word_bits);
+    vector<uint64_t> sliced_rows(out_words * packed_word_bits);  // padding rows stay zero
+    uint64_t block[packed_word_bits];
+
+    for (size_t first = 0; first < in.size(); first += packed_word_bits) {
+        const size_t n_frames = min(packed_word_bits, in.size() - first);
+
+        for (size_t w = 0; w < in_words; w++) {
+            for (size_t f = 0; f < packed_word_bits; f++) {
+                block[f] = f < n_frames ? in[first + f].words[w] : 0;
+            }
+            transpose64(block);
+            copy(block, block + packed_word_bits, sliced_cols.begin() + w * packed_word_bits);
+        }
+
+        for (size_t row = 0; row < static_cast<size_t>(h.n_rows); row++) {
+            uint64_t acc = 0;
+            for (uint32_t t = h.row_offsets[row]; t < h.row_offsets[row + 1]; t++) {
+                acc ^= sliced_cols[h.row_cols[t]];
+            }
+            sliced_rows[row] = acc;
+        }
+
+        for (size_t w = 0; w < out_words; w++) {
+            copy(sliced_rows.begin() + w * packed_word_bits, sliced_rows.begin() + (w + 1) * packed_word_bits, block);
+            transpose64(block);
+            for (size_t f = 0; f < n_frames; f++) {
+                out[first + f].words[w] = block[f];
+            }
+        }
+    }
+}
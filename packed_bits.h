@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Bit-packed frames (64 bits per uint64_t word) and a syndrome encoder working on
+them with word-level AND/XOR and a parity per check node.
+*/
+
+
+#ifndef INFORMATION_THEORY_PACKED_BITS_H
+#define INFORMATION_THEORY_PACKED_BITS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "code_array.h"
+
+using namespace std;
+
+
+// number of bits in a packed word
+const size_t packed_word_bits = 64;
+
+
+/**
+ * @brief number of words needed to hold the given number of bits
+ */
+inline size_t packed_words(const size_t n_bits) {
+    return (n_bits + packed_word_bits - 1) / packed_word_bits;
+}
+
+
+/**
+ * @brief a frame of bits packed into 64-bit words
+ *
+ * Bit i lives in bit i % 64 of words[i / 64], the unused high bits of the last word
+ * are kept at zero.
+ */
+struct PackedFrame {
+    size_t n_bits{};
+    vector<uint64_t> words;
+
+    bool get(const size_t i) const { return (words[i / packed_word_bits] >> (i % packed_word_bits)) & 1; }
+
+    void set(const size_t i, const bool bit) {
+        const uint64_t mask = uint64_t(1) << (i % packed_word_bits);
+        if (bit) { words[i / packed_word_bits] |= mask; }
+        else { words[i / packed_word_bits] &= ~mask; }
+    }
+
+    void flip(const size_t i) { words[i / packed_word_bits] ^= uint64_t(1) << (i % packed_word_bits); }
+};
+
+
+/**
+ * @brief parity check matrix H in packed row-major form, precomputed once per code
+ *
+ * Every row is stored as a list of (word, mask) terms: the columns of the row that
+ * fall into the same 64-bit word of the input are merged into one mask, so a check
+ * node costs one AND and one XOR per word it touches. All rows are padded with empty
+ * terms to the same length, the fixed trip count keeps the branch predictor happy.
+ * The plain row lists are kept as well for the batch encoder, which works on 64
+ * frames transposed into one word per column.
+ */
+struct PackedParityCheck {
+    int n_cols{};
+    int n_rows{};
+    uint32_t row_terms{};          // terms per row, including padding
+    CodeArray<uint32_t> word_index;   // input word read by each term, row by row
+    CodeArray<uint64_t> word_mask;    // columns of the row inside that word, 0 for padding
+    CodeArray<uint32_t> row_offsets;  // n_rows + 1 entries, first entry of each row in row_cols
+    CodeArray<uint32_t> row_cols;     // columns of each row, used by the bit-sliced batch encoder
+};
+
+
+/**
+ * @brief allocates an all zero packed frame
+ * @param n_bits number of bits in the frame
+ * @return the frame
+ */
+PackedFrame make_packed_frame(size_t n_bits);
+
+
+/**
+ * @brief packs a vector<bool> into an existing frame, resized as needed
+ * @param in the bits to pack
+ * @param out output, the packed frame
+ */
+void pack_bits(const vector<bool> &in, PackedFrame &out);
+
+
+/**
+ * @brief packs a vector<bool> into a new frame
+ * @param in the bits to pack
+ * @return the packed frame
+ */
+PackedFrame pack_bits(const vector<bool> &in);
+
+
+/**
+ * @brief unpacks a frame into a vector<bool>, resized as needed
+ * @param in the packed frame
+ * @param out output, one entry per bit
+ */
+void unpack_bits(const PackedFrame &in, vector<bool> &out);
+
+
+/**
+ * @brief builds the packed row-major form of H from its check node adjacency
+ * @param n_cols number of columns of H
+ * @param n_rows number of rows of H
+ * @param check_offsets n_rows + 1 entries, first entry of each row in check_vars
+ * @param check_vars column of each nonzero entry, row by row
+ * @return the packed parity check matrix
+ */
+PackedParityCheck build_packed_parity_check(int n_cols,
+                                            int n_rows,
+                                            const CodeArray<uint32_t> &check_offsets,
+                                            const CodeArray<uint32_t> &check_vars);
+
+
+/**
+ * @brief calculates the syndrome H*in of a packed frame
+ * @param h packed parity check matrix
+ * @param in input frame with h.n_cols bits
+ * @param out output syndrome, resized to h.n_rows bits
+ */
+void packed_syndrome(const PackedParityCheck &h, const PackedFrame &in, PackedFrame &out);
+
+
+/**
+ * @brief calculates the syndromes of many packed frames at once
+ *
+ * Blocks of 64 frames are transposed so that one word holds the same column of every
+ * frame, then every check node is a plain XOR of its column words and the result is
+ * transposed back. Per frame this is several times faster than packed_syndrome,
+ * which makes it the entry point for long streams of frames.
+ * @param h packed parity check matrix
+ * @param in input frames with h.n_cols bits each
+ * @param out output syndromes, resized to in.size() frames of h.n_rows bits
+ */
+void packed_syndrome(const PackedParityCheck &h, const vector<PackedFrame> &in, vector<PackedFrame> &out);
+
+#endif //INFORMATION_THEORY_PACKED_BITS_H
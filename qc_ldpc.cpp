@@ -0,0 +1,683 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Quasi-cyclic LDPC codes: construction from a base matrix, expansion, syndrome
+calculation and a flooding decoder working on whole circulants. A circulant with
+shift s links check row r to variable (r + s) % lifting, so its messages in check
+row order are the variable side rotated by s. The variable node update adds each
+run into the posteriors as two contiguous segments and writes the extrinsic
+messages back the same way. The min-sum kernels are written once with GCC vector
+extensions, templated on the lane count, and inlined into one wrapper each for
+AVX-512, AVX2 and SSE2; the sum-product rule keeps the scalar arithmetic of
+check_node_update, in contiguous loops over each circulant. As in the other
+decoders, the hard decision keeps the unsatisfied checks up to date as decisions
+change, so the stopping test costs work only for the changed bits.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include "qc_ldpc.h"
+#include "simd_kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define QC_LDPC_X86
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx2,avx512f")))
+#endif
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+using namespace std;
+
+
+/**
+ * @brief vector types holding W consecutive messages of a circulant, W is the native
+ * width of the instruction set the kernels are inlined into
+ * @tparam T message type (float or double)
+ */
+template<typename T, int W>
+struct QcLanes {
+    typedef T d __attribute__((vector_size(sizeof(T) * W)));
+    typedef typename QcMask<T>::type i __attribute__((vector_size(sizeof(T) * W)));
+    // the same, but only element aligned so that any offset into a circulant can be accessed
+    typedef d d_mem __attribute__((aligned(sizeof(T))));
+    typedef i i_mem __attribute__((aligned(sizeof(T))));
+};
+
+#define LOAD_D(p) (*reinterpret_cast<const typename QcLanes<T, W>::d_mem *>(p))
+#define LOAD_I(p) (*reinterpret_cast<const typename QcLanes<T, W>::i_mem *>(p))
+#define STORE_D(p, v) (*reinterpret_cast<typename QcLanes<T, W>::d_mem *>(p) = (v))
+
+
+/**
+ * @brief clamps a block of messages to +/- vsat, same semantics as saturate()
+ */
+#define SATURATE_BLOCK(v, vsat) do { \
+        (v) = (v) > (vsat) ? (vsat) : (v); \
+        (v) = (v) < -(vsat) ? -(vsat) : (v); \
+    } while (false)
+
+
+/**
+ * @brief builds a QC code from its base matrix
+ * @param base_rows number of block rows
+ * @param base_cols number of block columns
+ * @param lifting size of the circulants
+ * @param shifts base_rows x base_cols shifts, row-major, -1 for a zero block
+ * @return the code
+ */
+QcLdpcCode make_qc_ldpc_code(int base_rows, int base_cols, int lifting, vector<int32_t> shifts) {
+    if (base_rows <= 0 || base_cols <= 0 || lifting <= 0) {
+        throw runtime_error("QC base matrix and lifting size must be positive.");
+    }
+    if (static_cast<int64_t>(base_cols) * lifting > numeric_limits<int32_t>::max() ||
+        static_cast<int64_t>(base_rows) * lifting > numeric_limits<int32_t>::max()) {
+        throw runtime_error("lifted QC code is too large.");
+    }
+    if (shifts.size() != static_cast<size_t>(base_rows) * base_cols) {
+        throw runtime_error("shifts don't match the QC base matrix.");
+    }
+    for (const int32_t s : shifts) {
+        if (s < -1 || s >= lifting) {
+            throw runtime_error("QC shift out of range, expected -1 or 0 to lifting - 1.");
+        }
+    }
+
+    QcLdpcCode code;
+    code.base_rows = base_rows;
+    code.base_cols = base_cols;
+    code.lifting = lifting;
+    code.shifts = std::move(shifts);
+
+    // nonzero blocks row by row, then the blocks of each column by counting
+    code.row_offsets.assign(base_rows + 1, 0);
+    code.col_offsets.assign(base_cols + 1, 0);
+    for (int i = 0; i < base_rows; ++i) {
+        for (int j = 0; j < base_cols; ++j) {
+            const int32_t s = code.shifts[static_cast<size_t>(i) * base_cols + j];
+            if (s >= 0) {
+                code.block_rows.push_back(i);
+                code.block_cols.push_back(j);
+                code.block_shifts.push_back(s);
+                ++code.col_offsets[j + 1];
+            }
+        }
+        code.row_offsets[i + 1] = code.block_cols.size();
+    }
+    for (int j = 0; j < base_cols; ++j) {
+        code.col_offsets[j + 1] += code.col_offsets[j];
+    }
+    code.col_blocks.resize(code.n_blocks());
+    vector<uint32_t> fill_pos(code.col_offsets.begin(), code.col_offsets.end() - 1);
+    for (uint32_t b = 0; b < code.n_blocks(); ++b) {
+        code.col_blocks[fill_pos[code.block_cols[b]]++] = b;
+    }
+    return code;
+}
+
+
+/**
+ * @brief reads a base matrix file: "base_rows base_cols lifting" followed by the
+ * shifts row by row, -1 for a zero block
+ * @param path the file
+ * @return the code
+ */
+QcLdpcCode read_qc_base_matrix(const string &path) {
+    ifstream in(path);
+    if (!in) {
+        throw runtime_error("can't open " + path + ".");
+    }
+    int base_rows, base_cols, lifting;
+    if (!(in >> base_rows >> base_cols >> lifting) || base_rows <= 0 || base_cols <= 0) {
+        throw runtime_error("invalid header in QC base matrix file " + path + ".");
+    }
+    vector<int32_t> shifts(static_cast<size_t>(base_rows) * base_cols);
+    for (auto &s : shifts) {
+        if (!(in >> s)) {
+            throw runtime_error("QC base matrix file " + path + " ends early.");
+        }
+    }
+    string rest;
+    if (in >> rest) {
+        throw runtime_error("unexpected data after the QC base matrix in " + path + ".");
+    }
+    return make_qc_ldpc_code(base_rows, base_cols, lifting, std::move(shifts));
+}
+
+
+/**
+ * @brief expands a QC code into the explicit sparse form used by the other decoders
+ * @param code the QC code
+ * @return the expanded code
+ */
+LdpcCode expand_qc_code(const QcLdpcCode &code) {
+    const uint32_t Z = code.lifting;
+    vector<uint32_t> column_pointers(code.n_cols() + 1, 0);
+    vector<uint32_t> row_index;
+    row_index.reserve(code.n_blocks() * Z);
+
+    // variable c of a block is connected to check row (c - s) mod Z, base rows ascending
+    for (int j = 0; j < code.base_cols; ++j) {
+        for (uint32_t c = 0; c < Z; ++c) {
+            for (uint32_t k = code.col_offsets[j]; k < code.col_offsets[j + 1]; ++k) {
+                const uint32_t b = code.col_blocks[k];
+                const uint32_t i = upper_bound(code.row_offsets.begin(), code.row_offsets.end(), b)
+                                   - code.row_offsets.begin() - 1;
+                const uint32_t s = code.block_shifts[b];
+                row_index.push_back(i * Z + (c + Z - s) % Z);
+            }
+            column_pointers[j * Z + c + 1] = row_index.size();
+        }
+    }
+    return build_ldpc_code(code.n_cols(), code.n_rows(), std::move(column_pointers), row_index);
+}
+
+
+/**
+ * @brief calculates the syndrome of a word, circulant by circulant
+ * @param code the QC code
+ * @param in the word, n_cols bits
+ * @param out output syndrome, resized to n_rows bits
+ */
+void qc_encode(const QcLdpcCode &code, const vector<bool> &in, vector<bool> &out) {
+    if (in.size() != code.n_cols()) {
+        throw runtime_error("input doesn't match H.");
+    }
+    const size_t Z = code.lifting;
+    vector<uint8_t> bits(in.begin(), in.end());
+    vector<uint8_t> parity(Z);
+    out.resize(code.n_rows());
+
+    for (size_t i = 0; i < code.base_rows; ++i) {
+        fill(parity.begin(), parity.end(), 0);
+        for (uint32_t b = code.row_offsets[i]; b < code.row_offsets[i + 1]; ++b) {
+            // check r of the block sees variable r + s, the rotation is two contiguous segments
+            const uint8_t *x = &bits[code.block_cols[b] * Z];
+            const size_t s = code.block_shifts[b];
+            for (size_t r = 0; r < Z - s; ++r) {
+                parity[r] ^= x[r + s];
+            }
+            for (size_t r = Z - s; r < Z; ++r) {
+                parity[r] ^= x[r + s - Z];
+            }
+        }
+        for (size_t r = 0; r < Z; ++r) {
+            out[i * Z + r] = parity[r];
+        }
+    }
+}
+
+
+/**
+ * @brief allocates a QC decoder workspace
+ * @param code the QC code
+ * @return the workspace
+ */
+QcDecoderWorkspace make_qc_decoder_workspace(const QcLdpcCode &code) {
+    QcDecoderWorkspace ws;
+    ws.f64.resize(code);
+    ws.bits.resize(code.n_cols());
+    ws.flips.resize(code.lifting);
+    ws.unsatisfied.resize(code.n_rows());
+    ws.out.resize(code.n_cols());
+    return ws;
+}
+
+
+/**
+ * @brief min-sum update of W consecutive checks of one base row, including saturation
+ * @tparam T message type (float or double)
+ * @tparam W number of lanes
+ */
+template<typename T, int W>
+static ALWAYS_INLINE void qc_check_min_sum_lanes(const QcLdpcCode &code,
+                                                 QcMessageBuffers<T> &buffers,
+                                                 const size_t i,
+                                                 const size_t r0,
+                                                 const T scale,
+                                                 const T offset,
+                                                 const T vsat) {
+    typedef typename QcLanes<T, W>::d block_d;
+    typedef typename QcLanes<T, W>::i block_i;
+    const size_t Z = code.lifting;
+    const T *msg_v = buffers.msg_v.data();
+    T *msg_c = buffers.msg_c.data();
+    const uint32_t begin = code.row_offsets[i];
+    const uint32_t end = code.row_offsets[i + 1];
+    const block_i sign_bit = block_i{} + numeric_limits<typename QcMask<T>::type>::min();
+    const block_d inf = block_d{} + numeric_limits<T>::infinity();
+    const block_d zero = block_d{};
+    const block_d sat = block_d{} + vsat;
+    alignas(64) T min1[W], min2[W], out1[W], out2[W];
+
+    // per check two smallest magnitudes and sign parity
+    block_d vmin1 = inf;
+    block_d vmin2 = inf;
+    block_i parity = LOAD_I(&buffers.syndrome[i * Z + r0]);
+    for (uint32_t b = begin; b < end; ++b) {
+        const block_d x = LOAD_D(msg_v + b * Z + r0);
+        const block_d mag = reinterpret_cast<block_d>(reinterpret_cast<block_i>(x) & ~sign_bit);
+        parity ^= x < zero;
+        const block_d upper = vmin1 > mag ? vmin1 : mag;
+        vmin2 = upper < vmin2 ? upper : vmin2;
+        vmin1 = mag < vmin1 ? mag : vmin1;
+    }
+
+    *reinterpret_cast<block_d *>(min1) = vmin1;
+    *reinterpret_cast<block_d *>(min2) = vmin2;
+    for (int l = 0; l < W; ++l) {
+        out1[l] = min_sum_magnitude(min1[l], scale, offset);
+        out2[l] = min_sum_magnitude(min2[l], scale, offset);
+    }
+    const block_d vout1 = *reinterpret_cast<const block_d *>(out1);
+    const block_d vout2 = *reinterpret_cast<const block_d *>(out2);
+
+    for (uint32_t b = begin; b < end; ++b) {
+        const block_d x = LOAD_D(msg_v + b * Z + r0);
+        const block_d mag = reinterpret_cast<block_d>(reinterpret_cast<block_i>(x) & ~sign_bit);
+        const block_d sel = mag == vmin1 ? vout2 : vout1;
+        block_d res = ((x < zero) ^ parity) ? -sel : sel;
+        SATURATE_BLOCK(res, sat);
+        STORE_D(msg_c + b * Z + r0, res);
+    }
+}
+
+
+/**
+ * @brief min-sum update of the checks of one base row, W at a time
+ * @tparam T message type (float or double)
+ * @tparam W number of lanes
+ */
+template<typename T, int W>
+static ALWAYS_INLINE void qc_check_min_sum(const QcLdpcCode &code,
+                                           QcMessageBuffers<T> &buffers,
+                                           const size_t i,
+                                           const T scale,
+                                           const T offset,
+                                           const T vsat) {
+    const size_t Z = code.lifting;
+    size_t r0 = 0;
+    for (; r0 + W <= Z; r0 += W) {
+        qc_check_min_sum_lanes<T, W>(code, buffers, i, r0, scale, offset, vsat);
+    }
+    for (; r0 < Z; ++r0) {
+        qc_check_min_sum_lanes<T, 1>(code, buffers, i, r0, scale, offset, vsat);
+    }
+}
+
+
+/**
+ * @brief sum-product update of the checks of one base row with the arithmetic of
+ * check_node_update, including saturation
+ * @tparam T message type (float or double)
+ */
+template<typename T>
+static ALWAYS_INLINE void qc_check_sum_product(const QcLdpcCode &code,
+                                               QcMessageBuffers<T> &buffers,
+                                               const size_t i,
+                                               const T vsat) {
+    const size_t Z = code.lifting;
+    const T *msg_v = buffers.msg_v.data();
+    T *msg_c = buffers.msg_c.data();
+    T *prod = buffers.scratch.data();
+    const uint32_t begin = code.row_offsets[i];
+    const uint32_t end = code.row_offsets[i + 1];
+
+    // product of incoming messages, the tanh values are kept in msg_c until the division
+    for (size_t r = 0; r < Z; ++r) {
+        prod[r] = buffers.syndrome[i * Z + r] ? T(-1) : T(1);
+    }
+    for (uint32_t b = begin; b < end; ++b) {
+        for (size_t r = 0; r < Z; ++r) {
+            const T t = std::tanh(T(0.5) * msg_v[b * Z + r]);
+            msg_c[b * Z + r] = t;
+            prod[r] *= t;
+        }
+    }
+
+    for (uint32_t b = begin; b < end; ++b) {
+        for (size_t r = 0; r < Z; ++r) {
+            const T x = msg_v[b * Z + r];
+            const T msg_part = x == 0 ? (end - begin > 1 ? T(0) : T(1)) : prod[r] / msg_c[b * Z + r];
+            T res = std::log((1 + msg_part) / (1 - msg_part));
+            if (res > vsat) { res = vsat; }
+            else if (res < -vsat) { res = -vsat; }
+            msg_c[b * Z + r] = res;
+        }
+    }
+}
+
+
+/**
+ * @brief adds a contiguous run of messages to the posteriors
+ * @tparam T message type (float or double)
+ * @tparam W number of lanes
+ */
+template<typename T, int W>
+static ALWAYS_INLINE void qc_add_run(T *sum, const T *msg, const size_t n) {
+    size_t k = 0;
+    for (; k + W <= n; k += W) {
+        STORE_D(sum + k, LOAD_D(sum + k) + LOAD_D(msg + k));
+    }
+    for (; k < n; ++k) {
+        sum[k] += msg[k];
+    }
+}
+
+
+/**
+ * @brief writes the saturated extrinsic messages of a contiguous run
+ * @tparam T message type (float or double)
+ * @tparam W number of lanes
+ * @return true if a message is NaN
+ */
+template<typename T, int W>
+static ALWAYS_INLINE bool qc_extrinsic_run(T *msg_v, const T *sum, const T *msg_c, const size_t n,
+                                           const T vsat) {
+    typedef typename QcLanes<T, W>::d block_d;
+    typedef typename QcLanes<T, W>::i block_i;
+    const block_d sat = block_d{} + vsat;
+    block_i nan = block_i{};
+    size_t k = 0;
+    for (; k + W <= n; k += W) {
+        block_d res = LOAD_D(sum + k) - LOAD_D(msg_c + k);
+        SATURATE_BLOCK(res, sat);
+        nan |= res != res;
+        STORE_D(msg_v + k, res);
+    }
+    bool diverged = false;
+    for (int l = 0; l < W; ++l) {
+        diverged |= nan[l] != 0;
+    }
+    for (; k < n; ++k) {
+        T res = sum[k] - msg_c[k];
+        if (res > vsat) { res = vsat; }
+        else if (res < -vsat) { res = -vsat; }
+        diverged |= res != res;
+        msg_v[k] = res;
+    }
+    return diverged;
+}
+
+
+/**
+ * @brief flips the parity of n consecutive checks where flips is set
+ */
+static ALWAYS_INLINE void qc_flip_run(uint8_t *unsatisfied, const uint8_t *flips, const size_t n) {
+    for (size_t r = 0; r < n; ++r) {
+        unsatisfied[r] ^= flips[r];
+    }
+}
+
+
+/**
+ * @brief whether any check is unsatisfied, in one OR over the tracked parities
+ */
+static ALWAYS_INLINE bool qc_any_unsatisfied(const QcDecoderWorkspace &ws) {
+    uint8_t any = 0;
+    for (const uint8_t u : ws.unsatisfied) {
+        any |= u;
+    }
+    return any != 0;
+}
+
+
+/**
+ * @brief variable node update and hard decision of one base column, including
+ * saturation, the checks of every changed decision flip their parity
+ * @tparam T message type (float or double)
+ * @tparam W number of lanes
+ * @return true if a variable message is NaN
+ */
+template<typename T, int W>
+static ALWAYS_INLINE bool qc_var_node(const QcLdpcCode &code,
+                                      QcMessageBuffers<T> &buffers,
+                                      QcDecoderWorkspace &ws,
+                                      const size_t j,
+                                      const T vsat) {
+    const size_t Z = code.lifting;
+    T *msg_v = buffers.msg_v.data();
+    const T *msg_c = buffers.msg_c.data();
+    T *sum = buffers.scratch.data();
+
+    // same summation order as var_node_update: the LLR, then the blocks by base row
+    copy_n(&buffers.llrs[j * Z], Z, sum);
+    for (uint32_t k = code.col_offsets[j]; k < code.col_offsets[j + 1]; ++k) {
+        const uint32_t b = code.col_blocks[k];
+        const size_t s = code.block_shifts[b];
+        qc_add_run<T, W>(sum + s, msg_c + b * Z, Z - s);
+        qc_add_run<T, W>(sum, msg_c + b * Z + Z - s, s);
+    }
+    // hard decision, the parities only need an update in columns where it changed
+    uint8_t *bits = &ws.bits[j * Z];
+    uint8_t *flips = ws.flips.data();
+    uint8_t any_flip = 0;
+    for (size_t c = 0; c < Z; ++c) {
+        const uint8_t bit = sum[c] < 0;
+        flips[c] = bit ^ bits[c];
+        bits[c] = bit;
+        any_flip |= flips[c];
+    }
+    if (any_flip) {
+        // variable c of a block with shift s is in check row (c - s) mod Z of its base row
+        for (uint32_t k = code.col_offsets[j]; k < code.col_offsets[j + 1]; ++k) {
+            const uint32_t b = code.col_blocks[k];
+            const size_t s = code.block_shifts[b];
+            uint8_t *unsatisfied = &ws.unsatisfied[code.block_rows[b] * Z];
+            qc_flip_run(unsatisfied, flips + s, Z - s);
+            qc_flip_run(unsatisfied + Z - s, flips, s);
+        }
+    }
+
+    bool diverged = false;
+    for (uint32_t k = code.col_offsets[j]; k < code.col_offsets[j + 1]; ++k) {
+        const uint32_t b = code.col_blocks[k];
+        const size_t s = code.block_shifts[b];
+        diverged |= qc_extrinsic_run<T, W>(msg_v + b * Z, sum + s, msg_c + b * Z, Z - s, vsat);
+        diverged |= qc_extrinsic_run<T, W>(msg_v + b * Z + Z - s, sum, msg_c + b * Z + Z - s, s, vsat);
+    }
+    return diverged;
+}
+
+
+/**
+ * @brief the decoding iterations, inlined into one wrapper per instruction set
+ * @tparam T message type (float or double)
+ * @tparam W number of lanes of the native vector width
+ * @return true if the decoded word matches the syndrome
+ */
+template<typename T, int W>
+static ALWAYS_INLINE bool qc_iterations(const QcLdpcCode &code,
+                                        QcMessageBuffers<T> &buffers,
+                                        QcDecoderWorkspace &ws,
+                                        const DecoderConfig &config) {
+    double ms_scale, ms_offset;
+    min_sum_parameters(config, ms_scale, ms_offset);
+    const T vsat = static_cast<T>(config.vsat);
+
+    for (size_t it{}; it < config.max_num_iter; ++it) {
+        for (size_t i = 0; i < code.base_rows; ++i) {
+            if (config.rule == CheckNodeRule::sum_product) {
+                qc_check_sum_product<T>(code, buffers, i, vsat);
+            } else {
+                qc_check_min_sum<T, W>(code, buffers, i, T(ms_scale), T(ms_offset), vsat);
+            }
+        }
+
+        bool diverged = false;
+        for (size_t j = 0; j < code.base_cols; ++j) {
+            diverged |= qc_var_node<T, W>(code, buffers, ws, j, vsat);
+        }
+
+        // terminate if the decision matches the syndrome, give up on a diverging decoder
+        if (!qc_any_unsatisfied(ws)) {
+            return true;
+        }
+        if (diverged) {
+            return false;
+        }
+    }
+
+    return false;  // Decoding was not successful.
+}
+
+
+#ifdef QC_LDPC_X86
+template<typename T>
+TARGET_AVX512 static bool qc_iterations_avx512(const QcLdpcCode &code, QcMessageBuffers<T> &buffers,
+                                               QcDecoderWorkspace &ws, const DecoderConfig &config) {
+    return qc_iterations<T, 64 / sizeof(T)>(code, buffers, ws, config);
+}
+
+
+template<typename T>
+TARGET_AVX2 static bool qc_iterations_avx2(const QcLdpcCode &code, QcMessageBuffers<T> &buffers,
+                                           QcDecoderWorkspace &ws, const DecoderConfig &config) {
+    return qc_iterations<T, 32 / sizeof(T)>(code, buffers, ws, config);
+}
+#endif
+
+
+template<typename T>
+static bool qc_iterations_scalar(const QcLdpcCode &code, QcMessageBuffers<T> &buffers,
+                                 QcDecoderWorkspace &ws, const DecoderConfig &config) {
+    return qc_iterations<T, 16 / sizeof(T)>(code, buffers, ws, config);
+}
+
+
+/**
+ * @brief message buffers of the workspace for one message type
+ */
+static QcMessageBuffers<double> &qc_message_buffers(QcDecoderWorkspace &ws, double) { return ws.f64; }
+
+static QcMessageBuffers<float> &qc_message_buffers(QcDecoderWorkspace &ws, float) { return ws.f32; }
+
+
+/**
+ * @brief the QC decoder for one message type
+ * @tparam T message type (float or double)
+ * @param code the QC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome the syndrome of the frame
+ * @param ws workspace for this code
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+template<typename T>
+static bool decode_qc_messages(const QcLdpcCode &code,
+                               const vector<double> &llrs,
+                               const vector<bool> &syndrome,
+                               QcDecoderWorkspace &ws,
+                               const DecoderConfig &config) {
+    const size_t Z = code.lifting;
+    QcMessageBuffers<T> &buffers = qc_message_buffers(ws, T());
+    buffers.resize(code);
+    for (size_t v = 0; v < llrs.size(); ++v) {
+        buffers.llrs[v] = static_cast<T>(llrs[v]);
+    }
+    for (size_t m = 0; m < syndrome.size(); ++m) {
+        buffers.syndrome[m] = syndrome[m] ? -1 : 0;
+        ws.unsatisfied[m] = syndrome[m];
+    }
+
+    // initialize msg_v with the LLRs, check r of a block sees variable r + s
+    for (uint32_t b = 0; b < code.n_blocks(); ++b) {
+        const T *llr = &buffers.llrs[code.block_cols[b] * Z];
+        const size_t s = code.block_shifts[b];
+        T *msg_v = &buffers.msg_v[b * Z];
+        copy(llr + s, llr + Z, msg_v);
+        copy(llr, llr + s, msg_v + Z - s);
+    }
+    fill(ws.bits.begin(), ws.bits.end(), 0);
+
+    bool success;
+    switch (resolve_simd_level(config.simd)) {
+#ifdef QC_LDPC_X86
+        case SimdLevel::avx512:
+            success = qc_iterations_avx512(code, buffers, ws, config);
+            break;
+        case SimdLevel::avx2:
+            success = qc_iterations_avx2(code, buffers, ws, config);
+            break;
+#endif
+        default:
+            success = qc_iterations_scalar(code, buffers, ws, config);
+            break;
+    }
+
+    copy(ws.bits.begin(), ws.bits.end(), ws.out.begin());
+    return success;
+}
+
+
+/**
+ * @brief decodes one frame on a QC code with the flooding schedule
+ *
+ * Gives the same decision as decode_at_current_rate with scalar kernels on the
+ * expanded code, for double and float messages and every check node rule.
+ * @param code the QC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome the syndrome of the frame
+ * @param ws workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_qc(const QcLdpcCode &code,
+               const vector<double> &llrs,
+               const vector<bool> &syndrome,
+               QcDecoderWorkspace &ws,
+               const DecoderConfig &config) {
+    if (llrs.size() != code.n_cols()) {
+        throw runtime_error("input doesn't match H.");
+    }
+    if (syndrome.size() != code.n_rows()) {
+        throw runtime_error("checksum doesn't match number of rows in H");
+    }
+    if (ws.bits.size() != code.n_cols() || ws.out.size() != code.n_cols() || ws.flips.size() != code.lifting
+        || ws.unsatisfied.size() != code.n_rows()) {
+        throw runtime_error("decoder workspace doesn't match H.");
+    }
+    if (config.schedule != Schedule::flooding) {
+        throw runtime_error("the QC decoder only supports the flooding schedule.");
+    }
+    if (config.warm_start) {
+        throw runtime_error("the QC decoder doesn't support warm starts.");
+    }
+
+    switch (config.message_type) {
+        case MessageType::fixed_point:
+            throw runtime_error("the QC decoder only supports double and float messages.");
+        case MessageType::float32:
+            return decode_qc_messages<float>(code, llrs, syndrome, ws, config);
+        case MessageType::float64:
+            break;
+    }
+    return decode_qc_messages<double>(code, llrs, syndrome, ws, config);
+}
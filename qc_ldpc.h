@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Quasi-cyclic LDPC codes. H is a base matrix of shift values, every entry stands
+for a lifting x lifting block that is either zero or a cyclically shifted identity
+(a circulant). Only the base matrix is stored, and the decoder keeps the messages
+of every circulant in one contiguous run of lifting values, so a check node update
+works on lifting checks at once with plain vector loads and the variable side is
+a rotation of those runs. No edge permutations are needed.
+*/
+
+
+#ifndef INFORMATION_THEORY_QC_LDPC_H
+#define INFORMATION_THEORY_QC_LDPC_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+/**
+ * @brief a quasi-cyclic LDPC code
+ *
+ * Block (i, j) with shift s >= 0 connects check i * lifting + r with variable
+ * j * lifting + (r + s) % lifting, a shift of -1 is an all-zero block. The nonzero
+ * blocks are listed row by row (columns ascending), which is also the order of
+ * their message runs in the decoder.
+ */
+struct QcLdpcCode {
+    int base_rows{};
+    int base_cols{};
+    int lifting{};                     // size of the circulants
+    vector<int32_t> shifts;            // base_rows x base_cols, row-major, -1 for a zero block
+    vector<uint32_t> row_offsets;      // base_rows + 1 entries, first block of each base row
+    vector<uint32_t> block_rows;       // base row of each block
+    vector<uint32_t> block_cols;       // base column of each block
+    vector<uint32_t> block_shifts;     // shift of each block
+    vector<uint32_t> col_offsets;      // base_cols + 1 entries, first entry of each base column in col_blocks
+    vector<uint32_t> col_blocks;       // blocks of each base column, base rows ascending
+
+    int n_cols() const { return base_cols * lifting; }
+    int n_rows() const { return base_rows * lifting; }
+    size_t n_blocks() const { return block_cols.size(); }
+};
+
+
+/**
+ * @brief integer type with the width of a message type, for the lane masks of the kernels
+ */
+template<typename T>
+struct QcMask;
+
+template<>
+struct QcMask<double> { typedef int64_t type; };
+
+template<>
+struct QcMask<float> { typedef int32_t type; };
+
+
+/**
+ * @brief message buffers of the QC decoder for one message type, block order
+ *
+ * Entry [b * lifting + r] belongs to the edge of block b in check row r of the block.
+ * @tparam T message type (float or double)
+ */
+template<typename T>
+struct QcMessageBuffers {
+    vector<T> msg_v;                   // messages from variable nodes to check nodes
+    vector<T> msg_c;                   // messages from check nodes to variable nodes
+    vector<T> llrs;                    // initial LLRs converted to T
+    vector<typename QcMask<T>::type> syndrome;  // -1 for a set syndrome bit, 0 otherwise
+    vector<T> scratch;                 // lifting entries, posteriors of one base column
+
+    void resize(const QcLdpcCode &code) {
+        const size_t n_messages = code.n_blocks() * code.lifting;
+        msg_v.resize(n_messages);
+        msg_c.resize(n_messages);
+        llrs.resize(code.n_cols());
+        syndrome.resize(code.n_rows());
+        scratch.resize(code.lifting);
+    }
+};
+
+
+/**
+ * @brief buffers of the QC decoder, reused across frames, one per thread
+ */
+struct QcDecoderWorkspace {
+    // messages per message type, double is allocated up front, float on first use
+    QcMessageBuffers<double> f64;
+    QcMessageBuffers<float> f32;
+    vector<uint8_t> bits;              // current hard decision
+    vector<uint8_t> flips;             // lifting entries, 1 where the decision of one base column changed
+    vector<uint8_t> unsatisfied;       // per check, 1 if the hard decision violates its syndrome bit
+    vector<bool> out;                  // decoded word after decode_qc
+};
+
+
+/**
+ * @brief builds a QC code from its base matrix
+ * @param base_rows number of block rows
+ * @param base_cols number of block columns
+ * @param lifting size of the circulants
+ * @param shifts base_rows x base_cols shifts, row-major, -1 for a zero block
+ * @return the code
+ */
+QcLdpcCode make_qc_ldpc_code(int base_rows, int base_cols, int lifting, vector<int32_t> shifts);
+
+
+/**
+ * @brief reads a base matrix file: "base_rows base_cols lifting" followed by the
+ * shifts row by row, -1 for a zero block
+ * @param path the file
+ * @return the code
+ */
+QcLdpcCode read_qc_base_matrix(const string &path);
+
+
+/**
+ * @brief expands a QC code into the explicit sparse form used by the other decoders
+ * @param code the QC code
+ * @return the expanded code
+ */
+LdpcCode expand_qc_code(const QcLdpcCode &code);
+
+
+/**
+ * @brief calculates the syndrome of a word, circulant by circulant
+ * @param code the QC code
+ * @param in the word, n_cols bits
+ * @param out output syndrome, resized to n_rows bits
+ */
+void qc_encode(const QcLdpcCode &code, const vector<bool> &in, vector<bool> &out);
+
+
+/**
+ * @brief allocates a QC decoder workspace
+ * @param code the QC code
+ * @return the workspace
+ */
+QcDecoderWorkspace make_qc_decoder_workspace(const QcLdpcCode &code);
+
+
+/**
+ * @brief decodes one frame on a QC code with the flooding schedule
+ *
+ * Gives the same decision as decode_at_current_rate with scalar kernels on the
+ * expanded code, for double and float messages and every check node rule.
+ * @param code the QC code
+ * @param llrs inital log-likelihood ratios
+ * @param syndrome the syndrome of the frame
+ * @param ws workspace for this code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return true if the decoded word matches the syndrome
+ */
+bool decode_qc(const QcLdpcCode &code,
+               const vector<double> &llrs,
+               const vector<bool> &syndrome,
+               QcDecoderWorkspace &ws,
+               const DecoderConfig &config);
+
+
+#endif //INFORMATION_THEORY_QC_LDPC_H
@@ -0,0 +1,315 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Rate-adaptive syndrome decoding by merging rows of a mother code.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "rate_adaptive.h"
+
+using namespace std;
+
+
+// marks a row without partner and an edge without parent
+static const uint32_t no_index = UINT32_MAX;
+
+
+/**
+ * @brief picks row pairs to merge, greedily pairing rows without a common variable
+ * @param mother the mother code
+ * @param n_merges number of pairs wanted, fewer are returned if the rows run out
+ * @return the pairs, in the order of the rows
+ */
+vector<pair<uint32_t, uint32_t>> default_row_merges(const LdpcCode &mother, const size_t n_merges) {
+    const TannerGraph &graph = mother.graph;
+    vector<pair<uint32_t, uint32_t>> merges;
+    vector<bool> used(mother.n_rows, false);
+    vector<uint32_t> marked(mother.n_cols, no_index);  // row whose variables are marked
+
+    for (uint32_t a = 0; a < static_cast<uint32_t>(mother.n_rows) && merges.size() < n_merges; ++a) {
+        if (used[a]) {
+            continue;
+        }
+        for (uint32_t e = graph.check_offsets[a]; e < graph.check_offsets[a + 1]; ++e) {
+            marked[graph.check_vars[e]] = a;
+        }
+        for (uint32_t b = a + 1; b < static_cast<uint32_t>(mother.n_rows); ++b) {
+            if (used[b]) {
+                continue;
+            }
+            bool disjoint = true;
+            for (uint32_t e = graph.check_offsets[b]; e < graph.check_offsets[b + 1] && disjoint; ++e) {
+                disjoint = marked[graph.check_vars[e]] != a;
+            }
+            if (disjoint) {
+                used[a] = used[b] = true;
+                merges.emplace_back(a, b);
+                break;
+            }
+        }
+    }
+    return merges;
+}
+
+
+/**
+ * @brief variables of a mother row, ascending
+ */
+static vector<uint32_t> mother_row(const LdpcCode &mother, const uint32_t row) {
+    const auto first = mother.graph.check_vars.begin();
+    return vector<uint32_t>(first + mother.graph.check_offsets[row], first + mother.graph.check_offsets[row + 1]);
+}
+
+
+/**
+ * @brief builds the code of one rate step from its rows
+ * @param mother the mother code
+ * @param groups first mother row of every row of the step
+ * @param partners merged mother row of every row of the step, no_index if none
+ * @return the code, rows in the order of groups
+ */
+static LdpcCode build_rate_step(const LdpcCode &mother,
+                                const vector<uint32_t> &groups,
+                                const vector<uint32_t> &partners) {
+    // variables of every row, a merged row is the sum of its two mother rows
+    vector<vector<uint32_t>> rows(groups.size());
+    for (size_t r = 0; r < groups.size(); ++r) {
+        rows[r] = mother_row(mother, groups[r]);
+        if (partners[r] != no_index) {
+            const vector<uint32_t> other = mother_row(mother, partners[r]);
+            vector<uint32_t> sum;
+            set_symmetric_difference(rows[r].begin(), rows[r].end(), other.begin(), other.end(),
+                                     back_inserter(sum));
+            rows[r].swap(sum);
+        }
+    }
+
+    // rows to CSC
+    vector<uint32_t> column_pointers(mother.n_cols + 1, 0);
+    for (const auto &row : rows) {
+        for (const uint32_t v : row) {
+            column_pointers[v + 1]++;
+        }
+    }
+    for (int col = 0; col < mother.n_cols; ++col) {
+        column_pointers[col + 1] += column_pointers[col];
+    }
+    vector<uint32_t> row_index(column_pointers.back());
+    vector<uint32_t> fill_pos(column_pointers.begin(), column_pointers.end() - 1);
+    for (size_t r = 0; r < rows.size(); ++r) {
+        for (const uint32_t v : rows[r]) {
+            row_index[fill_pos[v]++] = static_cast<uint32_t>(r);
+        }
+    }
+    return build_ldpc_code(mother.n_cols, static_cast<int>(rows.size()), column_pointers, row_index);
+}
+
+
+/**
+ * @brief builds the rate steps of a mother code
+ * @param mother the mother code
+ * @param merges row pairs of the mother, every row in at most one pair
+ * @param merges_per_step number of pairs split between two consecutive steps
+ * @return the rate-adaptive code
+ */
+RateAdaptiveCode make_rate_adaptive_code(const LdpcCode &mother,
+                                         const vector<pair<uint32_t, uint32_t>> &merges,
+                                         const size_t merges_per_step) {
+    if (merges_per_step == 0) {
+        throw runtime_error("at least one pair must be split per rate step.");
+    }
+    vector<bool> used(mother.n_rows, false);
+    for (const auto &merge : merges) {
+        if (merge.first >= static_cast<uint32_t>(mother.n_rows) || merge.second >= static_cast<uint32_t>(mother.n_rows)
+            || merge.first == merge.second || used[merge.first] || used[merge.second]) {
+            throw runtime_error("row pairs must be distinct rows of the mother code, each in one pair.");
+        }
+        used[merge.first] = used[merge.second] = true;
+    }
+
+    RateAdaptiveCode code;
+    code.mother = mother;
+    code.merges = merges;
+    const size_t n_steps = (merges.size() + merges_per_step - 1) / merges_per_step + 1;
+
+    vector<uint32_t> previous_row_of;  // mother row -> row of the previous step
+    for (size_t s = 0; s < n_steps; ++s) {
+        // the first n_merged pairs are still merged, the first row of a pair carries it
+        const size_t n_merged = merges.size() - min(merges.size(), s * merges_per_step);
+        vector<uint32_t> partner(mother.n_rows, no_index);
+        vector<bool> absorbed(mother.n_rows, false);
+        for (size_t i = 0; i < n_merged; ++i) {
+            partner[merges[i].first] = merges[i].second;
+            absorbed[merges[i].second] = true;
+        }
+
+        vector<uint32_t> groups, partners;
+        vector<uint32_t> row_of(mother.n_rows);
+        for (uint32_t r = 0; r < static_cast<uint32_t>(mother.n_rows); ++r) {
+            if (absorbed[r]) {
+                continue;
+            }
+            row_of[r] = static_cast<uint32_t>(groups.size());
+            if (partner[r] != no_index) {
+                row_of[partner[r]] = static_cast<uint32_t>(groups.size());
+            }
+            groups.push_back(r);
+            partners.push_back(partner[r]);
+        }
+        code.steps.push_back(build_rate_step(mother, groups, partners));
+
+        // every edge of a split row continues the edge of the merged row on the same variable
+        vector<uint32_t> parent;
+        if (s > 0) {
+            const TannerGraph &graph = code.steps[s].graph;
+            const TannerGraph &previous = code.steps[s - 1].graph;
+            parent.assign(graph.n_edges(), no_index);
+            for (size_t r = 0; r < groups.size(); ++r) {
+                const uint32_t p = previous_row_of[groups[r]];
+                uint32_t pe = previous.check_offsets[p];
+                for (uint32_t e = graph.check_offsets[r]; e < graph.check_offsets[r + 1]; ++e) {
+                    while (pe < previous.check_offsets[p + 1] && previous.check_vars[pe] < graph.check_vars[e]) {
+                        ++pe;
+                    }
+                    if (pe < previous.check_offsets[p + 1] && previous.check_vars[pe] == graph.check_vars[e]) {
+                        parent[e] = pe;
+                    }
+                }
+            }
+        }
+        code.parent_edge.push_back(parent);
+        code.row_groups.push_back(groups);
+        code.row_partners.push_back(partners);
+        previous_row_of.swap(row_of);
+    }
+    return code;
+}
+
+
+/**
+ * @brief syndrome of a rate step, derived from the syndrome of the mother code
+ * @param code the rate-adaptive code
+ * @param step the step
+ * @param mother_syndrome syndrome of the mother code
+ * @param syndrome output, resized to the rows of the step
+ */
+void rate_step_syndrome(const RateAdaptiveCode &code,
+                        const size_t step,
+                        const vector<bool> &mother_syndrome,
+                        vector<bool> &syndrome) {
+    if (mother_syndrome.size() != code.mother.n_rows) {
+        throw runtime_error("checksum doesn't match number of rows in H");
+    }
+    const vector<uint32_t> &groups = code.row_groups.at(step);
+    const vector<uint32_t> &partners = code.row_partners[step];
+    syndrome.resize(groups.size());
+    for (size_t r = 0; r < groups.size(); ++r) {
+        syndrome[r] = mother_syndrome[groups[r]] != (partners[r] != no_index && mother_syndrome[partners[r]]);
+    }
+}
+
+
+/**
+ * @brief moves the messages of the previous step onto the edges of a step
+ *
+ * The check order buffer holds variable to check messages with the flooding
+ * schedule and check to variable messages with the layered one. New edges start
+ * from the channel LLR or from zero respectively, which keeps the posteriors of the
+ * layered schedule consistent.
+ * @tparam T message type (float or double)
+ * @param code the rate-adaptive code
+ * @param step the step to move to, > 0
+ * @param llrs inital log-likelihood ratios
+ * @param ws the decoder workspace
+ * @param config decoder parameters
+ */
+template<typename T>
+static void carry_messages(const RateAdaptiveCode &code,
+                           const size_t step,
+                           const vector<double> &llrs,
+                           DecoderWorkspace &ws,
+                           const DecoderConfig &config) {
+    MessageBuffers<T> &buffers = message_buffers<T>(ws);
+    const vector<uint32_t> &parent = code.parent_edge[step];
+    const TannerGraph &graph = code.steps[step].graph;
+    vector<T> moved(parent.size());
+    for (size_t e = 0; e < parent.size(); ++e) {
+        if (parent[e] != no_index) {
+            moved[e] = buffers.msg_v[parent[e]];
+        } else {
+            moved[e] = config.schedule == Schedule::layered ? T(0) : static_cast<T>(llrs[graph.check_vars[e]]);
+        }
+    }
+    buffers.msg_v.swap(moved);
+}
+
+
+/**
+ * @brief decodes at the highest rate first and reveals more syndrome bits on failure
+ * @param code the rate-adaptive code
+ * @param llrs inital log-likelihood ratios
+ * @param mother_syndrome syndrome of the mother code, only the revealed part is used
+ * @param ws decoder workspace of the mother code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return success, the last step and the number of syndrome bits used
+ */
+RateAdaptiveResult decode_rate_adaptive(const RateAdaptiveCode &code,
+                                        const vector<double> &llrs,
+                                        const vector<bool> &mother_syndrome,
+                                        DecoderWorkspace &ws,
+                                        const DecoderConfig &config) {
+    if (config.message_type == MessageType::fixed_point) {
+        throw runtime_error("rate-adaptive decoding needs floating point messages.");
+    }
+
+    RateAdaptiveResult result;
+    vector<bool> syndrome;
+    DecoderConfig step_config = config;
+    for (size_t s = 0; s < code.steps.size(); ++s) {
+        const LdpcCode &step = code.steps[s];
+        rate_step_syndrome(code, s, mother_syndrome, syndrome);
+        if (s > 0) {
+            if (config.message_type == MessageType::float32) {
+                carry_messages<float>(code, s, llrs, ws, config);
+            } else {
+                carry_messages<double>(code, s, llrs, ws, config);
+            }
+        }
+        step_config.warm_start = s > 0;
+        ws.unsatisfied.resize(step.n_rows);
+
+        result.step = s;
+        result.syndrome_bits = step.n_rows;
+        result.success = decode_at_current_rate(step, llrs, syndrome, ws, step_config);
+        if (result.success) {
+            break;
+        }
+    }
+    ws.unsatisfied.resize(code.mother.n_rows);
+    return result;
+}
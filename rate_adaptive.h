@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Rate-adaptive syndrome decoding. Pairs of rows of a mother parity check matrix are
+merged into one row (their sum over GF(2)), which removes one syndrome bit per
+pair. Decoding starts with all pairs merged, the highest compression, and every
+failed attempt reveals the syndrome bits of some more rows by splitting their
+pairs again, until the decoder succeeds or the full mother syndrome is used.
+Every split keeps the edges of the merged row, so the next attempt resumes from
+the messages of the previous one instead of starting over from the channel LLRs.
+*/
+
+
+#ifndef INFORMATION_THEORY_RATE_ADAPTIVE_H
+#define INFORMATION_THEORY_RATE_ADAPTIVE_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+/**
+ * @brief a mother code with the rate steps obtained by merging pairs of its rows
+ */
+struct RateAdaptiveCode {
+    LdpcCode mother;
+    vector<pair<uint32_t, uint32_t>> merges;  // row pairs of the mother, the last ones are split first
+    vector<LdpcCode> steps;            // step 0 has every pair merged, the last step is the mother code
+    vector<vector<uint32_t>> row_groups;      // per step and row, the first mother row of the row
+    vector<vector<uint32_t>> row_partners;    // per step and row, the merged mother row or UINT32_MAX
+    vector<vector<uint32_t>> parent_edge;     // per step > 0, edge of the previous step each edge
+                                              // continues (check order), UINT32_MAX for new edges
+};
+
+
+/**
+ * @brief outcome of a rate-adaptive decode
+ */
+struct RateAdaptiveResult {
+    bool success{};                    // the decoded word matches the revealed syndrome
+    size_t step{};                     // last step tried
+    size_t syndrome_bits{};            // syndrome bits revealed up to that step
+};
+
+
+/**
+ * @brief picks row pairs to merge, greedily pairing rows without a common variable
+ * @param mother the mother code
+ * @param n_merges number of pairs wanted, fewer are returned if the rows run out
+ * @return the pairs, in the order of the rows
+ */
+vector<pair<uint32_t, uint32_t>> default_row_merges(const LdpcCode &mother, size_t n_merges);
+
+
+/**
+ * @brief builds the rate steps of a mother code
+ * @param mother the mother code
+ * @param merges row pairs of the mother, every row in at most one pair
+ * @param merges_per_step number of pairs split between two consecutive steps
+ * @return the rate-adaptive code
+ */
+RateAdaptiveCode make_rate_adaptive_code(const LdpcCode &mother,
+                                         const vector<pair<uint32_t, uint32_t>> &merges,
+                                         size_t merges_per_step);
+
+
+/**
+ * @brief syndrome of a rate step, derived from the syndrome of the mother code
+ *
+ * This is what the receiver knows at that step: the sums of the merged pairs and
+ * the bits of the rows that were already split.
+ * @param code the rate-adaptive code
+ * @param step the step
+ * @param mother_syndrome syndrome of the mother code
+ * @param syndrome output, resized to the rows of the step
+ */
+void rate_step_syndrome(const RateAdaptiveCode &code,
+                        size_t step,
+                        const vector<bool> &mother_syndrome,
+                        vector<bool> &syndrome);
+
+
+/**
+ * @brief decodes at the highest rate first and reveals more syndrome bits on failure
+ *
+ * Every step runs up to config.max_num_iter iterations. From the second step on the
+ * messages of the previous step are moved onto the split rows and decoding resumes
+ * from them (DecoderConfig::warm_start), with either schedule and double or float
+ * messages.
+ * @param code the rate-adaptive code
+ * @param llrs inital log-likelihood ratios
+ * @param mother_syndrome syndrome of the mother code, only the revealed part is used
+ * @param ws decoder workspace of the mother code, the decoded word is left in ws.out
+ * @param config decoder parameters
+ * @return success, the last step and the number of syndrome bits used
+ */
+RateAdaptiveResult decode_rate_adaptive(const RateAdaptiveCode &code,
+                                        const vector<double> &llrs,
+                                        const vector<bool> &mother_syndrome,
+                                        DecoderWorkspace &ws,
+                                        const DecoderConfig &config);
+
+
+#endif //INFORMATION_THEORY_RATE_ADAPTIVE_H
@@ -0,0 +1,1339 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Vectorized (AVX2/AVX-512) versions of the check and variable node update steps.
+Each kernel is compiled for its instruction set with a function target attribute,
+the dispatch functions at the end pick one at runtime.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "simd_kernels.h"
+#include "lane_math.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_KERNELS_X86
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx2,avx512f")))
+#endif
+
+using namespace std;
+
+
+/**
+ * @brief merges per-lane (min1, min2) pairs into the two smallest values overall
+ * @param lane1 smallest value of each lane
+ * @param lane2 second smallest value of each lane
+ * @param n_lanes number of lanes
+ * @param min1 output, smallest value
+ * @param min2 output, second smallest value (equal to min1 on ties)
+ */
+template<typename T>
+static void merge_lane_minima(const T *lane1, const T *lane2, const int n_lanes,
+                              T &min1, T &min2) {
+    min1 = HUGE_VAL;
+    min2 = HUGE_VAL;
+    for (int i = 0; i < n_lanes; ++i) {
+        for (const T v : {lane1[i], lane2[i]}) {
+            if (v < min1) {
+                min2 = min1;
+                min1 = v;
+            } else if (v < min2) {
+                min2 = v;
+            }
+        }
+    }
+}
+
+
+#ifdef SIMD_KERNELS_X86
+
+//----------------------------------------------------------------------
+// AVX2
+//----------------------------------------------------------------------
+
+/**
+ * @brief expm1 of four non-positive values
+ */
+TARGET_AVX2 static inline __m256d avx2_expm1_neg(__m256d y) {
+    y = _mm256_max_pd(y, _mm256_set1_pd(-700.));
+    const __m256d n = _mm256_round_pd(_mm256_mul_pd(y, _mm256_set1_pd(log2_e)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_sub_pd(y, _mm256_mul_pd(n, _mm256_set1_pd(ln2_hi)));
+    r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(ln2_lo)));
+
+    __m256d q = _mm256_set1_pd(expm1_coeffs[11]);
+    for (int k = 10; k >= 0; --k) {
+        q = _mm256_add_pd(_mm256_mul_pd(q, r), _mm256_set1_pd(expm1_coeffs[k]));
+    }
+    const __m256d p = _mm256_mul_pd(q, r);
+
+    // 2^n through the exponent bits, n is integral and within the normal range here
+    const __m256d magic = _mm256_set1_pd(6755399441055744.0);  // 1.5 * 2^52
+    const __m256i n_int = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n, magic)),
+                                           _mm256_castpd_si256(magic));
+    const __m256d two_n = _mm256_castsi256_pd(
+            _mm256_slli_epi64(_mm256_add_epi64(n_int, _mm256_set1_epi64x(1023)), 52));
+
+    // expm1(y) = 2^n * expm1(r) + (2^n - 1), exact in r when n == 0
+    return _mm256_add_pd(_mm256_mul_pd(two_n, p), _mm256_sub_pd(two_n, _mm256_set1_pd(1.)));
+}
+
+
+/**
+ * @brief tanh(x/2) of four values
+ */
+TARGET_AVX2 static inline __m256d avx2_tanh_half(const __m256d x) {
+    const __m256d sign_mask = _mm256_set1_pd(-0.);
+    const __m256d em = avx2_expm1_neg(_mm256_or_pd(x, sign_mask));  // expm1(-|x|)
+    const __m256d t = _mm256_div_pd(_mm256_sub_pd(_mm256_setzero_pd(), em),
+                                    _mm256_add_pd(_mm256_set1_pd(2.), em));
+    return _mm256_or_pd(t, _mm256_and_pd(x, sign_mask));
+}
+
+
+/**
+ * @brief natural log of four values, with log(0) = -inf, log(inf) = inf, log(<0) = NaN
+ */
+TARGET_AVX2 static inline __m256d avx2_log(const __m256d x) {
+    const __m256i bits = _mm256_castpd_si256(x);
+    const __m256i mantissa_mask = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+    const __m256i one_bits = _mm256_set1_epi64x(0x3FF0000000000000LL);
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mantissa_mask), one_bits));
+
+    // exponent field to double, positive inputs only
+    const __m256d two_52 = _mm256_set1_pd(4503599627370496.0);
+    const __m256i e_field = _mm256_srli_epi64(bits, 52);
+    __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(e_field, _mm256_castpd_si256(two_52))),
+                              _mm256_set1_pd(4503599627370496.0 + 1023.));
+
+    // move m into [sqrt(1/2), sqrt(2))
+    const __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(1.4142135623730951), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+    e = _mm256_blendv_pd(e, _mm256_add_pd(e, _mm256_set1_pd(1.)), big);
+
+    const __m256d one = _mm256_set1_pd(1.);
+    const __m256d s = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    const __m256d s2 = _mm256_mul_pd(s, s);
+    __m256d q = _mm256_set1_pd(log_coeffs[11]);
+    for (int k = 10; k >= 0; --k) {
+        q = _mm256_add_pd(_mm256_mul_pd(q, s2), _mm256_set1_pd(log_coeffs[k]));
+    }
+    const __m256d log_m = _mm256_mul_pd(_mm256_add_pd(s, s), q);
+    __m256d res = _mm256_add_pd(_mm256_mul_pd(e, _mm256_set1_pd(ln2_hi)),
+                                _mm256_add_pd(log_m, _mm256_mul_pd(e, _mm256_set1_pd(ln2_lo))));
+
+    // special values
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d inf = _mm256_set1_pd(HUGE_VAL);
+    res = _mm256_blendv_pd(res, inf, _mm256_cmp_pd(x, inf, _CMP_EQ_OQ));
+    res = _mm256_blendv_pd(res, _mm256_sub_pd(zero, inf), _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+    res = _mm256_blendv_pd(res, _mm256_set1_pd(NAN), _mm256_cmp_pd(x, zero, _CMP_NGE_UQ));
+    return res;
+}
+
+
+/**
+ * @brief lane mask selecting the first n (< 4) of four doubles
+ */
+TARGET_AVX2 static inline __m256i avx2_tail_mask(const uint32_t n) {
+    const __m256i lanes = _mm256_set_epi64x(3, 2, 1, 0);
+    return _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), lanes);
+}
+
+
+template<typename Index>
+TARGET_AVX2 static void check_node_update_avx2(vector<double> &msg_c,
+                                               const vector<double> &msg_v,
+                                               const vector<bool> &syndrome,
+                                               const TannerGraph &graph,
+                                               double *scratch,
+                                               const Index *c2v) {
+    const double *mv = msg_v.data();
+    double *mc = msg_c.data();
+    alignas(32) double lanes[4];
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+        const uint32_t deg = end - begin;
+
+        // tanh of every incoming message, kept in scratch for the second pass
+        __m256d prod = _mm256_set1_pd(1.);
+        uint32_t k = 0;
+        for (; k + 4 <= deg; k += 4) {
+            const __m256d t = avx2_tanh_half(_mm256_loadu_pd(mv + begin + k));
+            _mm256_storeu_pd(scratch + k, t);
+            prod = _mm256_mul_pd(prod, t);
+        }
+        if (k < deg) {
+            const __m256i mask = avx2_tail_mask(deg - k);
+            const __m256d t = avx2_tanh_half(_mm256_maskload_pd(mv + begin + k, mask));
+            _mm256_maskstore_pd(scratch + k, mask, t);
+            prod = _mm256_mul_pd(prod, _mm256_blendv_pd(_mm256_set1_pd(1.), t, _mm256_castsi256_pd(mask)));
+        }
+        _mm256_store_pd(lanes, prod);
+        const double mc_prod = (1 - 2 * static_cast<double>(syndrome[m]))
+                               * ((lanes[0] * lanes[1]) * (lanes[2] * lanes[3]));
+
+        // same convention as the scalar kernel for zero messages
+        const __m256d zero_msg_part = _mm256_set1_pd(deg > 1 ? 0. : 1.);
+        const __m256d one = _mm256_set1_pd(1.);
+        for (k = 0; k < deg; k += 4) {
+            const uint32_t n = min(deg - k, 4u);
+            const __m256i mask = avx2_tail_mask(n);
+            const __m256d x = _mm256_maskload_pd(mv + begin + k, mask);
+            const __m256d t = _mm256_maskload_pd(scratch + k, mask);
+            __m256d msg_part = _mm256_div_pd(_mm256_set1_pd(mc_prod), t);
+            msg_part = _mm256_blendv_pd(msg_part, zero_msg_part,
+                                        _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_EQ_OQ));
+            const __m256d res = avx2_log(_mm256_div_pd(_mm256_add_pd(one, msg_part),
+                                                       _mm256_sub_pd(one, msg_part)));
+            _mm256_store_pd(lanes, res);
+            for (uint32_t i = 0; i < n; ++i) {
+                mc[c2v[begin + k + i]] = lanes[i];
+            }
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX2 static void check_node_update_min_sum_avx2(vector<double> &msg_c,
+                                                       const vector<double> &msg_v,
+                                                       const vector<bool> &syndrome,
+                                                       const TannerGraph &graph,
+                                                       const double scale,
+                                                       const double offset,
+                                                       const Index *c2v) {
+    const double *mv = msg_v.data();
+    double *mc = msg_c.data();
+    const __m256d sign_mask = _mm256_set1_pd(-0.);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d inf = _mm256_set1_pd(HUGE_VAL);
+    alignas(32) double lane1[4], lane2[4];
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
+        // per lane two smallest magnitudes and the sign parity
+        __m256d vmin1 = inf;
+        __m256d vmin2 = inf;
+        int parity = syndrome[m];
+        for (uint32_t e = begin; e < end; e += 4) {
+            const __m256i mask = avx2_tail_mask(min(end - e, 4u));
+            const __m256d x = _mm256_maskload_pd(mv + e, mask);
+            const __m256d mag = _mm256_blendv_pd(inf, _mm256_andnot_pd(sign_mask, x), _mm256_castsi256_pd(mask));
+            parity ^= __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(x, zero, _CMP_LT_OQ))) & 1;
+            vmin2 = _mm256_min_pd(vmin2, _mm256_max_pd(vmin1, mag));
+            vmin1 = _mm256_min_pd(vmin1, mag);
+        }
+        _mm256_store_pd(lane1, vmin1);
+        _mm256_store_pd(lane2, vmin2);
+        double min1, min2;
+        merge_lane_minima(lane1, lane2, 4, min1, min2);
+
+        // the edge holding the minimum gets min2, ties give min1 == min2 anyway
+        const __m256d out1 = _mm256_set1_pd(min_sum_magnitude(min1, scale, offset));
+        const __m256d out2 = _mm256_set1_pd(min_sum_magnitude(min2, scale, offset));
+        const __m256d vmin = _mm256_set1_pd(min1);
+        const __m256d parity_sign = parity ? sign_mask : zero;
+        for (uint32_t e = begin; e < end; e += 4) {
+            const uint32_t n = min(end - e, 4u);
+            const __m256d x = _mm256_maskload_pd(mv + e, avx2_tail_mask(n));
+            const __m256d mag = _mm256_andnot_pd(sign_mask, x);
+            const __m256d sel = _mm256_blendv_pd(out1, out2, _mm256_cmp_pd(mag, vmin, _CMP_EQ_OQ));
+            const __m256d sign = _mm256_xor_pd(parity_sign,
+                                               _mm256_and_pd(_mm256_cmp_pd(x, zero, _CMP_LT_OQ), sign_mask));
+            _mm256_store_pd(lane1, _mm256_xor_pd(sel, sign));
+            for (uint32_t i = 0; i < n; ++i) {
+                mc[c2v[e + i]] = lane1[i];
+            }
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX2 static void var_node_update_avx2(vector<double> &msg_v,
+                                             const vector<double> &msg_c,
+                                             const vector<double> &llrs,
+                                             const TannerGraph &graph,
+                                             const Index *v2c) {
+    double *mv = msg_v.data();
+    const double *mc = msg_c.data();
+    const uint32_t *offsets = graph.var_offsets.data();
+    const size_t n_cols = llrs.size();
+    alignas(32) double lanes[4];
+
+    size_t v = 0;
+    for (; v + 4 <= n_cols; v += 4) {
+        const __m128i begin = _mm_loadu_si128(reinterpret_cast<const __m128i *>(offsets + v));
+        const __m128i deg = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(offsets + v + 1)), begin);
+        uint32_t max_deg = 0;
+        for (int i = 0; i < 4; ++i) {
+            max_deg = max(max_deg, offsets[v + i + 1] - offsets[v + i]);
+        }
+
+        // lane i adds up the messages of variable v + i, in the scalar order
+        __m256d sum = _mm256_loadu_pd(llrs.data() + v);
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m128i kk = _mm_set1_epi32(static_cast<int>(k));
+            const __m256d mask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(deg, kk)));
+            const __m256d c = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), mc, _mm_add_epi32(begin, kk), mask, 8);
+            sum = _mm256_blendv_pd(sum, _mm256_add_pd(sum, c), mask);
+        }
+
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m128i kk = _mm_set1_epi32(static_cast<int>(k));
+            const __m256d mask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(deg, kk)));
+            const __m256d c = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), mc, _mm_add_epi32(begin, kk), mask, 8);
+            _mm256_store_pd(lanes, _mm256_sub_pd(sum, c));
+            for (int i = 0; i < 4; ++i) {
+                const uint32_t e = offsets[v + i] + k;
+                if (e < offsets[v + i + 1]) {
+                    mv[v2c[e]] = lanes[i];
+                }
+            }
+        }
+    }
+
+    // remaining variable nodes
+    for (; v < n_cols; ++v) {
+        double mv_sum = llrs[v];
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+            mv_sum += mc[e];
+        }
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+            mv[v2c[e]] = mv_sum - mc[e];
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------
+// AVX-512
+//----------------------------------------------------------------------
+
+/**
+ * @brief lane mask selecting the first n (<= 8) of eight doubles
+ */
+static inline __mmask8 avx512_tail_mask(const uint32_t n) {
+    return n >= 8 ? static_cast<__mmask8>(0xFF) : static_cast<__mmask8>((1u << n) - 1);
+}
+
+
+/**
+ * @brief expm1 of eight non-positive values
+ */
+TARGET_AVX512 static inline __m512d avx512_expm1_neg(__m512d y) {
+    y = _mm512_max_pd(y, _mm512_set1_pd(-700.));
+    const __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(y, _mm512_set1_pd(log2_e)),
+                                           _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_sub_pd(y, _mm512_mul_pd(n, _mm512_set1_pd(ln2_hi)));
+    r = _mm512_sub_pd(r, _mm512_mul_pd(n, _mm512_set1_pd(ln2_lo)));
+
+    __m512d q = _mm512_set1_pd(expm1_coeffs[11]);
+    for (int k = 10; k >= 0; --k) {
+        q = _mm512_add_pd(_mm512_mul_pd(q, r), _mm512_set1_pd(expm1_coeffs[k]));
+    }
+    const __m512d p = _mm512_mul_pd(q, r);
+
+    // expm1(y) = 2^n * expm1(r) + (2^n - 1), exact in r when n == 0
+    const __m512d two_n = _mm512_scalef_pd(_mm512_set1_pd(1.), n);
+    return _mm512_add_pd(_mm512_scalef_pd(p, n), _mm512_sub_pd(two_n, _mm512_set1_pd(1.)));
+}
+
+
+/**
+ * @brief tanh(x/2) of eight values
+ */
+TARGET_AVX512 static inline __m512d avx512_tanh_half(const __m512d x) {
+    const __m512i sign_mask = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL));
+    const __m512i x_bits = _mm512_castpd_si512(x);
+    const __m512d em = avx512_expm1_neg(_mm512_castsi512_pd(_mm512_or_si512(x_bits, sign_mask)));
+    const __m512d t = _mm512_div_pd(_mm512_sub_pd(_mm512_setzero_pd(), em),
+                                    _mm512_add_pd(_mm512_set1_pd(2.), em));
+    return _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(t), _mm512_and_si512(x_bits, sign_mask)));
+}
+
+
+/**
+ * @brief natural log of eight values, with log(0) = -inf, log(inf) = inf, log(<0) = NaN
+ */
+TARGET_AVX512 static inline __m512d avx512_log(const __m512d x) {
+    // x = 2^e * m with m in [0.75, 1.5)
+    const __m512d m = _mm512_getmant_pd(x, _MM_MANT_NORM_p75_1p5, _MM_MANT_SIGN_zero);
+    __m512d e = _mm512_getexp_pd(x);
+    e = _mm512_mask_add_pd(e, _mm512_cmp_pd_mask(m, _mm512_set1_pd(1.), _CMP_LT_OQ), e, _mm512_set1_pd(1.));
+
+    const __m512d one = _mm512_set1_pd(1.);
+    const __m512d s = _mm512_div_pd(_mm512_sub_pd(m, one), _mm512_add_pd(m, one));
+    const __m512d s2 = _mm512_mul_pd(s, s);
+    __m512d q = _mm512_set1_pd(log_coeffs[11]);
+    for (int k = 10; k >= 0; --k) {
+        q = _mm512_add_pd(_mm512_mul_pd(q, s2), _mm512_set1_pd(log_coeffs[k]));
+    }
+    const __m512d log_m = _mm512_mul_pd(_mm512_add_pd(s, s), q);
+    __m512d res = _mm512_add_pd(_mm512_mul_pd(e, _mm512_set1_pd(ln2_hi)),
+                                _mm512_add_pd(log_m, _mm512_mul_pd(e, _mm512_set1_pd(ln2_lo))));
+
+    // special values
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d inf = _mm512_set1_pd(HUGE_VAL);
+    res = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, inf, _CMP_EQ_OQ), res, inf);
+    res = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, zero, _CMP_EQ_OQ), res, _mm512_sub_pd(zero, inf));
+    res = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, zero, _CMP_NGE_UQ), res, _mm512_set1_pd(NAN));
+    return res;
+}
+
+
+/**
+ * @brief eight 32 bit edge indices, masked load
+ */
+TARGET_AVX512 static inline __m256i avx512_load_index(const __mmask8 mask, const uint32_t *p) {
+    return _mm512_castsi512_si256(_mm512_maskz_loadu_epi32(static_cast<__mmask16>(mask), p));
+}
+
+
+/**
+ * @brief eight 16 bit edge indices widened to 32 bit, the padding of the 16-bit
+ * permutations makes the full load safe
+ */
+TARGET_AVX512 static inline __m256i avx512_load_index(const __mmask8, const uint16_t *p) {
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+
+/**
+ * @brief sixteen 32 bit edge indices, masked load
+ */
+TARGET_AVX512 static inline __m512i avx512_load_index16(const __mmask16 mask, const uint32_t *p) {
+    return _mm512_maskz_loadu_epi32(mask, p);
+}
+
+
+/**
+ * @brief sixteen 16 bit edge indices widened to 32 bit
+ */
+TARGET_AVX512 static inline __m512i avx512_load_index16(const __mmask16, const uint16_t *p) {
+    return _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+
+
+/**
+ * @brief gathers p[idx] for the lanes in mask
+ */
+TARGET_AVX512 static inline __m512i avx512_gather_index(const __mmask16 mask, const __m512i idx, const uint32_t *p) {
+    return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, idx, reinterpret_cast<const int *>(p), 4);
+}
+
+
+/**
+ * @brief gathers 16 bit p[idx] for the lanes in mask, as 32 bit reads masked to their low half
+ */
+TARGET_AVX512 static inline __m512i avx512_gather_index(const __mmask16 mask, const __m512i idx, const uint16_t *p) {
+    const __m512i pairs = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, idx,
+                                                      reinterpret_cast<const int *>(p), 2);
+    return _mm512_and_si512(pairs, _mm512_set1_epi32(0xffff));
+}
+
+
+template<typename Index>
+TARGET_AVX512 static void check_node_update_avx512(vector<double> &msg_c,
+                                                   const vector<double> &msg_v,
+                                                   const vector<bool> &syndrome,
+                                                   const TannerGraph &graph,
+                                                   double *scratch,
+                                                   const Index *c2v) {
+    const double *mv = msg_v.data();
+    double *mc = msg_c.data();
+    const __m512d one = _mm512_set1_pd(1.);
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+        const uint32_t deg = end - begin;
+
+        // tanh of every incoming message, kept in scratch for the second pass
+        __m512d prod = one;
+        for (uint32_t k = 0; k < deg; k += 8) {
+            const __mmask8 mask = avx512_tail_mask(deg - k);
+            const __m512d t = avx512_tanh_half(_mm512_maskz_loadu_pd(mask, mv + begin + k));
+            _mm512_mask_storeu_pd(scratch + k, mask, t);
+            prod = _mm512_mask_mul_pd(prod, mask, prod, t);
+        }
+        const double mc_prod = (1 - 2 * static_cast<double>(syndrome[m])) * _mm512_reduce_mul_pd(prod);
+
+        // same convention as the scalar kernel for zero messages
+        const __m512d zero_msg_part = _mm512_set1_pd(deg > 1 ? 0. : 1.);
+        for (uint32_t k = 0; k < deg; k += 8) {
+            const __mmask8 mask = avx512_tail_mask(deg - k);
+            const __m512d x = _mm512_maskz_loadu_pd(mask, mv + begin + k);
+            const __m512d t = _mm512_mask_loadu_pd(one, mask, scratch + k);
+            __m512d msg_part = _mm512_div_pd(_mm512_set1_pd(mc_prod), t);
+            msg_part = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, _mm512_setzero_pd(), _CMP_EQ_OQ),
+                                            msg_part, zero_msg_part);
+            const __m512d res = avx512_log(_mm512_div_pd(_mm512_add_pd(one, msg_part),
+                                                         _mm512_sub_pd(one, msg_part)));
+            _mm512_mask_i32scatter_pd(mc, mask, avx512_load_index(mask, c2v + begin + k), res, 8);
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX512 static void check_node_update_min_sum_avx512(vector<double> &msg_c,
+                                                           const vector<double> &msg_v,
+                                                           const vector<bool> &syndrome,
+                                                           const TannerGraph &graph,
+                                                           const double scale,
+                                                           const double offset,
+                                                           const Index *c2v) {
+    const double *mv = msg_v.data();
+    double *mc = msg_c.data();
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d inf = _mm512_set1_pd(HUGE_VAL);
+    const __m512i sign_mask = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL));
+    alignas(64) double lane1[8], lane2[8];
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
+        // per lane two smallest magnitudes and the sign parity
+        __m512d vmin1 = inf;
+        __m512d vmin2 = inf;
+        int parity = syndrome[m];
+        for (uint32_t e = begin; e < end; e += 8) {
+            const __mmask8 mask = avx512_tail_mask(end - e);
+            const __m512d x = _mm512_maskz_loadu_pd(mask, mv + e);
+            const __m512d mag = _mm512_mask_abs_pd(inf, mask, x);
+            parity ^= __builtin_popcount(_mm512_cmp_pd_mask(x, zero, _CMP_LT_OQ)) & 1;
+            vmin2 = _mm512_min_pd(vmin2, _mm512_max_pd(vmin1, mag));
+            vmin1 = _mm512_min_pd(vmin1, mag);
+        }
+        _mm512_store_pd(lane1, vmin1);
+        _mm512_store_pd(lane2, vmin2);
+        double min1, min2;
+        merge_lane_minima(lane1, lane2, 8, min1, min2);
+
+        // the edge holding the minimum gets min2, ties give min1 == min2 anyway
+        const __m512d out1 = _mm512_set1_pd(min_sum_magnitude(min1, scale, offset));
+        const __m512d out2 = _mm512_set1_pd(min_sum_magnitude(min2, scale, offset));
+        const __m512d vmin = _mm512_set1_pd(min1);
+        const __m512i parity_sign = parity ? sign_mask : _mm512_setzero_si512();
+        for (uint32_t e = begin; e < end; e += 8) {
+            const __mmask8 mask = avx512_tail_mask(end - e);
+            const __m512d x = _mm512_maskz_loadu_pd(mask, mv + e);
+            const __m512d sel = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(_mm512_abs_pd(x), vmin, _CMP_EQ_OQ),
+                                                     out1, out2);
+            const __m512i sign = _mm512_mask_xor_epi64(parity_sign, _mm512_cmp_pd_mask(x, zero, _CMP_LT_OQ),
+                                                       parity_sign, sign_mask);
+            const __m512d res = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(sel), sign));
+            _mm512_mask_i32scatter_pd(mc, mask, avx512_load_index(mask, c2v + e), res, 8);
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX512 static void var_node_update_avx512(vector<double> &msg_v,
+                                                 const vector<double> &msg_c,
+                                                 const vector<double> &llrs,
+                                                 const TannerGraph &graph,
+                                                 const Index *v2c) {
+    double *mv = msg_v.data();
+    const double *mc = msg_c.data();
+    const uint32_t *offsets = graph.var_offsets.data();
+    const size_t n_cols = llrs.size();
+
+    for (size_t v = 0; v < n_cols; v += 8) {
+        const __mmask8 lanes = avx512_tail_mask(static_cast<uint32_t>(min<size_t>(n_cols - v, 8)));
+        const __m512i begin = _mm512_zextsi256_si512(avx512_load_index(lanes, offsets + v));
+        const __m512i deg = _mm512_sub_epi32(_mm512_zextsi256_si512(avx512_load_index(lanes, offsets + v + 1)),
+                                             begin);
+        const uint32_t max_deg = static_cast<uint32_t>(_mm512_reduce_max_epi32(deg));
+
+        // lane i adds up the messages of variable v + i, in the scalar order
+        __m512d sum = _mm512_maskz_loadu_pd(lanes, llrs.data() + v);
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m512i kk = _mm512_set1_epi32(static_cast<int>(k));
+            const __mmask8 mask = static_cast<__mmask8>(_mm512_cmpgt_epi32_mask(deg, kk));
+            const __m256i idx = _mm512_castsi512_si256(_mm512_add_epi32(begin, kk));
+            const __m512d c = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, idx, mc, 8);
+            sum = _mm512_mask_add_pd(sum, mask, sum, c);
+        }
+
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m512i kk = _mm512_set1_epi32(static_cast<int>(k));
+            const __mmask8 mask = static_cast<__mmask8>(_mm512_cmpgt_epi32_mask(deg, kk));
+            const __m512i idx = _mm512_add_epi32(begin, kk);
+            const __m512d c = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask,
+                                                       _mm512_castsi512_si256(idx), mc, 8);
+            const __m512i target = avx512_gather_index(mask, idx, v2c);
+            _mm512_mask_i32scatter_pd(mv, mask, _mm512_castsi512_si256(target), _mm512_sub_pd(sum, c), 8);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------
+// float messages
+//----------------------------------------------------------------------
+
+// float versions of the series in lane_math.h, |r| <= ln(2)/2 and |s| <= 0.172 need fewer terms
+static const float expm1_coeffs_f[7] = {
+        1.0f, 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120, 1.0f / 720, 1.0f / 5040};
+static const float log_coeffs_f[6] = {1.0f, 1.0f / 3, 1.0f / 5, 1.0f / 7, 1.0f / 9, 1.0f / 11};
+
+static const float ln2_hi_f = 0.693145751953125f;
+static const float ln2_lo_f = 1.428606765330187045e-06f;
+
+
+/**
+ * @brief expm1 of eight non-positive floats
+ */
+TARGET_AVX2 static inline __m256 avx2_expm1_neg_ps(__m256 y) {
+    y = _mm256_max_ps(y, _mm256_set1_ps(-87.f));
+    const __m256 n = _mm256_round_ps(_mm256_mul_ps(y, _mm256_set1_ps(static_cast<float>(log2_e))),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_sub_ps(y, _mm256_mul_ps(n, _mm256_set1_ps(ln2_hi_f)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(ln2_lo_f)));
+
+    __m256 q = _mm256_set1_ps(expm1_coeffs_f[6]);
+    for (int k = 5; k >= 0; --k) {
+        q = _mm256_add_ps(_mm256_mul_ps(q, r), _mm256_set1_ps(expm1_coeffs_f[k]));
+    }
+    const __m256 p = _mm256_mul_ps(q, r);
+
+    // 2^n through the exponent bits, n >= -126 after the clamp
+    const __m256 two_n = _mm256_castsi256_ps(
+            _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+    return _mm256_add_ps(_mm256_mul_ps(two_n, p), _mm256_sub_ps(two_n, _mm256_set1_ps(1.f)));
+}
+
+
+/**
+ * @brief tanh(x/2) of eight floats
+ */
+TARGET_AVX2 static inline __m256 avx2_tanh_half_ps(const __m256 x) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.f);
+    const __m256 em = avx2_expm1_neg_ps(_mm256_or_ps(x, sign_mask));
+    const __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_setzero_ps(), em),
+                                   _mm256_add_ps(_mm256_set1_ps(2.f), em));
+    return _mm256_or_ps(t, _mm256_and_ps(x, sign_mask));
+}
+
+
+/**
+ * @brief natural log of eight floats, same special values as avx2_log
+ */
+TARGET_AVX2 static inline __m256 avx2_log_ps(const __m256 x) {
+    const __m256i bits = _mm256_castps_si256(x);
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                   _mm256_set1_epi32(0x3F800000)));
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+
+    // move m into [sqrt(1/2), sqrt(2))
+    const __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+    e = _mm256_blendv_ps(e, _mm256_add_ps(e, _mm256_set1_ps(1.f)), big);
+
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 s = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+    const __m256 s2 = _mm256_mul_ps(s, s);
+    __m256 q = _mm256_set1_ps(log_coeffs_f[5]);
+    for (int k = 4; k >= 0; --k) {
+        q = _mm256_add_ps(_mm256_mul_ps(q, s2), _mm256_set1_ps(log_coeffs_f[k]));
+    }
+    const __m256 log_m = _mm256_mul_ps(_mm256_add_ps(s, s), q);
+    __m256 res = _mm256_add_ps(_mm256_mul_ps(e, _mm256_set1_ps(ln2_hi_f)),
+                               _mm256_add_ps(log_m, _mm256_mul_ps(e, _mm256_set1_ps(ln2_lo_f))));
+
+    // special values
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 inf = _mm256_set1_ps(HUGE_VALF);
+    res = _mm256_blendv_ps(res, inf, _mm256_cmp_ps(x, inf, _CMP_EQ_OQ));
+    res = _mm256_blendv_ps(res, _mm256_sub_ps(zero, inf), _mm256_cmp_ps(x, zero, _CMP_EQ_OQ));
+    res = _mm256_blendv_ps(res, _mm256_set1_ps(NAN), _mm256_cmp_ps(x, zero, _CMP_NGE_UQ));
+    return res;
+}
+
+
+/**
+ * @brief lane mask selecting the first n (< 8) of eight floats
+ */
+TARGET_AVX2 static inline __m256i avx2_tail_mask_ps(const uint32_t n) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(n)), lanes);
+}
+
+
+template<typename Index>
+TARGET_AVX2 static void check_node_update_avx2(vector<float> &msg_c,
+                                               const vector<float> &msg_v,
+                                               const vector<bool> &syndrome,
+                                               const TannerGraph &graph,
+                                               float *scratch,
+                                               const Index *c2v) {
+    const float *mv = msg_v.data();
+    float *mc = msg_c.data();
+    const __m256 one = _mm256_set1_ps(1.f);
+    alignas(32) float lanes[8];
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+        const uint32_t deg = end - begin;
+
+        // tanh of every incoming message, kept in scratch for the second pass
+        __m256 prod = one;
+        for (uint32_t k = 0; k < deg; k += 8) {
+            const __m256i mask = avx2_tail_mask_ps(deg - k);
+            const __m256 t = avx2_tanh_half_ps(_mm256_maskload_ps(mv + begin + k, mask));
+            _mm256_maskstore_ps(scratch + k, mask, t);
+            prod = _mm256_mul_ps(prod, _mm256_blendv_ps(one, t, _mm256_castsi256_ps(mask)));
+        }
+        _mm256_store_ps(lanes, prod);
+        float mc_prod = 1 - 2 * static_cast<float>(syndrome[m]);
+        for (int i = 0; i < 8; ++i) {
+            mc_prod *= lanes[i];
+        }
+
+        // same convention as the scalar kernel for zero messages
+        const __m256 zero_msg_part = _mm256_set1_ps(deg > 1 ? 0.f : 1.f);
+        for (uint32_t k = 0; k < deg; k += 8) {
+            const uint32_t n = min(deg - k, 8u);
+            const __m256i mask = avx2_tail_mask_ps(n);
+            const __m256 x = _mm256_maskload_ps(mv + begin + k, mask);
+            const __m256 t = _mm256_maskload_ps(scratch + k, mask);
+            __m256 msg_part = _mm256_div_ps(_mm256_set1_ps(mc_prod), t);
+            msg_part = _mm256_blendv_ps(msg_part, zero_msg_part,
+                                        _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+            const __m256 res = avx2_log_ps(_mm256_div_ps(_mm256_add_ps(one, msg_part),
+                                                         _mm256_sub_ps(one, msg_part)));
+            _mm256_store_ps(lanes, res);
+            for (uint32_t i = 0; i < n; ++i) {
+                mc[c2v[begin + k + i]] = lanes[i];
+            }
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX2 static void check_node_update_min_sum_avx2(vector<float> &msg_c,
+                                                       const vector<float> &msg_v,
+                                                       const vector<bool> &syndrome,
+                                                       const TannerGraph &graph,
+                                                       const float scale,
+                                                       const float offset,
+                                                       const Index *c2v) {
+    const float *mv = msg_v.data();
+    float *mc = msg_c.data();
+    const __m256 sign_mask = _mm256_set1_ps(-0.f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 inf = _mm256_set1_ps(HUGE_VALF);
+    alignas(32) float lane1[8], lane2[8];
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
+        // per lane two smallest magnitudes and the sign parity
+        __m256 vmin1 = inf;
+        __m256 vmin2 = inf;
+        int parity = syndrome[m];
+        for (uint32_t e = begin; e < end; e += 8) {
+            const __m256i mask = avx2_tail_mask_ps(min(end - e, 8u));
+            const __m256 x = _mm256_maskload_ps(mv + e, mask);
+            const __m256 mag = _mm256_blendv_ps(inf, _mm256_andnot_ps(sign_mask, x), _mm256_castsi256_ps(mask));
+            parity ^= __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ))) & 1;
+            vmin2 = _mm256_min_ps(vmin2, _mm256_max_ps(vmin1, mag));
+            vmin1 = _mm256_min_ps(vmin1, mag);
+        }
+        _mm256_store_ps(lane1, vmin1);
+        _mm256_store_ps(lane2, vmin2);
+        float min1, min2;
+        merge_lane_minima(lane1, lane2, 8, min1, min2);
+
+        // the edge holding the minimum gets min2, ties give min1 == min2 anyway
+        const __m256 out1 = _mm256_set1_ps(min_sum_magnitude(min1, scale, offset));
+        const __m256 out2 = _mm256_set1_ps(min_sum_magnitude(min2, scale, offset));
+        const __m256 vmin = _mm256_set1_ps(min1);
+        const __m256 parity_sign = parity ? sign_mask : zero;
+        for (uint32_t e = begin; e < end; e += 8) {
+            const uint32_t n = min(end - e, 8u);
+            const __m256 x = _mm256_maskload_ps(mv + e, avx2_tail_mask_ps(n));
+            const __m256 mag = _mm256_andnot_ps(sign_mask, x);
+            const __m256 sel = _mm256_blendv_ps(out1, out2, _mm256_cmp_ps(mag, vmin, _CMP_EQ_OQ));
+            const __m256 sign = _mm256_xor_ps(parity_sign,
+                                              _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), sign_mask));
+            _mm256_store_ps(lane1, _mm256_xor_ps(sel, sign));
+            for (uint32_t i = 0; i < n; ++i) {
+                mc[c2v[e + i]] = lane1[i];
+            }
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX2 static void var_node_update_avx2(vector<float> &msg_v,
+                                             const vector<float> &msg_c,
+                                             const vector<float> &llrs,
+                                             const TannerGraph &graph,
+                                             const Index *v2c) {
+    float *mv = msg_v.data();
+    const float *mc = msg_c.data();
+    const uint32_t *offsets = graph.var_offsets.data();
+    const size_t n_cols = llrs.size();
+    alignas(32) float lanes[8];
+
+    size_t v = 0;
+    for (; v + 8 <= n_cols; v += 8) {
+        const __m256i begin = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets + v));
+        const __m256i deg = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets + v + 1)),
+                                             begin);
+        uint32_t max_deg = 0;
+        for (int i = 0; i < 8; ++i) {
+            max_deg = max(max_deg, offsets[v + i + 1] - offsets[v + i]);
+        }
+
+        // lane i adds up the messages of variable v + i, in the scalar order
+        __m256 sum = _mm256_loadu_ps(llrs.data() + v);
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m256i kk = _mm256_set1_epi32(static_cast<int>(k));
+            const __m256 mask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(deg, kk));
+            const __m256 c = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), mc, _mm256_add_epi32(begin, kk), mask, 4);
+            sum = _mm256_blendv_ps(sum, _mm256_add_ps(sum, c), mask);
+        }
+
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m256i kk = _mm256_set1_epi32(static_cast<int>(k));
+            const __m256 mask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(deg, kk));
+            const __m256 c = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), mc, _mm256_add_epi32(begin, kk), mask, 4);
+            _mm256_store_ps(lanes, _mm256_sub_ps(sum, c));
+            for (int i = 0; i < 8; ++i) {
+                const uint32_t e = offsets[v + i] + k;
+                if (e < offsets[v + i + 1]) {
+                    mv[v2c[e]] = lanes[i];
+                }
+            }
+        }
+    }
+
+    // remaining variable nodes
+    for (; v < n_cols; ++v) {
+        float mv_sum = llrs[v];
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+            mv_sum += mc[e];
+        }
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+            mv[v2c[e]] = mv_sum - mc[e];
+        }
+    }
+}
+
+
+/**
+ * @brief lane mask selecting the first n (<= 16) of sixteen floats
+ */
+static inline __mmask16 avx512_tail_mask_ps(const uint32_t n) {
+    return n >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << n) - 1);
+}
+
+
+/**
+ * @brief expm1 of sixteen non-positive floats
+ */
+TARGET_AVX512 static inline __m512 avx512_expm1_neg_ps(__m512 y) {
+    y = _mm512_max_ps(y, _mm512_set1_ps(-87.f));
+    const __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(y, _mm512_set1_ps(static_cast<float>(log2_e))),
+                                          _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_sub_ps(y, _mm512_mul_ps(n, _mm512_set1_ps(ln2_hi_f)));
+    r = _mm512_sub_ps(r, _mm512_mul_ps(n, _mm512_set1_ps(ln2_lo_f)));
+
+    __m512 q = _mm512_set1_ps(expm1_coeffs_f[6]);
+    for (int k = 5; k >= 0; --k) {
+        q = _mm512_add_ps(_mm512_mul_ps(q, r), _mm512_set1_ps(expm1_coeffs_f[k]));
+    }
+    const __m512 p = _mm512_mul_ps(q, r);
+
+    const __m512 two_n = _mm512_scalef_ps(_mm512_set1_ps(1.f), n);
+    return _mm512_add_ps(_mm512_scalef_ps(p, n), _mm512_sub_ps(two_n, _mm512_set1_ps(1.f)));
+}
+
+
+/**
+ * @brief tanh(x/2) of sixteen floats
+ */
+TARGET_AVX512 static inline __m512 avx512_tanh_half_ps(const __m512 x) {
+    const __m512i sign_mask = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+    const __m512i x_bits = _mm512_castps_si512(x);
+    const __m512 em = avx512_expm1_neg_ps(_mm512_castsi512_ps(_mm512_or_si512(x_bits, sign_mask)));
+    const __m512 t = _mm512_div_ps(_mm512_sub_ps(_mm512_setzero_ps(), em),
+                                   _mm512_add_ps(_mm512_set1_ps(2.f), em));
+    return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(t), _mm512_and_si512(x_bits, sign_mask)));
+}
+
+
+/**
+ * @brief natural log of sixteen floats, same special values as avx512_log
+ */
+TARGET_AVX512 static inline __m512 avx512_log_ps(const __m512 x) {
+    const __m512 m = _mm512_getmant_ps(x, _MM_MANT_NORM_p75_1p5, _MM_MANT_SIGN_zero);
+    __m512 e = _mm512_getexp_ps(x);
+    e = _mm512_mask_add_ps(e, _mm512_cmp_ps_mask(m, _mm512_set1_ps(1.f), _CMP_LT_OQ), e, _mm512_set1_ps(1.f));
+
+    const __m512 one = _mm512_set1_ps(1.f);
+    const __m512 s = _mm512_div_ps(_mm512_sub_ps(m, one), _mm512_add_ps(m, one));
+    const __m512 s2 = _mm512_mul_ps(s, s);
+    __m512 q = _mm512_set1_ps(log_coeffs_f[5]);
+    for (int k = 4; k >= 0; --k) {
+        q = _mm512_add_ps(_mm512_mul_ps(q, s2), _mm512_set1_ps(log_coeffs_f[k]));
+    }
+    const __m512 log_m = _mm512_mul_ps(_mm512_add_ps(s, s), q);
+    __m512 res = _mm512_add_ps(_mm512_mul_ps(e, _mm512_set1_ps(ln2_hi_f)),
+                               _mm512_add_ps(log_m, _mm512_mul_ps(e, _mm512_set1_ps(ln2_lo_f))));
+
+    // special values
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 inf = _mm512_set1_ps(HUGE_VALF);
+    res = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, inf, _CMP_EQ_OQ), res, inf);
+    res = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, zero, _CMP_EQ_OQ), res, _mm512_sub_ps(zero, inf));
+    res = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, zero, _CMP_NGE_UQ), res, _mm512_set1_ps(NAN));
+    return res;
+}
+
+
+template<typename Index>
+TARGET_AVX512 static void check_node_update_avx512(vector<float> &msg_c,
+                                                   const vector<float> &msg_v,
+                                                   const vector<bool> &syndrome,
+                                                   const TannerGraph &graph,
+                                                   float *scratch,
+                                                   const Index *c2v) {
+    const float *mv = msg_v.data();
+    float *mc = msg_c.data();
+    const __m512 one = _mm512_set1_ps(1.f);
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+        const uint32_t deg = end - begin;
+
+        // tanh of every incoming message, kept in scratch for the second pass
+        __m512 prod = one;
+        for (uint32_t k = 0; k < deg; k += 16) {
+            const __mmask16 mask = avx512_tail_mask_ps(deg - k);
+            const __m512 t = avx512_tanh_half_ps(_mm512_maskz_loadu_ps(mask, mv + begin + k));
+            _mm512_mask_storeu_ps(scratch + k, mask, t);
+            prod = _mm512_mask_mul_ps(prod, mask, prod, t);
+        }
+        const float mc_prod = (1 - 2 * static_cast<float>(syndrome[m])) * _mm512_reduce_mul_ps(prod);
+
+        // same convention as the scalar kernel for zero messages
+        const __m512 zero_msg_part = _mm512_set1_ps(deg > 1 ? 0.f : 1.f);
+        for (uint32_t k = 0; k < deg; k += 16) {
+            const __mmask16 mask = avx512_tail_mask_ps(deg - k);
+            const __m512 x = _mm512_maskz_loadu_ps(mask, mv + begin + k);
+            const __m512 t = _mm512_mask_loadu_ps(one, mask, scratch + k);
+            __m512 msg_part = _mm512_div_ps(_mm512_set1_ps(mc_prod), t);
+            msg_part = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_EQ_OQ),
+                                            msg_part, zero_msg_part);
+            const __m512 res = avx512_log_ps(_mm512_div_ps(_mm512_add_ps(one, msg_part),
+                                                           _mm512_sub_ps(one, msg_part)));
+            _mm512_mask_i32scatter_ps(mc, mask, avx512_load_index16(mask, c2v + begin + k), res, 4);
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX512 static void check_node_update_min_sum_avx512(vector<float> &msg_c,
+                                                           const vector<float> &msg_v,
+                                                           const vector<bool> &syndrome,
+                                                           const TannerGraph &graph,
+                                                           const float scale,
+                                                           const float offset,
+                                                           const Index *c2v) {
+    const float *mv = msg_v.data();
+    float *mc = msg_c.data();
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 inf = _mm512_set1_ps(HUGE_VALF);
+    const __m512i sign_mask = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+    alignas(64) float lane1[16], lane2[16];
+
+    for (size_t m{}; m < graph.n_rows; ++m) {
+        const uint32_t begin = graph.check_offsets[m];
+        const uint32_t end = graph.check_offsets[m + 1];
+
+        // per lane two smallest magnitudes and the sign parity
+        __m512 vmin1 = inf;
+        __m512 vmin2 = inf;
+        int parity = syndrome[m];
+        for (uint32_t e = begin; e < end; e += 16) {
+            const __mmask16 mask = avx512_tail_mask_ps(end - e);
+            const __m512 x = _mm512_maskz_loadu_ps(mask, mv + e);
+            const __m512 mag = _mm512_mask_abs_ps(inf, mask, x);
+            parity ^= __builtin_popcount(_mm512_cmp_ps_mask(x, zero, _CMP_LT_OQ)) & 1;
+            vmin2 = _mm512_min_ps(vmin2, _mm512_max_ps(vmin1, mag));
+            vmin1 = _mm512_min_ps(vmin1, mag);
+        }
+        _mm512_store_ps(lane1, vmin1);
+        _mm512_store_ps(lane2, vmin2);
+        float min1, min2;
+        merge_lane_minima(lane1, lane2, 16, min1, min2);
+
+        // the edge holding the minimum gets min2, ties give min1 == min2 anyway
+        const __m512 out1 = _mm512_set1_ps(min_sum_magnitude(min1, scale, offset));
+        const __m512 out2 = _mm512_set1_ps(min_sum_magnitude(min2, scale, offset));
+        const __m512 vmin = _mm512_set1_ps(min1);
+        const __m512i parity_sign = parity ? sign_mask : _mm512_setzero_si512();
+        for (uint32_t e = begin; e < end; e += 16) {
+            const __mmask16 mask = avx512_tail_mask_ps(end - e);
+            const __m512 x = _mm512_maskz_loadu_ps(mask, mv + e);
+            const __m512 sel = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(_mm512_abs_ps(x), vmin, _CMP_EQ_OQ),
+                                                    out1, out2);
+            const __m512i sign = _mm512_mask_xor_epi32(parity_sign, _mm512_cmp_ps_mask(x, zero, _CMP_LT_OQ),
+                                                       parity_sign, sign_mask);
+            const __m512 res = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(sel), sign));
+            _mm512_mask_i32scatter_ps(mc, mask, avx512_load_index16(mask, c2v + e), res, 4);
+        }
+    }
+}
+
+
+template<typename Index>
+TARGET_AVX512 static void var_node_update_avx512(vector<float> &msg_v,
+                                                 const vector<float> &msg_c,
+                                                 const vector<float> &llrs,
+                                                 const TannerGraph &graph,
+                                                 const Index *v2c) {
+    float *mv = msg_v.data();
+    const float *mc = msg_c.data();
+    const uint32_t *offsets = graph.var_offsets.data();
+    const size_t n_cols = llrs.size();
+
+    for (size_t v = 0; v < n_cols; v += 16) {
+        const __mmask16 lanes = avx512_tail_mask_ps(static_cast<uint32_t>(min<size_t>(n_cols - v, 16)));
+        const __m512i begin = _mm512_maskz_loadu_epi32(lanes, offsets + v);
+        const __m512i deg = _mm512_sub_epi32(_mm512_maskz_loadu_epi32(lanes, offsets + v + 1), begin);
+        const uint32_t max_deg = static_cast<uint32_t>(_mm512_reduce_max_epi32(deg));
+
+        // lane i adds up the messages of variable v + i, in the scalar order
+        __m512 sum = _mm512_maskz_loadu_ps(lanes, llrs.data() + v);
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m512i kk = _mm512_set1_epi32(static_cast<int>(k));
+            const __mmask16 mask = _mm512_cmpgt_epi32_mask(deg, kk);
+            const __m512 c = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, _mm512_add_epi32(begin, kk), mc, 4);
+            sum = _mm512_mask_add_ps(sum, mask, sum, c);
+        }
+
+        for (uint32_t k = 0; k < max_deg; ++k) {
+            const __m512i kk = _mm512_set1_epi32(static_cast<int>(k));
+            const __mmask16 mask = _mm512_cmpgt_epi32_mask(deg, kk);
+            const __m512i idx = _mm512_add_epi32(begin, kk);
+            const __m512 c = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, idx, mc, 4);
+            const __m512i target = avx512_gather_index(mask, idx, v2c);
+            _mm512_mask_i32scatter_ps(mv, mask, target, _mm512_sub_ps(sum, c), 4);
+        }
+    }
+}
+
+#endif /* ifdef SIMD_KERNELS_X86 */
+
+
+//----------------------------------------------------------------------
+// Dispatch
+//----------------------------------------------------------------------
+
+/**
+ * @brief detects the best instruction set supported by the CPU (and the OS)
+ * @return SimdLevel::avx512, SimdLevel::avx2 or SimdLevel::scalar
+ */
+SimdLevel detect_simd_level() {
+#ifdef SIMD_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::avx2;
+    }
+#endif
+    return SimdLevel::scalar;
+}
+
+
+/**
+ * @brief turns a requested level into the one the kernels will run with
+ * @param requested the requested level, SimdLevel::automatic picks the detected one
+ * @return the level to use, never SimdLevel::automatic
+ */
+SimdLevel resolve_simd_level(const SimdLevel requested) {
+    static const SimdLevel detected = detect_simd_level();
+    if (requested == SimdLevel::automatic) {
+        return detected;
+    }
+    if (static_cast<int>(requested) > static_cast<int>(detected)) {
+        throw runtime_error(string("SIMD level ") + simd_level_name(requested) + " is not supported by this CPU.");
+    }
+    return requested;
+}
+
+
+/**
+ * @brief name of a level, for printing
+ * @param level the level
+ * @return the name
+ */
+const char *simd_level_name(const SimdLevel level) {
+    switch (level) {
+        case SimdLevel::automatic: return "automatic";
+        case SimdLevel::scalar: return "scalar";
+        case SimdLevel::avx2: return "avx2";
+        case SimdLevel::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+
+/**
+ * @brief sum-product check node update, vectorized over the edges of each check node
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scratch scratch buffer, grown to the largest check node degree if needed
+ * @param level instruction set to use
+ */
+void check_node_update_simd(vector<double> &msg_c,
+                            const vector<double> &msg_v,
+                            const vector<bool> &syndrome,
+                            const TannerGraph &graph,
+                            vector<double> &scratch,
+                            const SimdLevel level) {
+#ifdef SIMD_KERNELS_X86
+    if (level == SimdLevel::avx2 || level == SimdLevel::avx512) {
+        uint32_t max_deg = 0;
+        for (size_t m{}; m < graph.n_rows; ++m) {
+            max_deg = max(max_deg, graph.check_offsets[m + 1] - graph.check_offsets[m]);
+        }
+        if (scratch.size() < max_deg) {
+            scratch.resize(max_deg);
+        }
+        if (level == SimdLevel::avx512) {
+            with_edge_index(graph, [&](const auto *c2v, const auto *) {
+                check_node_update_avx512(msg_c, msg_v, syndrome, graph, scratch.data(), c2v);
+            });
+        } else {
+            with_edge_index(graph, [&](const auto *c2v, const auto *) {
+                check_node_update_avx2(msg_c, msg_v, syndrome, graph, scratch.data(), c2v);
+            });
+        }
+        return;
+    }
+#endif
+    check_node_update(msg_c, msg_v, syndrome, graph);
+}
+
+
+/**
+ * @brief min-sum check node update, vectorized over the edges of each check node
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ * @param level instruction set to use
+ */
+void check_node_update_min_sum_simd(vector<double> &msg_c,
+                                    const vector<double> &msg_v,
+                                    const vector<bool> &syndrome,
+                                    const TannerGraph &graph,
+                                    const double scale,
+                                    const double offset,
+                                    const SimdLevel level) {
+#ifdef SIMD_KERNELS_X86
+    if (level == SimdLevel::avx512) {
+        with_edge_index(graph, [&](const auto *c2v, const auto *) {
+            check_node_update_min_sum_avx512(msg_c, msg_v, syndrome, graph, scale, offset, c2v);
+        });
+        return;
+    }
+    if (level == SimdLevel::avx2) {
+        with_edge_index(graph, [&](const auto *c2v, const auto *) {
+            check_node_update_min_sum_avx2(msg_c, msg_v, syndrome, graph, scale, offset, c2v);
+        });
+        return;
+    }
+#endif
+    check_node_update_min_sum(msg_c, msg_v, syndrome, graph, scale, offset);
+}
+
+
+/**
+ * @brief variable node update, vectorized over groups of variable nodes (one per lane)
+ * @param msg_v the array containing the variable messages, check order
+ * @param msg_c the array containing the check messages, variable order
+ * @param llrs intial log likelihood ratios
+ * @param graph flat Tanner graph of H
+ * @param level instruction set to use
+ */
+void var_node_update_simd(vector<double> &msg_v,
+                          const vector<double> &msg_c,
+                          const vector<double> &llrs,
+                          const TannerGraph &graph,
+                          const SimdLevel level) {
+#ifdef SIMD_KERNELS_X86
+    if (level == SimdLevel::avx512) {
+        with_edge_index(graph, [&](const auto *, const auto *v2c) {
+            var_node_update_avx512(msg_v, msg_c, llrs, graph, v2c);
+        });
+        return;
+    }
+    if (level == SimdLevel::avx2) {
+        with_edge_index(graph, [&](const auto *, const auto *v2c) {
+            var_node_update_avx2(msg_v, msg_c, llrs, graph, v2c);
+        });
+        return;
+    }
+#endif
+    var_node_update(msg_v, msg_c, llrs, graph);
+}
+
+
+/**
+ * @brief sum-product check node update on float messages
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scratch scratch buffer, grown to the largest check node degree if needed
+ * @param level instruction set to use
+ */
+void check_node_update_simd(vector<float> &msg_c,
+                            const vector<float> &msg_v,
+                            const vector<bool> &syndrome,
+                            const TannerGraph &graph,
+                            vector<float> &scratch,
+                            const SimdLevel level) {
+#ifdef SIMD_KERNELS_X86
+    if (level == SimdLevel::avx2 || level == SimdLevel::avx512) {
+        uint32_t max_deg = 0;
+        for (size_t m{}; m < graph.n_rows; ++m) {
+            max_deg = max(max_deg, graph.check_offsets[m + 1] - graph.check_offsets[m]);
+        }
+        if (scratch.size() < max_deg) {
+            scratch.resize(max_deg);
+        }
+        if (level == SimdLevel::avx512) {
+            with_edge_index(graph, [&](const auto *c2v, const auto *) {
+                check_node_update_avx512(msg_c, msg_v, syndrome, graph, scratch.data(), c2v);
+            });
+        } else {
+            with_edge_index(graph, [&](const auto *c2v, const auto *) {
+                check_node_update_avx2(msg_c, msg_v, syndrome, graph, scratch.data(), c2v);
+            });
+        }
+        return;
+    }
+#endif
+    check_node_update(msg_c, msg_v, syndrome, graph);
+}
+
+
+/**
+ * @brief min-sum check node update on float messages
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ * @param level instruction set to use
+ */
+void check_node_update_min_sum_simd(vector<float> &msg_c,
+                                    const vector<float> &msg_v,
+                                    const vector<bool> &syndrome,
+                                    const TannerGraph &graph,
+                                    const double scale,
+                                    const double offset,
+                                    const SimdLevel level) {
+#ifdef SIMD_KERNELS_X86
+    if (level == SimdLevel::avx512) {
+        with_edge_index(graph, [&](const auto *c2v, const auto *) {
+            check_node_update_min_sum_avx512(msg_c, msg_v, syndrome, graph, float(scale), float(offset), c2v);
+        });
+        return;
+    }
+    if (level == SimdLevel::avx2) {
+        with_edge_index(graph, [&](const auto *c2v, const auto *) {
+            check_node_update_min_sum_avx2(msg_c, msg_v, syndrome, graph, float(scale), float(offset), c2v);
+        });
+        return;
+    }
+#endif
+    check_node_update_min_sum(msg_c, msg_v, syndrome, graph, scale, offset);
+}
+
+
+/**
+ * @brief variable node update on float messages
+ * @param msg_v the array containing the variable messages, check order
+ * @param msg_c the array containing the check messages, variable order
+ * @param llrs intial log likelihood ratios
+ * @param graph flat Tanner graph of H
+ * @param level instruction set to use
+ */
+void var_node_update_simd(vector<float> &msg_v,
+                          const vector<float> &msg_c,
+                          const vector<float> &llrs,
+                          const TannerGraph &graph,
+                          const SimdLevel level) {
+#ifdef SIMD_KERNELS_X86
+    if (level == SimdLevel::avx512) {
+        with_edge_index(graph, [&](const auto *, const auto *v2c) {
+            var_node_update_avx512(msg_v, msg_c, llrs, graph, v2c);
+        });
+        return;
+    }
+    if (level == SimdLevel::avx2) {
+        with_edge_index(graph, [&](const auto *, const auto *v2c) {
+            var_node_update_avx2(msg_v, msg_c, llrs, graph, v2c);
+        });
+        return;
+    }
+#endif
+    var_node_update(msg_v, msg_c, llrs, graph);
+}
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Vectorized (AVX2/AVX-512) versions of the check and variable node update steps.
+The instruction set is picked at runtime, CPUs without AVX2 use the scalar
+kernels of encoding_decoding.cpp.
+*/
+
+
+#ifndef INFORMATION_THEORY_SIMD_KERNELS_H
+#define INFORMATION_THEORY_SIMD_KERNELS_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include "encoding_decoding.h"
+
+using namespace std;
+
+
+/**
+ * @brief detects the best instruction set supported by the CPU (and the OS)
+ * @return SimdLevel::avx512, SimdLevel::avx2 or SimdLevel::scalar
+ */
+SimdLevel detect_simd_level();
+
+
+/**
+ * @brief turns a requested level into the one the kernels will run with
+ * @param requested the requested level, SimdLevel::automatic picks the detected one
+ * @return the level to use, never SimdLevel::automatic
+ */
+SimdLevel resolve_simd_level(SimdLevel requested);
+
+
+/**
+ * @brief name of a level, for printing
+ * @param level the level
+ * @return the name
+ */
+const char *simd_level_name(SimdLevel level);
+
+
+/**
+ * @brief sum-product check node update, vectorized over the edges of each check node
+ *
+ * Uses polynomial exp/log approximations, so the result matches check_node_update
+ * to within a few ulp but not bit for bit.
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scratch scratch buffer, grown to the largest check node degree if needed
+ * @param level instruction set to use
+ */
+void check_node_update_simd(vector<double> &msg_c,
+                            const vector<double> &msg_v,
+                            const vector<bool> &syndrome,
+                            const TannerGraph &graph,
+                            vector<double> &scratch,
+                            SimdLevel level);
+
+
+/**
+ * @brief sum-product check node update on float messages, twice the lanes of the
+ * double kernel with exp/log approximations accurate to float precision
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scratch scratch buffer, grown to the largest check node degree if needed
+ * @param level instruction set to use
+ */
+void check_node_update_simd(vector<float> &msg_c,
+                            const vector<float> &msg_v,
+                            const vector<bool> &syndrome,
+                            const TannerGraph &graph,
+                            vector<float> &scratch,
+                            SimdLevel level);
+
+
+/**
+ * @brief min-sum check node update, vectorized over the edges of each check node
+ *
+ * Bit-for-bit identical to check_node_update_min_sum.
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ * @param level instruction set to use
+ */
+void check_node_update_min_sum_simd(vector<double> &msg_c,
+                                    const vector<double> &msg_v,
+                                    const vector<bool> &syndrome,
+                                    const TannerGraph &graph,
+                                    double scale,
+                                    double offset,
+                                    SimdLevel level);
+
+
+/**
+ * @brief min-sum check node update on float messages, bit-for-bit identical to
+ * check_node_update_min_sum<float>
+ * @param msg_c the array containing the check messages, variable order
+ * @param msg_v the array containing the variable messages, check order
+ * @param syndrome the syndrome of the codeword
+ * @param graph flat Tanner graph of H
+ * @param scale scaling factor applied to the magnitude
+ * @param offset offset subtracted from the scaled magnitude
+ * @param level instruction set to use
+ */
+void check_node_update_min_sum_simd(vector<float> &msg_c,
+                                    const vector<float> &msg_v,
+                                    const vector<bool> &syndrome,
+                                    const TannerGraph &graph,
+                                    double scale,
+                                    double offset,
+                                    SimdLevel level);
+
+
+/**
+ * @brief variable node update, vectorized over groups of variable nodes (one per lane)
+ *
+ * Every lane adds up its messages in the same order as var_node_update, so the
+ * result is bit-for-bit identical.
+ * @param msg_v the array containing the variable messages, check order
+ * @param msg_c the array containing the check messages, variable order
+ * @param llrs intial log likelihood ratios
+ * @param graph flat Tanner graph of H
+ * @param level instruction set to use
+ */
+void var_node_update_simd(vector<double> &msg_v,
+                          const vector<double> &msg_c,
+                          const vector<double> &llrs,
+                          const TannerGraph &graph,
+                          SimdLevel level);
+
+
+/**
+ * @brief variable node update on float messages, bit-for-bit identical to
+ * var_node_update<float>
+ * @param msg_v the array containing the variable messages, check order
+ * @param msg_c the array containing the check messages, variable order
+ * @param llrs intial log likelihood ratios
+ * @param graph flat Tanner graph of H
+ * @param level instruction set to use
+ */
+void var_node_update_simd(vector<float> &msg_v,
+                          const vector<float> &msg_c,
+                          const vector<float> &llrs,
+                          const TannerGraph &graph,
+                          SimdLevel level);
+
+#endif //INFORMATION_THEORY_SIMD_KERNELS_H
@@ -33,6 +33,7 @@ This file just contains a bunch of utility functions for the simulation
 #include <random>
 #include <tuple>
 #include "simulation_utils.h"
+#include "bsc_channel.h"
 
 using namespace std;
 
@@ -58,18 +59,11 @@ using namespace std;
  * @return The vector with the bit flip applied
  */
 vector<bool> bit_flip_channel(vector<bool> in, double p) {
-    srand(time(NULL));
-    vector<bool> out = in;
-
-    random_device rd;
-    mt19937 gen(rd());
-    bernoulli_distribution d(p);
-    for (size_t i = 0; i<in.size(); i++) {
-        if (d(gen)) {
-            out[i] = !out[i];
-        }
-    }
-    return out;
+    // one generator per thread, seeded once, see bsc_channel.h
+    thread_local BscChannel channel = make_bsc_channel(0, random_device{}());
+    set_crossover_probability(channel, p);
+    apply_bsc(channel, in);
+    return in;
 }
 
 /**
@@ -79,22 +73,12 @@ vector<bool> bit_flip_channel(vector<bool> in, double p) {
  * @return The vector with the bit flip applied
  */
 vector<bool> bit_flip_channel_det(vector<bool> &in, int number_of_errors) {
+    // one generator per thread, seeded once, see fixed_weight_errors
+    thread_local mt19937_64 gen(random_device{}());
+    thread_local PackedFrame errors;
     vector<bool> out = in;
-    vector<int> used_idx = vector<int>(number_of_errors, -1);
-    srand(time(NULL));
-    // go over the number of required flips
-    for (size_t i = 0; i<number_of_errors; i++){
-
-        // random index
-        size_t index = rand() % in.size();
-        // if this index flipped already, resample until it is not flipped
-        while (find(used_idx.begin(), used_idx.end(), index) != used_idx.end()){
-            index = rand() % in.size();
-        }
-        // append flipped to list of flipped
-        used_idx[i] = index;
-        out[index] = !out[index];
-    }
+    fixed_weight_errors(in.size(), static_cast<size_t>(number_of_errors), gen, errors);
+    apply_errors(errors, out);
     return out;
 }
 
@@ -181,3 +165,35 @@ vector<bool> random_input(const int size){
     return vec;
 }
 
+
+/**
+ * @brief derives the seed of an independent random stream from a master seed
+ * @param seed master seed
+ * @param a first stream coordinate, e.g. the sweep point
+ * @param b second stream coordinate, e.g. the chunk of frames
+ * @return seed of the stream
+ */
+uint64_t stream_seed(uint64_t seed, uint64_t a, uint64_t b) {
+    auto splitmix64 = [](uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    };
+    return splitmix64(splitmix64(splitmix64(seed) ^ a) ^ b);
+}
+
+
+/**
+ * @brief fills a vector of bools with random bits from the given generator
+ * @param out the vector to fill, its size is kept
+ * @param gen random number generator
+ */
+void random_input(vector<bool> &out, mt19937_64 &gen) {
+    for (size_t i = 0; i < out.size(); i += 64) {
+        uint64_t bits = gen();
+        for (size_t j = i; j < min(i + 64, out.size()); j++, bits >>= 1) {
+            out[j] = bits & 1;
+        }
+    }
+}
@@ -25,6 +25,8 @@ This file just contains a bunch of utility functions for the simulation
 
 
 #include <vector>
+#include <cstdint>
+#include <random>
 
 
 /**
@@ -93,5 +95,23 @@ int number_of_diff_vector_elements(std::vector<bool> const &input1, std::vector<
 std::vector<bool> random_input(const int size);
 
 
+/**
+ * @brief derives the seed of an independent random stream from a master seed
+ *
+ * Mixes the master seed and the stream coordinates with splitmix64, so every
+ * (seed, a, b) gives a different, well spread seed no matter in which order or on
+ * which thread the streams are created.
+ * @param seed master seed
+ * @param a first stream coordinate, e.g. the sweep point
+ * @param b second stream coordinate, e.g. the chunk of frames
+ * @return seed of the stream
+ */
+uint64_t stream_seed(uint64_t seed, uint64_t a, uint64_t b);
 
 
+/**
+ * @brief fills a vector of bools with random bits from the given generator
+ * @param out the vector to fill, its size is kept
+ * @param gen random number generator
+ */
+void random_input(std::vector<bool> &out, std::mt19937_64 &gen);
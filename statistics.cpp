@@ -0,0 +1,250 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Small statistics helpers for the simulations.
+*/
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "statistics.h"
+
+using namespace std;
+
+
+/**
+ * @brief probability of exactly k successes out of n trials with success probability p
+ * @param n number of trials
+ * @param k number of successes
+ * @param p success probability
+ * @return the binomial probability, computed in the log domain
+ */
+double binomial_pmf(const size_t n, const size_t k, const double p) {
+    if (k > n) {
+        return 0;
+    }
+    if (p <= 0 || p >= 1) {
+        return (p <= 0 ? k == 0 : k == n) ? 1 : 0;
+    }
+    const double dn = static_cast<double>(n);
+    const double dk = static_cast<double>(k);
+    return exp(lgamma(dn + 1) - lgamma(dk + 1) - lgamma(dn - dk + 1) + dk * log(p) + (dn - dk) * log1p(-p));
+}
+
+
+/**
+ * @brief quantile function of the standard normal distribution
+ *
+ * Rational approximation of P. J. Acklam, polished with one Halley step on erfc.
+ * @param q probability in (0, 1)
+ * @return x with P(X <= x) = q
+ */
+double normal_quantile(const double q) {
+    if (!(q > 0 && q < 1)) {
+        throw runtime_error("normal quantile of " + to_string(q) + " is not defined.");
+    }
+    static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                3.754408661907416e+00};
+    const double q_low = 0.02425;
+
+    double x;
+    if (q < q_low || q > 1 - q_low) {
+        // tails
+        const double t = sqrt(-2 * log(q < q_low ? q : 1 - q));
+        x = (((((c[0] * t + c[1]) * t + c[2]) * t + c[3]) * t + c[4]) * t + c[5])
+            / ((((d[0] * t + d[1]) * t + d[2]) * t + d[3]) * t + 1);
+        if (q > q_low) {
+            x = -x;
+        }
+    } else {
+        // central region
+        const double t = q - 0.5;
+        const double r = t * t;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * t
+            / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+    }
+
+    const double e = 0.5 * erfc(-x / sqrt(2.)) - q;
+    const double u = e * sqrt(2 * M_PI) * exp(x * x / 2);
+    return x - u / (1 + x * u / 2);
+}
+
+
+/**
+ * @brief Wilson score interval of a rate estimated from events out of trials
+ * @param events number of observed events, e.g. frame errors
+ * @param trials number of trials, e.g. frames, [0, 1] is returned for 0 trials
+ * @param confidence confidence level, e.g. 0.95
+ * @return the interval
+ */
+ConfidenceInterval wilson_interval(const size_t events, const size_t trials, const double confidence) {
+    if (!(confidence > 0 && confidence < 1)) {
+        throw runtime_error("confidence level " + to_string(confidence) + " is not in (0, 1).");
+    }
+    if (trials == 0) {
+        return {0, 1};
+    }
+    const double z = normal_quantile(1 - (1 - confidence) / 2);
+    const double n = static_cast<double>(trials);
+    const double rate = static_cast<double>(events) / n;
+    const double z2 = z * z;
+    const double center = (rate + z2 / (2 * n)) / (1 + z2 / n);
+    const double half = z * sqrt(rate * (1 - rate) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+    return {max(0., center - half), min(1., center + half)};
+}
+
+
+/**
+ * @brief continued fraction of the incomplete beta function (modified Lentz)
+ */
+static double beta_continued_fraction(const double a, const double b, const double x) {
+    const double tiny = 1e-300;
+    auto clamp_tiny = [tiny](const double v) { return fabs(v) < tiny ? tiny : v; };
+
+    double c = 1;
+    double d = 1 / clamp_tiny(1 - (a + b) * x / (a + 1));
+    double h = d;
+    for (int m = 1; m <= 10000; ++m) {
+        // even step
+        double aa = m * (b - m) * x / ((a - 1 + 2 * m) * (a + 2 * m));
+        d = 1 / clamp_tiny(1 + aa * d);
+        c = clamp_tiny(1 + aa / c);
+        h *= d * c;
+
+        // odd step
+        aa = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 1 + 2 * m));
+        d = 1 / clamp_tiny(1 + aa * d);
+        c = clamp_tiny(1 + aa / c);
+        const double delta = d * c;
+        h *= delta;
+        if (fabs(delta - 1) < 1e-15) {
+            break;
+        }
+    }
+    return h;
+}
+
+
+/**
+ * @brief regularized incomplete beta function I_x(a, b)
+ */
+static double regularized_beta(const double a, const double b, const double x) {
+    if (x <= 0) {
+        return 0;
+    }
+    if (x >= 1) {
+        return 1;
+    }
+    const double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log1p(-x));
+    // the continued fraction converges fast on this side of the mean
+    if (x < (a + 1) / (a + b + 2)) {
+        return front * beta_continued_fraction(a, b, x) / a;
+    }
+    return 1 - front * beta_continued_fraction(b, a, 1 - x) / b;
+}
+
+
+/**
+ * @brief x with I_x(a, b) = q, by bisection
+ */
+static double beta_quantile(const double a, const double b, const double q) {
+    double low = 0;
+    double high = 1;
+    for (int i = 0; i < 100 && high - low > 1e-16 * high; ++i) {
+        const double mid = (low + high) / 2;
+        (regularized_beta(a, b, mid) < q ? low : high) = mid;
+    }
+    return (low + high) / 2;
+}
+
+
+/**
+ * @brief Clopper-Pearson (exact) interval of a rate estimated from events out of trials
+ * @param events number of observed events
+ * @param trials number of trials, [0, 1] is returned for 0 trials
+ * @param confidence confidence level, e.g. 0.95
+ * @return the interval
+ */
+ConfidenceInterval clopper_pearson_interval(const size_t events, const size_t trials, const double confidence) {
+    if (!(confidence > 0 && confidence < 1)) {
+        throw runtime_error("confidence level " + to_string(confidence) + " is not in (0, 1).");
+    }
+    if (trials == 0) {
+        return {0, 1};
+    }
+    const double alpha = 1 - confidence;
+    const double k = static_cast<double>(events);
+    const double n = static_cast<double>(trials);
+    return {events == 0 ? 0. : beta_quantile(k, n - k + 1, alpha / 2),
+            events >= trials ? 1. : beta_quantile(k + 1, n - k, 1 - alpha / 2)};
+}
+
+
+/**
+ * @brief confidence interval with the given method
+ * @param method the method
+ * @param events number of observed events
+ * @param trials number of trials
+ * @param confidence confidence level, e.g. 0.95
+ * @return the interval
+ */
+ConfidenceInterval binomial_interval(const IntervalMethod method, const size_t events, const size_t trials,
+                                     const double confidence) {
+    if (method == IntervalMethod::clopper_pearson) {
+        return clopper_pearson_interval(events, trials, confidence);
+    }
+    return wilson_interval(events, trials, confidence);
+}
+
+
+/**
+ * @brief binary entropy in bits
+ * @param p probability, in (0, 1)
+ * @return h(p) = -p log2(p) - (1 - p) log2(1 - p)
+ */
+double binary_entropy(const double p) {
+    return -p * log2(p) - (1 - p) * log2(1 - p);
+}
+
+
+/**
+ * @brief crossover probability of the Slepian-Wolf limit, h(p) = rate, by bisection
+ * @param rate syndrome bits per source bit, n_rows / n_cols of a code
+ * @return p in (0, 0.5)
+ */
+double slepian_wolf_limit(const double rate) {
+    double low = 0, high = 0.5;
+    for (int i = 0; i < 60; ++i) {
+        const double mid = 0.5 * (low + high);
+        (binary_entropy(mid) < rate ? low : high) = mid;
+    }
+    return low;
+}
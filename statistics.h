@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Small statistics helpers for the simulations: binomial probabilities, normal
+quantiles, confidence intervals of error rates and the Slepian-Wolf limit of the
+BSC.
+*/
+
+
+#ifndef INFORMATION_THEORY_STATISTICS_H
+#define INFORMATION_THEORY_STATISTICS_H
+
+#include <cstddef>
+
+using namespace std;
+
+
+/**
+ * @brief method of a binomial confidence interval
+ */
+enum class IntervalMethod {
+    wilson,                            // Wilson score, close to nominal coverage on average
+    clopper_pearson                    // exact, at least the nominal coverage everywhere
+};
+
+
+/**
+ * @brief a two-sided confidence interval
+ */
+struct ConfidenceInterval {
+    double low{};
+    double high{};
+};
+
+
+/**
+ * @brief probability of exactly k successes out of n trials with success probability p
+ * @param n number of trials
+ * @param k number of successes
+ * @param p success probability
+ * @return the binomial probability, computed in the log domain
+ */
+double binomial_pmf(size_t n, size_t k, double p);
+
+
+/**
+ * @brief quantile function of the standard normal distribution
+ * @param q probability in (0, 1)
+ * @return x with P(X <= x) = q
+ */
+double normal_quantile(double q);
+
+
+/**
+ * @brief Wilson score interval of a rate estimated from events out of trials
+ *
+ * Stays inside [0, 1] and gives a useful upper bound when no event was observed.
+ * @param events number of observed events, e.g. frame errors
+ * @param trials number of trials, e.g. frames, [0, 1] is returned for 0 trials
+ * @param confidence confidence level, e.g. 0.95
+ * @return the interval
+ */
+ConfidenceInterval wilson_interval(size_t events, size_t trials, double confidence);
+
+
+
+/**
+ * @brief Clopper-Pearson (exact) interval of a rate estimated from events out of trials
+ *
+ * Inverts the binomial tails through the regularized incomplete beta function.
+ * @param events number of observed events
+ * @param trials number of trials, [0, 1] is returned for 0 trials
+ * @param confidence confidence level, e.g. 0.95
+ * @return the interval
+ */
+ConfidenceInterval clopper_pearson_interval(size_t events, size_t trials, double confidence);
+
+
+/**
+ * @brief confidence interval with the given method
+ * @param method the method
+ * @param events number of observed events
+ * @param trials number of trials
+ * @param confidence confidence level, e.g. 0.95
+ * @return the interval
+ */
+ConfidenceInterval binomial_interval(IntervalMethod method, size_t events, size_t trials, double confidence);
+
+
+/**
+ * @brief binary entropy in bits
+ * @param p probability, in (0, 1)
+ * @return h(p) = -p log2(p) - (1 - p) log2(1 - p)
+ */
+double binary_entropy(double p);
+
+
+/**
+ * @brief crossover probability of the Slepian-Wolf limit, h(p) = rate, by bisection
+ * @param rate syndrome bits per source bit, n_rows / n_cols of a code
+ * @return p in (0, 0.5)
+ */
+double slepian_wolf_limit(double rate);
+
+
+#endif //INFORMATION_THEORY_STATISTICS_H
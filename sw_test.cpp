@@ -5,9 +5,13 @@
 #include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include "simulation_utils.h"
 #include "encoding_decoding.h"
-#include "npy.hpp"
+#include "sweep.h"
+#include "code_io.h"
+#include "decoder_statistics.h"
 
 /**
  * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
@@ -74,70 +78,61 @@ using namespace std;
 
 
 // all the parameters to use different codes, and to set the location of where to save the results
-uint16_t n_rows = 212;
-uint16_t n_cols = 1908;
 double sweep_min = 0.01088889;
 double sweep_max = 0.01444445;
 int sweep_steps = 5;
+// the code, an alist file (e.g. "codes_alist/1908_212_4_1383.txt"), the column pointers of
+// a .npy pair (the row indices are read from the matching _row_index.npy), a QC base matrix
+// or a binary code file written by convert_code, which skips all parsing and graph building
 const char * path = {"codes/1908_212_4_colmn_pointers.npy"};
-const char * path2 = {"codes/1908_212_4_row_index.npy"};
 string path_fer("results/fer_detail_1908_212_4_big_error");
 string path_p("results/p_detail_1908_212_4_big_error");
 int number_of_samples = 100;
 
-// templates in relation to numpy arrays
-template <typename Scalar>
-struct npy_data {
-    std::vector<unsigned long> shape;
-    bool fortran_order;
-    std::vector<Scalar> data;
-};
-
-template <typename Scalar>
-npy_data<Scalar> test_load(const char * path) {
-    npy_data<Scalar> d;
-    npy::LoadArrayFromNumpy(path, d.shape, d.fortran_order, d.data);
-    return d;
-}
-
-
-/** Simulates a BSC channel with a given error probability
- *
- *  @param data_size block size of the code/ message length
- *  @param p crossover probability of the BSC
- *  @param column_pointers column pointers of the code
- *  @param row_index row indeces of the code
- *  @return True if decoded succesfully before max iterations run out, false otherwise
- */
-bool simulate_bsc(const int data_size,
-                  const double p,
-                  const vector<uint32_t> column_pointers,
-                  const vector<uint16_t> row_index){
-
-    // generate random input
-    vector<bool> input = random_input(data_size);
-    vector<bool> checksum;
-    checksum = encode(input, column_pointers, row_index, n_rows);
-
-    //cout << "encoded \n";
-
-    vector<bool> y = bit_flip_channel(input, p);
-
-    // calculating the log-likehood ratios
-    vector<double> llr_init = bsc_llr(y, p);
-
-    auto [pos_varn, pos_checkn] = calculate_vn_cv(n_cols, n_rows, column_pointers, row_index);
-
-    // decoding, max iterations is at 50 right now
-    auto  [success, x_prime] = decode_at_current_rate(llr_init, checksum, n_cols, n_rows, pos_varn, pos_checkn,
-                                                      column_pointers, row_index, 50, 100);
-
-    //cout << "decoded \n" << "with success: " << success << endl;
-    //cout << "vectors are equal: " << (x_prime == input) << endl;
-
-    bool true_success = x_prime == input;
-    return true_success;
-}
+// stopping rule, every sweep point runs until one of these is met, number_of_samples is
+// then the maximum number of frames per point (0 disables a criterion)
+size_t min_frame_errors = 0;
+double target_relative_width = 0;
+double seconds_per_point = 0;
+IntervalMethod interval_method = IntervalMethod::wilson;
+
+// decoder parameters, pick CheckNodeRule::normalized_min_sum or offset_min_sum for speed,
+// Schedule::layered converges in about half the iterations of Schedule::flooding,
+// MessageType::float32 doubles the SIMD lanes at a negligible loss
+DecoderConfig decoder_config = [] {
+    DecoderConfig config;
+    config.rule = CheckNodeRule::sum_product;
+    config.schedule = Schedule::flooding;
+    config.message_type = MessageType::float64;
+    config.ms_scale = 0.75;
+    config.ms_offset = 0.5;
+    config.max_num_iter = 50;
+    config.vsat = 100;
+    return config;
+}();
+
+// frames decoded together in lockstep by the batch decoder (8-32 pays off with every
+// check node rule), 0 decodes frame by frame
+int batch_size = 0;
+
+// worker threads of the sweep (0 uses all hardware threads) and the master seed, the
+// results only depend on the seed
+unsigned n_threads = 0;
+uint64_t seed = 1;
+
+// set to a message width (e.g. 6 or 8 bits) to also print the frame error rate of the
+// fixed-point decoder with that width next to decoder_config, 0 skips the report
+int quantization_report_bits = 0;
+int quantization_report_frac_bits = 2;
+
+// set to a number of frames per error weight to also print the weight-stratified FER
+// estimate with 95% confidence intervals, which resolves rates far below 1/number_of_samples
+size_t stratified_frames_per_weight = 0;
+
+// set to a path prefix (e.g. "results/stats_1908_212_4") to record the iterations, termination
+// reasons, syndrome weights and phase times of every frame, saved per sweep point as
+// <prefix>.json and <prefix>_*.npy; the frames are then decoded one by one, batch_size is ignored
+string statistics_path("");
 
 /** main function starting the simulation and saving the results
  */
@@ -145,29 +140,68 @@ int main() {
 
     vector<double> p_vec = linspace(sweep_min, sweep_max, sweep_steps);
     vector<double> fers = vector<double>(p_vec.size());
-    int data_size = n_cols;
-    int number_of_success = 0;
-    double p;
-
-    // loading the code from the numpy arrays
-    auto d = test_load<unsigned int>(path);
-    auto d2 = test_load<uint16_t>(path2);
-    vector<uint32_t>column_pointers = d.data;
-    vector<uint16_t>row_index = d2.data;
-
-    // looping over all samples
-    for (size_t i = 0; i < p_vec.size(); ++i) {
-        number_of_success = 0;
-        p = p_vec[i];
-        for (int i = 0; i < number_of_samples; i++) {
-            cout << "running sample: " << i << endl;
-            if (simulate_bsc(data_size, p, column_pointers, row_index)) {
-                number_of_success++;
-            }
+
+    // loading the code
+    const LdpcCode code = load_ldpc_code(path);
+
+    // running all samples of all sweep points on the thread pool
+    SweepConfig sweep_config;
+    sweep_config.p_values = p_vec;
+    sweep_config.frames_per_point = number_of_samples;
+    sweep_config.min_frame_errors = min_frame_errors;
+    sweep_config.target_relative_width = target_relative_width;
+    sweep_config.seconds_per_point = seconds_per_point;
+    sweep_config.interval = interval_method;
+    sweep_config.seed = seed;
+    sweep_config.n_threads = n_threads;
+    sweep_config.batch_size = batch_size;
+    sweep_config.decoder = decoder_config;
+    sweep_config.collect_statistics = !statistics_path.empty();
+    const vector<SweepPointResult> results = run_fer_sweep(code, sweep_config);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        cout << "number of success: " << results[i].successes << endl;
+        fers[i] = results[i].fer;
+        cout << "current frame error rate: " << fers[i] << "for ber " << p_vec[i] << endl;
+        cout << "  " << results[i].frames << " frames, 95% interval [" << results[i].fer_low << ", "
+             << results[i].fer_high << "], stopped by " << stop_reason_name(results[i].stop_reason) << endl;
+        if (sweep_config.collect_statistics) {
+            const DecoderStatisticsSummary &statistics = results[i].statistics;
+            cout << "  iterations mean " << statistics.mean_iterations() << ", p99 "
+                 << statistics.iteration_quantile(0.99) << ", not converged "
+                 << statistics.frames - statistics.terminations[static_cast<size_t>(Termination::converged)] << endl;
+        }
+    }
+
+    if (sweep_config.collect_statistics) {
+        vector<DecoderStatisticsSummary> statistics;
+        for (const auto &result : results) {
+            statistics.push_back(result.statistics);
+        }
+        write_statistics_json(statistics_path + ".json", p_vec, statistics);
+        save_statistics_npy(statistics_path, p_vec, statistics);
+    }
+
+    if (quantization_report_bits > 0) {
+        cout << "quantization loss, " << quantization_report_bits << " bit messages with "
+             << quantization_report_frac_bits << " fractional bits:" << endl;
+        for (const auto &point : quantization_loss(code, sweep_config, quantization_report_bits,
+                                                   quantization_report_frac_bits)) {
+            cout << "p " << point.p << ": fer float " << point.fer_float
+                 << ", fer fixed " << point.fer_fixed << endl;
+        }
+    }
+
+    if (stratified_frames_per_weight > 0) {
+        StratifiedSweepConfig stratified_config;
+        stratified_config.sweep = sweep_config;
+        stratified_config.frames_per_weight = stratified_frames_per_weight;
+        const StratifiedSweepResult stratified = run_stratified_sweep(code, stratified_config);
+        cout << "weight-stratified estimate from " << stratified.strata.size() << " error weights:" << endl;
+        for (const auto &point : stratified.points) {
+            cout << "p " << point.p << ": fer " << point.fer << " [" << point.fer_low << ", "
+                 << point.fer_high << "]" << endl;
         }
-        cout << "number of success: " << number_of_success << endl;
-        fers[i] = (number_of_samples - (double) number_of_success) / number_of_samples;
-        cout << "current frame error rate: " << fers[i] << "for ber " << p << endl;
     }
 
     //cout << "number of success: " << number_of_success << endl;
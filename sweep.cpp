@@ -0,0 +1,713 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Parallel Monte Carlo FER sweep and the weight-stratified estimator.
+*/
+
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "sweep.h"
+#include "batch_decoder.h"
+#include "simulation_utils.h"
+#include "bsc_channel.h"
+#include "statistics.h"
+
+using namespace std;
+
+
+/**
+ * @brief everything a worker thread owns, reused for all of its chunks
+ */
+struct SweepWorker {
+    DecoderWorkspace ws;
+    BatchDecoderWorkspace batch_ws;
+    vector<vector<bool>> inputs;
+    vector<vector<bool>> syndromes;
+    vector<vector<double>> llrs;
+    vector<vector<bool>> decoded;
+    vector<bool> success;
+    vector<bool> received;
+    BscChannel channel;                // channel, its generator also draws the inputs
+    size_t error_weight = SIZE_MAX;    // fixed number of errors per frame, SIZE_MAX uses the channel
+    PackedFrame errors;                // error pattern of the fixed-weight frames
+    FrameStatistics frame_statistics;  // statistics of the last frame, with collect_statistics
+    DecoderStatisticsSummary chunk_statistics;  // statistics of the last chunk, with collect_statistics
+    uint64_t chunk_syndrome_bits = 0;  // syndrome bits used by the last chunk
+};
+
+
+/**
+ * @brief draws n_frames frames into the worker buffers, frame by frame from worker.channel
+ *
+ * With worker.error_weight set, every frame gets exactly that many errors instead of
+ * going through the channel, the LLRs are still those of a BSC with crossover p.
+ * @param code the LDPC code
+ * @param p BSC crossover probability
+ * @param n_frames number of frames
+ * @param worker the worker, its buffers are resized as needed
+ */
+static void generate_frames(const LdpcCode &code, const double p, const size_t n_frames, SweepWorker &worker) {
+    worker.inputs.resize(n_frames, vector<bool>(code.n_cols));
+    worker.syndromes.resize(n_frames, vector<bool>(code.n_rows));
+    worker.llrs.resize(n_frames);
+    for (size_t f = 0; f < n_frames; f++) {
+        random_input(worker.inputs[f], worker.channel.gen);
+        encode(code, worker.inputs[f], worker.syndromes[f]);
+        worker.received = worker.inputs[f];
+        if (worker.error_weight == SIZE_MAX) {
+            apply_bsc(worker.channel, worker.received);
+        } else {
+            fixed_weight_errors(code.n_cols, worker.error_weight, worker.channel.gen, worker.errors);
+            apply_errors(worker.errors, worker.received);
+        }
+        bsc_llr(worker.received, p, worker.llrs[f]);
+    }
+}
+
+
+/**
+ * @brief simulates one chunk of frames
+ * @param code the LDPC code
+ * @param config sweep parameters
+ * @param decoder decoder parameters
+ * @param rate_adaptive rate steps of the code to decode with, nullptr decodes at the rate of the code
+ * @param p BSC crossover probability
+ * @param n_frames number of frames in the chunk
+ * @param worker the worker, worker.channel must be set up for this chunk, with
+ * config.collect_statistics worker.chunk_statistics receives the frames of the chunk
+ * (none for rate-adaptive chunks), worker.chunk_syndrome_bits receives the syndrome
+ * bits used
+ * @return number of frames decoded to the right word
+ */
+static size_t simulate_chunk(const LdpcCode &code,
+                             const SweepConfig &config,
+                             const DecoderConfig &decoder,
+                             const RateAdaptiveCode *rate_adaptive,
+                             const double p,
+                             const size_t n_frames,
+                             SweepWorker &worker) {
+    size_t successes = 0;
+    worker.chunk_syndrome_bits = static_cast<uint64_t>(n_frames) * code.n_rows;
+    worker.chunk_statistics = DecoderStatisticsSummary();
+    if (rate_adaptive) {
+        // the statistics of the steps are not collected, every step would reset them
+        worker.ws.statistics = nullptr;
+        worker.chunk_syndrome_bits = 0;
+        for (size_t f = 0; f < n_frames; f++) {
+            generate_frames(code, p, 1, worker);
+            const RateAdaptiveResult result = decode_rate_adaptive(*rate_adaptive, worker.llrs[0],
+                                                                   worker.syndromes[0], worker.ws, decoder);
+            successes += result.success && worker.ws.out == worker.inputs[0];
+            worker.chunk_syndrome_bits += result.syndrome_bits;
+        }
+        return successes;
+    }
+
+    if (config.batch_size == 0 || config.collect_statistics) {
+        // the batch decoder is not instrumented, it gives the same decisions frame by frame
+        worker.ws.statistics = config.collect_statistics ? &worker.frame_statistics : nullptr;
+        for (size_t f = 0; f < n_frames; f++) {
+            generate_frames(code, p, 1, worker);
+            decode_at_current_rate(code, worker.llrs[0], worker.syndromes[0], worker.ws, decoder);
+            successes += worker.ws.out == worker.inputs[0];
+            if (config.collect_statistics) {
+                worker.chunk_statistics.add(worker.frame_statistics);
+            }
+        }
+        return successes;
+    }
+
+    // same random draws as frame by frame, the batch decoder gives the same decisions
+    // (with the sum-product rule up to rounding of its messages)
+    for (size_t first = 0; first < n_frames; first += worker.batch_ws.batch_size) {
+        const size_t n_batch = min(worker.batch_ws.batch_size, n_frames - first);
+        generate_frames(code, p, n_batch, worker);
+        decode_batch(code, worker.llrs, worker.syndromes, worker.batch_ws, decoder,
+                     worker.decoded, worker.success);
+        for (size_t f = 0; f < n_batch; f++) {
+            successes += worker.decoded[f] == worker.inputs[f];
+        }
+    }
+    return successes;
+}
+
+
+/**
+ * @brief runs a pool of worker threads, each calling step until it returns false
+ *
+ * The calling thread is the last worker of the pool. An exception in any worker
+ * stops the others after their current step and is rethrown here.
+ * @param codes the LDPC codes, shared read-only by all workers
+ * @param config sweep parameters, for the number of threads and the batch size
+ * @param max_threads upper limit of useful threads, e.g. the number of work items
+ * @param step does one work item with the given workers, one per code, false once
+ * nothing is left
+ */
+static void run_pool(const vector<const LdpcCode *> &codes,
+                     const SweepConfig &config,
+                     const size_t max_threads,
+                     const function<bool(vector<SweepWorker> &)> &step) {
+    unsigned n_threads = config.n_threads ? config.n_threads : thread::hardware_concurrency();
+    n_threads = static_cast<unsigned>(max<size_t>(1, min<size_t>(max(n_threads, 1u), max_threads)));
+    vector<exception_ptr> errors(n_threads);
+    atomic<bool> failed(false);
+
+    auto work = [&](const unsigned id) {
+        try {
+            vector<SweepWorker> workers(codes.size());
+            for (size_t c = 0; c < codes.size(); c++) {
+                workers[c].ws = make_decoder_workspace(*codes[c]);
+                if (config.batch_size > 0) {
+                    workers[c].batch_ws = make_batch_decoder_workspace(*codes[c], config.batch_size);
+                }
+            }
+            while (!failed && step(workers)) {
+            }
+        } catch (...) {
+            errors[id] = current_exception();
+            failed = true;  // let the other workers stop early
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned id = 1; id < n_threads; id++) {
+        pool.emplace_back(work, id);
+    }
+    work(0);
+    for (auto &t : pool) {
+        t.join();
+    }
+    for (const auto &e : errors) {
+        if (e) {
+            rethrow_exception(e);
+        }
+    }
+}
+
+
+/**
+ * @brief runs a fixed number of work items on a pool of worker threads
+ *
+ * Workers pull the items from a shared counter and write the result of every item
+ * into a slot of its own.
+ * @param code the LDPC code, shared read-only by all workers
+ * @param config sweep parameters, for the number of threads and the batch size
+ * @param n_chunks number of work items
+ * @param run_chunk simulates one item on the given worker, returns its number of successes
+ * @return the result of every item
+ */
+static vector<size_t> run_chunks(const LdpcCode &code,
+                                 const SweepConfig &config,
+                                 const size_t n_chunks,
+                                 const function<size_t(SweepWorker &, size_t)> &run_chunk) {
+    vector<size_t> chunk_successes(n_chunks);  // one slot per chunk, written by exactly one worker
+    atomic<size_t> next_chunk(0);
+    run_pool({&code}, config, n_chunks, [&](vector<SweepWorker> &workers) {
+        SweepWorker &worker = workers[0];
+        const size_t c = next_chunk++;
+        if (c >= n_chunks) {
+            return false;
+        }
+        chunk_successes[c] = run_chunk(worker, c);
+        return true;
+    });
+    return chunk_successes;
+}
+
+
+/**
+ * @brief progress of one sweep point under the stopping rule
+ *
+ * Chunks finish in any order, but they are only counted in chunk order, and the
+ * point stops at the first counted prefix that meets a criterion. Chunks finished
+ * beyond that prefix are dropped, so the result does not depend on the timing of
+ * the workers (except through the time budget).
+ */
+struct PointProgress {
+    size_t dispatched = 0;             // chunks handed out to workers
+    vector<size_t> chunk_successes;    // result per chunk, valid where chunk_done is set
+    vector<uint64_t> chunk_syndrome_bits;
+    vector<DecoderStatisticsSummary> chunk_statistics;  // with collect_statistics, until counted
+    vector<bool> chunk_done;
+    size_t counted = 0;                // leading chunks included in frames and successes
+    size_t frames = 0;
+    size_t successes = 0;
+    uint64_t syndrome_bits = 0;
+    DecoderStatisticsSummary statistics;  // statistics of the counted chunks
+    double seconds = 0;                // worker time spent on the point
+    bool stopped = false;
+    StopReason reason = StopReason::max_frames;
+};
+
+
+/**
+ * @brief checks the stopping criteria on the counted frames of a point
+ * @param config sweep parameters with the stopping criteria
+ * @param point the point, stopped and reason are set if a criterion is met
+ */
+static void check_stopping_rule(const SweepConfig &config, PointProgress &point) {
+    const size_t errors = point.frames - point.successes;
+    if (config.shard_count > 1) {
+        // a shard only sees its own errors, they can't exceed those of the merged prefix
+        if (config.min_frame_errors > 0 && errors >= config.min_frame_errors) {
+            point.reason = StopReason::min_errors;
+            point.stopped = true;
+        }
+        return;
+    }
+    bool narrow = false;
+    if (config.target_relative_width > 0 && errors > 0) {
+        const ConfidenceInterval ci = binomial_interval(config.interval, errors, point.frames, config.confidence);
+        narrow = (ci.high - ci.low) * static_cast<double>(point.frames) / errors <= config.target_relative_width;
+    }
+
+    if (point.frames >= config.frames_per_point) {
+        point.reason = StopReason::max_frames;
+    } else if (config.min_frame_errors > 0 && errors >= config.min_frame_errors) {
+        point.reason = StopReason::min_errors;
+    } else if (narrow) {
+        point.reason = StopReason::interval_width;
+    } else if (config.seconds_per_point > 0 && point.seconds >= config.seconds_per_point) {
+        point.reason = StopReason::time_budget;
+    } else {
+        return;
+    }
+    point.stopped = true;
+}
+
+
+/**
+ * @brief number of frames in a chunk, the last chunk of a point may be short
+ * @param config sweep parameters
+ * @param chunk index of the chunk within its point
+ * @return the number of frames
+ */
+static size_t chunk_frames(const SweepConfig &config, const size_t chunk) {
+    return min(config.chunk_size, config.frames_per_point - chunk * config.chunk_size);
+}
+
+
+/**
+ * @brief the result of a point from its counted chunks
+ * @param config sweep parameters, for the confidence interval
+ * @param p BSC crossover probability
+ * @param point the progress of the point
+ * @return the result
+ */
+static SweepPointResult point_result(const SweepConfig &config, const double p, const PointProgress &point) {
+    SweepPointResult result;
+    result.p = p;
+    result.frames = point.frames;
+    result.successes = point.successes;
+    result.fer = point.frames ? (point.frames - static_cast<double>(point.successes)) / point.frames : 0.;
+    const ConfidenceInterval ci = binomial_interval(config.interval, point.frames - point.successes,
+                                                    point.frames, config.confidence);
+    result.fer_low = ci.low;
+    result.fer_high = ci.high;
+    result.syndrome_bits = point.frames ? static_cast<double>(point.syndrome_bits) / point.frames : 0.;
+    result.seconds = point.seconds;
+    result.stop_reason = point.reason;
+    result.statistics = point.statistics;
+    result.chunk_successes.assign(point.chunk_successes.begin(), point.chunk_successes.begin() + point.counted);
+    result.chunk_syndrome_bits.assign(point.chunk_syndrome_bits.begin(),
+                                      point.chunk_syndrome_bits.begin() + point.counted);
+    return result;
+}
+
+
+/**
+ * @brief simulates all sweep points of the config on a pool of worker threads
+ * @param code the LDPC code, shared read-only by all workers
+ * @param config sweep parameters
+ * @return one result per entry of config.p_values
+ */
+vector<SweepPointResult> run_fer_sweep(const LdpcCode &code, const SweepConfig &config) {
+    vector<GridJob> jobs(config.p_values.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobs[i].code = 0;
+        jobs[i].p = config.p_values[i];
+        jobs[i].decoder = config.decoder;
+        jobs[i].stream = i;
+    }
+    return run_grid_sweep({&code}, jobs, config);
+}
+
+
+/**
+ * @brief simulates the jobs of a grid over several codes on one pool of worker threads
+ * @param codes the LDPC codes, shared read-only by all workers
+ * @param jobs the points to simulate
+ * @param config sweep parameters, p_values and decoder are ignored in favor of the jobs
+ * @return one result per job
+ */
+vector<SweepPointResult> run_grid_sweep(const vector<const LdpcCode *> &codes,
+                                        const vector<GridJob> &jobs,
+                                        const SweepConfig &config) {
+    if (config.chunk_size == 0) {
+        throw runtime_error("chunk size must be positive.");
+    }
+    for (const auto &job : jobs) {
+        if (job.code >= codes.size()) {
+            throw runtime_error("grid job refers to a missing code.");
+        }
+    }
+    if (config.shard_index >= config.shard_count) {
+        throw runtime_error("shard index must be below the number of shards.");
+    }
+    if (config.shard_count > 1 && config.seconds_per_point > 0) {
+        throw runtime_error("the time budget can't be sharded.");
+    }
+
+    // chunk c of the point is the chunk chunk * shard_count + shard_index of the whole sweep
+    const size_t total_chunks = (config.frames_per_point + config.chunk_size - 1) / config.chunk_size;
+    const size_t chunks_per_point = total_chunks > config.shard_index
+                                    ? (total_chunks - config.shard_index + config.shard_count - 1) / config.shard_count
+                                    : 0;
+    auto sweep_chunk = [&](const size_t chunk) {
+        return chunk * config.shard_count + config.shard_index;
+    };
+    vector<PointProgress> points(jobs.size());
+    for (auto &point : points) {
+        point.chunk_successes.resize(chunks_per_point);
+        point.chunk_syndrome_bits.resize(chunks_per_point);
+        point.chunk_statistics.resize(config.collect_statistics ? chunks_per_point : 0);
+        point.chunk_done.resize(chunks_per_point);
+        point.stopped = chunks_per_point == 0;
+    }
+    mutex progress_mutex;
+
+    run_pool(codes, config, chunks_per_point * points.size(), [&](vector<SweepWorker> &workers) {
+        // next chunk of the running point with the fewest chunks handed out
+        size_t index = points.size();
+        size_t chunk = 0;
+        {
+            lock_guard<mutex> lock(progress_mutex);
+            for (size_t i = 0; i < points.size(); i++) {
+                if (!points[i].stopped && points[i].dispatched < chunks_per_point
+                    && (index == points.size() || points[i].dispatched < points[index].dispatched)) {
+                    index = i;
+                }
+            }
+            if (index == points.size()) {
+                return false;
+            }
+            chunk = points[index].dispatched++;
+        }
+
+        const GridJob &job = jobs[index];
+        const LdpcCode &code = *codes[job.code];
+        SweepWorker &worker = workers[job.code];
+        const double p = job.p;
+        const size_t n_frames = chunk_frames(config, sweep_chunk(chunk));
+        const auto start = chrono::steady_clock::now();
+        worker.channel.gen.seed(stream_seed(config.seed, job.stream, sweep_chunk(chunk)));
+        set_crossover_probability(worker.channel, p);
+        const size_t successes = simulate_chunk(code, config, job.decoder, job.rate_adaptive, p, n_frames, worker);
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        lock_guard<mutex> lock(progress_mutex);
+        PointProgress &point = points[index];
+        point.chunk_successes[chunk] = successes;
+        point.chunk_syndrome_bits[chunk] = worker.chunk_syndrome_bits;
+        if (config.collect_statistics) {
+            point.chunk_statistics[chunk] = move(worker.chunk_statistics);
+        }
+        point.chunk_done[chunk] = true;
+        point.seconds += seconds;
+        while (!point.stopped && point.counted < chunks_per_point && point.chunk_done[point.counted]) {
+            point.frames += chunk_frames(config, sweep_chunk(point.counted));
+            point.successes += point.chunk_successes[point.counted];
+            point.syndrome_bits += point.chunk_syndrome_bits[point.counted];
+            if (config.collect_statistics) {
+                point.statistics.merge(point.chunk_statistics[point.counted]);
+                point.chunk_statistics[point.counted] = DecoderStatisticsSummary();
+            }
+            point.counted++;
+            check_stopping_rule(config, point);
+        }
+        return true;
+    });
+
+    vector<SweepPointResult> results(jobs.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        results[i] = point_result(config, jobs[i].p, points[i]);
+    }
+    return results;
+}
+
+
+/**
+ * @brief combines the results of the shards of a sweep into those of the whole sweep
+ * @param config sweep parameters of the shards, shard_index and shard_count are ignored
+ * @param shards the results of shard 0 to N - 1, one result per point each
+ * @return one result per point, seconds is the time of all shards
+ */
+vector<SweepPointResult> merge_sweep_shards(const SweepConfig &config,
+                                            const vector<vector<SweepPointResult>> &shards) {
+    if (shards.empty()) {
+        throw runtime_error("no shards to merge.");
+    }
+    if (config.chunk_size == 0) {
+        throw runtime_error("chunk size must be positive.");
+    }
+    if (config.seconds_per_point > 0) {
+        throw runtime_error("the time budget can't be sharded.");
+    }
+    SweepConfig merged = config;
+    merged.shard_index = 0;
+    merged.shard_count = 1;
+
+    const size_t n_shards = shards.size();
+    const size_t total_chunks = (config.frames_per_point + config.chunk_size - 1) / config.chunk_size;
+    vector<SweepPointResult> results(shards[0].size());
+    for (size_t i = 0; i < results.size(); i++) {
+        PointProgress point;
+        point.chunk_successes.resize(total_chunks);
+        point.chunk_syndrome_bits.resize(total_chunks);
+        point.chunk_done.resize(total_chunks);
+        for (size_t s = 0; s < n_shards; s++) {
+            if (shards[s].size() != results.size() || shards[s][i].p != shards[0][i].p) {
+                throw runtime_error("shard " + to_string(s) + " has different sweep points.");
+            }
+            const vector<size_t> &chunks = shards[s][i].chunk_successes;
+            if (shards[s][i].chunk_syndrome_bits.size() != chunks.size()) {
+                throw runtime_error("shard " + to_string(s) + " lacks the syndrome bits of its chunks.");
+            }
+            for (size_t c = 0; c < chunks.size(); c++) {
+                const size_t chunk = c * n_shards + s;
+                if (chunk >= total_chunks) {
+                    throw runtime_error("shard " + to_string(s) + " has more chunks than the sweep.");
+                }
+                point.chunk_successes[chunk] = chunks[c];
+                point.chunk_syndrome_bits[chunk] = shards[s][i].chunk_syndrome_bits[c];
+                point.chunk_done[chunk] = true;
+            }
+            point.seconds += shards[s][i].seconds;
+        }
+
+        point.stopped = total_chunks == 0;
+        while (!point.stopped) {
+            if (!point.chunk_done[point.counted]) {
+                throw runtime_error("the shards end before the stopping rule of point " + to_string(i)
+                                    + ", chunk " + to_string(point.counted) + " is missing.");
+            }
+            point.frames += chunk_frames(merged, point.counted);
+            point.successes += point.chunk_successes[point.counted];
+            point.syndrome_bits += point.chunk_syndrome_bits[point.counted];
+            point.counted++;
+            check_stopping_rule(merged, point);
+        }
+        results[i] = point_result(merged, shards[0][i].p, point);
+    }
+    return results;
+}
+
+
+/**
+ * @brief name of a stop reason, for printing
+ * @param reason the reason
+ * @return the name
+ */
+const char *stop_reason_name(const StopReason reason) {
+    switch (reason) {
+        case StopReason::max_frames: return "max frames";
+        case StopReason::min_errors: return "min errors";
+        case StopReason::interval_width: return "interval width";
+        case StopReason::time_budget: return "time budget";
+    }
+    return "unknown";
+}
+
+
+/**
+ * @brief compares the fixed-point decoder against the floating point decoder
+ * @param code the LDPC code
+ * @param config sweep parameters, config.decoder is the floating point reference
+ * @param fixed_bits message width of the fixed-point decoder
+ * @param fixed_frac_bits fractional bits of the fixed-point decoder
+ * @return one entry per entry of config.p_values
+ */
+vector<QuantizationLossPoint> quantization_loss(const LdpcCode &code,
+                                                const SweepConfig &config,
+                                                const int fixed_bits,
+                                                const int fixed_frac_bits) {
+    SweepConfig float_config = config;
+    if (float_config.decoder.message_type == MessageType::fixed_point) {
+        float_config.decoder.message_type = MessageType::float64;
+    }
+    SweepConfig fixed_config = config;
+    fixed_config.decoder.message_type = MessageType::fixed_point;
+    fixed_config.decoder.fixed_bits = fixed_bits;
+    fixed_config.decoder.fixed_frac_bits = fixed_frac_bits;
+    fixed_config.batch_size = 0;
+
+    const vector<SweepPointResult> float_results = run_fer_sweep(code, float_config);
+    const vector<SweepPointResult> fixed_results = run_fer_sweep(code, fixed_config);
+
+    vector<QuantizationLossPoint> loss(config.p_values.size());
+    for (size_t point = 0; point < loss.size(); point++) {
+        loss[point].p = config.p_values[point];
+        loss[point].fer_float = float_results[point].fer;
+        loss[point].fer_fixed = fixed_results[point].fer;
+    }
+    return loss;
+}
+
+
+/**
+ * @brief largest error weight whose binomial upper tail still carries tail_mass
+ * @param n_bits frame length
+ * @param p crossover probability
+ * @param tail_mass probability mass that may be left above the returned weight
+ * @return the weight
+ */
+static size_t binomial_tail_weight(const size_t n_bits, const double p, const double tail_mass) {
+    // sum from the top, small terms first
+    double tail = 0;
+    for (size_t w = n_bits; w > 0; --w) {
+        const double pmf = binomial_pmf(n_bits, w, p);
+        if (tail + pmf >= tail_mass) {
+            return w;
+        }
+        tail += pmf;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief decodes frames at fixed error weights and combines them into FER curves
+ * @param code the LDPC code, shared read-only by all workers
+ * @param config parameters of the stratified sweep
+ * @return the strata and one combined result per entry of config.sweep.p_values
+ */
+StratifiedSweepResult run_stratified_sweep(const LdpcCode &code, const StratifiedSweepConfig &config) {
+    const SweepConfig &sweep = config.sweep;
+    if (sweep.chunk_size == 0) {
+        throw runtime_error("chunk size must be positive.");
+    }
+    if (sweep.p_values.empty()) {
+        throw runtime_error("the stratified sweep needs at least one crossover probability.");
+    }
+    const double p_max = *max_element(sweep.p_values.begin(), sweep.p_values.end());
+    const double design_p = config.design_p > 0
+            ? config.design_p
+            : (p_max + *min_element(sweep.p_values.begin(), sweep.p_values.end())) / 2;
+    const size_t min_weight = max<size_t>(config.min_weight, 1);
+    const size_t max_weight = config.max_weight ? min<size_t>(config.max_weight, code.n_cols)
+                                                : binomial_tail_weight(code.n_cols, p_max, config.tail_mass);
+
+    // work items, weight by weight and chunk by chunk
+    const size_t n_strata = max_weight >= min_weight ? max_weight - min_weight + 1 : 0;
+    const size_t chunks_per_weight = (config.frames_per_weight + sweep.chunk_size - 1) / sweep.chunk_size;
+    const vector<size_t> chunk_successes = run_chunks(code, sweep, n_strata * chunks_per_weight,
+                                                      [&](SweepWorker &worker, const size_t c) {
+        const size_t weight = min_weight + c / chunks_per_weight;
+        const size_t chunk = c % chunks_per_weight;
+        const size_t first = chunk * sweep.chunk_size;
+        const size_t n_frames = min(sweep.chunk_size, config.frames_per_weight - first);
+        worker.channel.gen.seed(stream_seed(sweep.seed, weight, chunk));
+        worker.error_weight = weight;
+        return simulate_chunk(code, sweep, sweep.decoder, nullptr, design_p, n_frames, worker);
+    });
+
+    StratifiedSweepResult result;
+    result.design_p = design_p;
+    result.strata.resize(n_strata);
+    for (size_t s = 0; s < n_strata; s++) {
+        WeightStratum &stratum = result.strata[s];
+        size_t successes = 0;
+        for (size_t chunk = 0; chunk < chunks_per_weight; chunk++) {
+            successes += chunk_successes[s * chunks_per_weight + chunk];
+        }
+        stratum.weight = min_weight + s;
+        stratum.frames = config.frames_per_weight;
+        stratum.failures = stratum.frames - successes;
+        stratum.fer = stratum.frames ? static_cast<double>(stratum.failures) / stratum.frames : 0.;
+        const ConfidenceInterval ci = binomial_interval(sweep.interval, stratum.failures, stratum.frames,
+                                                        sweep.confidence);
+        stratum.fer_low = ci.low;
+        stratum.fer_high = ci.high;
+    }
+
+    for (const double p : sweep.p_values) {
+        result.points.push_back(combine_strata(result.strata, code.n_cols, p));
+    }
+    return result;
+}
+
+
+/**
+ * @brief FER at crossover probability p from decoded strata
+ * @param strata the strata, sorted by weight without gaps
+ * @param n_bits frame length
+ * @param p crossover probability
+ * @return the combined estimate
+ */
+StratifiedPointResult combine_strata(const vector<WeightStratum> &strata, const size_t n_bits, const double p) {
+    StratifiedPointResult point;
+    point.p = p;
+    if (strata.empty()) {
+        // only weight 0 is known to decode
+        point.fer = 1 - binomial_pmf(n_bits, 0, p);
+        point.fer_high = point.fer;
+        point.unsimulated_mass = point.fer;
+        return point;
+    }
+
+    // unsimulated weights: the estimate counts 1..first-1 as decoded and everything
+    // above the last stratum as failed, the interval allows both either way
+    const size_t first = strata.front().weight;
+    const size_t last = strata.back().weight;
+    double mass_below = 0;
+    for (size_t w = 1; w < first; ++w) {
+        mass_below += binomial_pmf(n_bits, w, p);
+    }
+    double mass_above = 0;
+    for (size_t w = n_bits; w > last; --w) {
+        mass_above += binomial_pmf(n_bits, w, p);
+    }
+
+    for (const WeightStratum &stratum : strata) {
+        const double mass = binomial_pmf(n_bits, stratum.weight, p);
+        point.fer += mass * stratum.fer;
+        point.fer_low += mass * stratum.fer_low;
+        point.fer_high += mass * stratum.fer_high;
+    }
+    point.fer += mass_above;
+    point.fer_high += mass_above + mass_below;
+    point.unsimulated_mass = mass_below + mass_above;
+    return point;
+}
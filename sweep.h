@@ -0,0 +1,285 @@
+/**
+ * Copyright (c) 2022 Ronny Mueller ronny.r_mueller@web.de
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+
+Parallel Monte Carlo FER sweep. The frames of all sweep points are cut into
+chunks, a pool of worker threads pulls chunks from a shared counter and every
+chunk draws from its own random stream derived from the sweep seed, so the
+statistics only depend on the seed and not on the number of threads.
+
+For low frame error rates the stratified sweep decodes frames with a fixed number
+of errors instead, estimates the FER conditioned on every error weight, and
+weights those with the binomial distribution of the error weight of a BSC:
+FER(p) = sum_w P(w errors | p) * FER(w). One set of strata covers the whole range
+of p, and the rare high weights no longer need to show up by chance.
+*/
+
+
+#ifndef INFORMATION_THEORY_SWEEP_H
+#define INFORMATION_THEORY_SWEEP_H
+
+//----------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+#include "encoding_decoding.h"
+#include "statistics.h"
+#include "decoder_statistics.h"
+#include "rate_adaptive.h"
+
+using namespace std;
+
+
+/**
+ * @brief parameters of a FER sweep
+ *
+ * Without stopping criteria every point gets frames_per_point frames. Each criterion
+ * that is set can stop a point earlier, frames_per_point is then the maximum.
+ */
+struct SweepConfig {
+    vector<double> p_values;           // BSC crossover probabilities to simulate
+    size_t frames_per_point = 100;     // frames simulated at every sweep point, at most
+    size_t min_frame_errors = 0;       // stop a point after this many frame errors, 0 disables
+    double target_relative_width = 0;  // stop once the interval width divided by the FER is below this, 0 disables
+    double seconds_per_point = 0;      // stop after this much worker time on a point, 0 disables
+    IntervalMethod interval = IntervalMethod::wilson;  // confidence interval of the results and the width criterion
+    double confidence = 0.95;          // confidence level of the intervals
+    size_t chunk_size = 16;            // frames per work item, each chunk has its own random stream
+    uint64_t seed = 1;                 // master seed, same seed gives the same results
+    unsigned n_threads = 0;            // worker threads, 0 uses all hardware threads
+    size_t batch_size = 0;             // decode chunks with the batch decoder, 0 decodes frame by frame
+    bool collect_statistics = false;   // fill SweepPointResult::statistics, decodes frame by frame
+    size_t shard_index = 0;            // run only the chunks c with c % shard_count == shard_index,
+    size_t shard_count = 1;            // see merge_sweep_shards
+    DecoderConfig decoder;
+};
+
+
+/**
+ * @brief the criterion that ended a sweep point
+ */
+enum class StopReason {
+    max_frames,                        // frames_per_point frames simulated
+    min_errors,                        // min_frame_errors frame errors seen
+    interval_width,                    // confidence interval narrow enough
+    time_budget                        // seconds_per_point used up
+};
+
+
+/**
+ * @brief result of one sweep point
+ */
+struct SweepPointResult {
+    double p{};                        // BSC crossover probability
+    size_t frames{};                   // frames simulated
+    size_t successes{};                // frames decoded to the right word
+    double fer{};                      // frame error rate
+    double fer_low{};                  // confidence interval of the frame error rate
+    double fer_high{};
+    double seconds{};                  // worker time spent on the point
+    StopReason stop_reason = StopReason::max_frames;
+    double syndrome_bits{};            // mean syndrome bits per frame, below the rows of the code if rate-adaptive
+    DecoderStatisticsSummary statistics;  // iterations, terminations and phase times, with collect_statistics
+    vector<size_t> chunk_successes;    // successes of the counted chunks, in order (the own chunks of a shard)
+    vector<uint64_t> chunk_syndrome_bits;  // syndrome bits of the counted chunks, in order
+};
+
+
+/**
+ * @brief simulates all sweep points of the config on a pool of worker threads
+ *
+ * Every frame draws a random input, sends it over a BSC with crossover probability
+ * p and decodes it from the syndrome. Workers keep their own decoder workspace and
+ * take the next chunk of the running point with the fewest chunks handed out, so
+ * compute moves to the points that are still running. A point stops at the first
+ * prefix of its chunks, in chunk order, that meets a stopping criterion; chunks
+ * finished past it are dropped. The results thus only depend on the seed, unless
+ * the time budget is what stops a point.
+ * @param code the LDPC code, shared read-only by all workers
+ * @param config sweep parameters
+ * @return one result per entry of config.p_values
+ */
+vector<SweepPointResult> run_fer_sweep(const LdpcCode &code, const SweepConfig &config);
+
+
+/**
+ * @brief one point of a grid sweep: a code, a crossover probability and a decoder mode
+ */
+struct GridJob {
+    size_t code{};                     // index into the codes of the grid
+    double p{};                        // BSC crossover probability
+    DecoderConfig decoder;             // decoder mode and iteration cap
+    size_t stream{};                   // random stream, jobs with the same stream decode the same frames
+    const RateAdaptiveCode *rate_adaptive = nullptr;  // rate steps of the code to decode with
+                                       // decode_rate_adaptive, nullptr decodes at the rate of the code
+};
+
+
+/**
+ * @brief simulates the jobs of a grid over several codes on one pool of worker threads
+ *
+ * Works like run_fer_sweep with one point per job, run_fer_sweep is the grid of a
+ * single code and decoder. Workers take the next chunk of the running job with the
+ * fewest chunks handed out, whatever its code, so all threads stay busy until the
+ * last job stops instead of waiting for the slowest code or the longest point. Every
+ * worker keeps one decoder workspace per code, the codes themselves are shared.
+ * Jobs with the same stream draw the same frames, so decoders compared at one code
+ * and p see identical channel realizations; point i of run_fer_sweep is stream i.
+ * @param codes the LDPC codes, shared read-only by all workers
+ * @param jobs the points to simulate
+ * @param config sweep parameters, p_values and decoder are ignored in favor of the jobs
+ * @return one result per job
+ */
+vector<SweepPointResult> run_grid_sweep(const vector<const LdpcCode *> &codes,
+                                        const vector<GridJob> &jobs,
+                                        const SweepConfig &config);
+
+
+/**
+ * @brief combines the results of the shards of a sweep into those of the whole sweep
+ *
+ * A shard (config.shard_count > 1) simulates every shard_count-th chunk of each point
+ * with the same random streams as a single run, so the shards never share a frame
+ * and need no coordination. A shard stops a point early only on min_frame_errors of
+ * its own chunks, which the merged prefix reaches no later. The merge replays the
+ * stopping rule over the chunks of all shards in chunk order, so frames, successes,
+ * intervals and stop reasons equal those of one process running the whole sweep.
+ * The time budget can't be sharded.
+ * @param config sweep parameters of the shards, shard_index and shard_count are ignored
+ * @param shards the results of shard 0 to N - 1, one result per point each
+ * @return one result per point, seconds is the time of all shards
+ */
+vector<SweepPointResult> merge_sweep_shards(const SweepConfig &config,
+                                            const vector<vector<SweepPointResult>> &shards);
+
+
+/**
+ * @brief name of a stop reason, for printing
+ * @param reason the reason
+ * @return the name
+ */
+const char *stop_reason_name(StopReason reason);
+
+/**
+ * @brief FER of the floating point and the fixed-point decoder at one sweep point
+ */
+struct QuantizationLossPoint {
+    double p{};                        // BSC crossover probability
+    double fer_float{};                // frame error rate with config.decoder
+    double fer_fixed{};                // frame error rate with the fixed-point decoder
+};
+
+
+/**
+ * @brief compares the fixed-point decoder against the floating point decoder
+ *
+ * Runs the sweep twice with the same seed, so both decoders see exactly the same
+ * frames and the difference of the frame error rates is the quantization loss.
+ * @param code the LDPC code
+ * @param config sweep parameters, config.decoder is the floating point reference
+ * @param fixed_bits message width of the fixed-point decoder
+ * @param fixed_frac_bits fractional bits of the fixed-point decoder
+ * @return one entry per entry of config.p_values
+ */
+vector<QuantizationLossPoint> quantization_loss(const LdpcCode &code,
+                                                const SweepConfig &config,
+                                                int fixed_bits,
+                                                int fixed_frac_bits);
+
+
+/**
+ * @brief parameters of a weight-stratified FER sweep
+ */
+struct StratifiedSweepConfig {
+    SweepConfig sweep;                 // p_values are the target probabilities, interval and confidence
+                                       // apply, frames_per_point and the stopping criteria are unused
+    size_t frames_per_weight = 1000;   // frames decoded per error weight
+    size_t min_weight = 1;             // smallest simulated weight, lighter frames are assumed to decode
+    size_t max_weight = 0;             // largest simulated weight, 0 picks it from tail_mass
+    double tail_mass = 1e-12;          // binomial mass of the largest p left above max_weight
+    double design_p = 0;               // crossover probability of the decoder LLRs, 0 uses the middle of p_values
+};
+
+
+/**
+ * @brief decoding statistics of the frames with one error weight
+ */
+struct WeightStratum {
+    size_t weight{};                   // number of errors in every frame
+    size_t frames{};                   // frames decoded
+    size_t failures{};                 // frames not decoded to the right word
+    double fer{};                      // conditional frame error rate
+    double fer_low{};                  // confidence interval of the conditional frame error rate
+    double fer_high{};
+};
+
+
+/**
+ * @brief FER at one crossover probability, combined from the strata
+ */
+struct StratifiedPointResult {
+    double p{};                        // BSC crossover probability
+    double fer{};                      // frame error rate estimate
+    double fer_low{};                  // confidence interval, conservative sum of the stratum intervals
+    double fer_high{};
+    double unsimulated_mass{};         // probability of an error weight without a stratum
+};
+
+
+/**
+ * @brief result of a stratified sweep
+ */
+struct StratifiedSweepResult {
+    double design_p{};                 // crossover probability the LLRs were computed with
+    vector<WeightStratum> strata;      // one per simulated weight, ascending
+    vector<StratifiedPointResult> points;  // one per entry of config.sweep.p_values
+};
+
+
+/**
+ * @brief decodes frames at fixed error weights and combines them into FER curves
+ *
+ * Every weight from min_weight to max_weight gets frames_per_weight frames with
+ * exactly that many errors at uniformly random positions, spread over the thread
+ * pool like run_fer_sweep. All frames are decoded with the LLRs of a BSC with
+ * crossover design_p, so the curves are those of a decoder tuned to design_p,
+ * which only matters for rules that are not scale invariant (sum-product, offset
+ * min-sum) and is negligible across a typical sweep range.
+ * @param code the LDPC code, shared read-only by all workers
+ * @param config parameters of the stratified sweep
+ * @return the strata and one combined result per entry of config.sweep.p_values
+ */
+StratifiedSweepResult run_stratified_sweep(const LdpcCode &code, const StratifiedSweepConfig &config);
+
+
+/**
+ * @brief FER at crossover probability p from decoded strata
+ *
+ * Weights below the first stratum count as decoded and weights above the last one
+ * as failed, the interval is widened by the probability of those weights.
+ * @param strata the strata, sorted by weight without gaps
+ * @param n_bits frame length
+ * @param p crossover probability
+ * @return the combined estimate
+ */
+StratifiedPointResult combine_strata(const vector<WeightStratum> &strata, size_t n_bits, double p);
+
+#endif //INFORMATION_THEORY_SWEEP_H